@@ -34,6 +34,7 @@
 #include "cc-list-row-info-button.h"
 #include "cc-list-row.h"
 #include "cc-default-apps-page.h"
+#include "cc-permission-store.h"
 #include "cc-removable-media-settings.h"
 #include "cc-applications-resources.h"
 #ifdef HAVE_SNAP
@@ -42,6 +43,7 @@
 #endif
 #include "cc-util.h"
 #include "globs.h"
+#include "mime-index.h"
 #include "search.h"
 #include "utils.h"
 
@@ -51,6 +53,20 @@
 
 #define PORTAL_SNAP_PREFIX "snap."
 
+/* The permission store entries shown in the panel, as table and id */
+static const gchar * const permission_store_entries[] = {
+  "notifications", "notification",
+  "background", "background",
+  "wallpaper", "wallpaper",
+  "screenshot", "screenshot",
+  "gnome", "shortcuts-inhibitor",
+  "devices", "microphone",
+  "devices", "speakers",
+  "devices", "camera",
+  "location", "location",
+  NULL
+};
+
 struct _CcApplicationsPanel
 {
   CcPanel          parent;
@@ -78,9 +94,11 @@ struct _CcApplicationsPanel
 
   gchar           *current_app_id;
   GAppInfo        *current_app_info;
+  GCancellable    *storage_cancellable;
   gchar           *current_portal_app_id;
 
   GHashTable      *globs;
+  MimeIndex       *mime_index;
   GHashTable      *search_providers;
 
   GtkImage        *app_icon_image;
@@ -90,7 +108,8 @@ struct _CcApplicationsPanel
   AdwBanner       *sandbox_banner;
   GtkWidget       *sandbox_info_button;
 
-  GDBusProxy      *perm_store;
+  CcPermissionStore *perm_store;
+  gboolean        perm_store_ready;
   GSettings       *media_handling_settings;
   GtkListBoxRow   *perm_store_pending_row;
   GSettings       *notification_settings;
@@ -200,28 +219,10 @@ get_portal_permissions (CcApplicationsPanel *self,
                         const gchar         *id,
                         const gchar         *app_id)
 {
-  g_autoptr(GVariant) ret = NULL;
-  g_autoptr(GVariantIter) iter = NULL;
-  const gchar *key = NULL;
-  GStrv val;
-  GStrv result = NULL;
-
-  ret = g_dbus_proxy_call_sync (self->perm_store,
-                                "Lookup",
-                                g_variant_new ("(ss)", table, id),
-                                0, G_MAXINT, NULL, NULL);
-  if (ret == NULL)
+  if (self->perm_store == NULL)
     return NULL;
 
-  g_variant_get (ret, "(a{sas}v)", &iter, NULL);
-
-  while (g_variant_iter_loop (iter, "{&s^a&s}", &key, &val))
-    {
-      if (strcmp (key, app_id) == 0 && result == NULL)
-        result = g_strdupv (val);
-    }
-
-  return result;
+  return g_strdupv ((gchar **) cc_permission_store_get (self->perm_store, table, id, app_id));
 }
 
 static void
@@ -231,17 +232,13 @@ set_portal_permissions (CcApplicationsPanel *self,
                         const gchar *app_id,
                         const gchar * const *permissions)
 {
-  g_autoptr(GError) error = NULL;
+  if (self->perm_store == NULL)
+    {
+      g_warning ("Can't set portal permissions, the permission store isn't available");
+      return;
+    }
 
-  g_dbus_proxy_call_sync (self->perm_store,
-                          "SetPermission",
-                          g_variant_new ("(sbss^as)", table, TRUE, id, app_id, permissions),
-                          0,
-                          G_MAXINT,
-                          NULL,
-                          &error);
-  if (error)
-    g_warning ("Error setting portal permissions: %s", error->message);
+  cc_permission_store_set (self->perm_store, table, id, app_id, permissions);
 }
 
 static gchar *
@@ -1026,6 +1023,7 @@ unset_cb (CcApplicationsPanel *self,
   type = (const gchar *)g_object_get_data (G_OBJECT (button), "type");
 
   g_app_info_remove_supports_type (self->current_app_info, type, NULL);
+  mime_index_reload_associations (self->mime_index);
   update_handler_dialog (self, self->current_app_info);
 }
 
@@ -1069,6 +1067,9 @@ add_file_type (CcApplicationsPanel *self,
   GtkWidget *button;
   GtkWidget *row;
 
+  if (self->globs == NULL)
+    self->globs = parse_globs ();
+
   glob = g_hash_table_lookup (self->globs, type);
 
   desc = g_content_type_get_description (type);
@@ -1105,27 +1106,17 @@ add_handler_row (CcApplicationsPanel *self,
 }
 
 static gboolean
-app_info_recommended_for (GAppInfo    *info,
-                          const gchar *type)
+app_info_recommended_for (CcApplicationsPanel *self,
+                          GAppInfo            *info,
+                          const gchar         *type)
 {
-  /* this is horribly inefficient. I blame the mime system */
-  g_autolist(GObject) list = NULL;
-  GList *l;
-  gboolean ret = FALSE;
-
-  list = g_app_info_get_recommended_for_type (type);
-  for (l = list; l; l = l->next)
-    {
-      GAppInfo *ri = l->data;
+  const gchar *id;
 
-      if (g_app_info_equal (info, ri))
-        {
-          ret = TRUE;
-          break;
-        }
-    }
+  id = g_app_info_get_id (info);
+  if (id == NULL)
+    return FALSE;
 
-  return ret;
+  return mime_index_is_recommended (self->mime_index, type, id);
 }
 
 static void
@@ -1193,7 +1184,7 @@ update_handler_dialog (CcApplicationsPanel *self,
       if (g_hash_table_contains (hash, ctype))
         continue;
 
-      if (!app_info_recommended_for (info, ctype))
+      if (!app_info_recommended_for (self, info, ctype))
         {
           gtk_widget_set_sensitive (GTK_WIDGET (self->handler_reset), TRUE);
           continue;
@@ -1310,7 +1301,7 @@ update_cache_row (CcApplicationsPanel *self,
 
   adw_action_row_set_subtitle (self->storage_page_cache_row, "…");
 
-  file_size_async (dir, cc_panel_get_cancellable (CC_PANEL (self)), set_cache_size, self);
+  file_size_async (dir, self->storage_cancellable, set_cache_size, self);
 }
 
 static void
@@ -1345,7 +1336,7 @@ update_data_row (CcApplicationsPanel *self,
 
   adw_action_row_set_subtitle (self->storage_page_data_row, "…");
 
-  file_size_async (dir, cc_panel_get_cancellable (CC_PANEL (self)), set_data_size, self);
+  file_size_async (dir, self->storage_cancellable, set_data_size, self);
 }
 
 static void
@@ -1401,6 +1392,11 @@ update_app_sizes (CcApplicationsPanel *self,
 {
   gtk_widget_set_sensitive (GTK_WIDGET (self->clear_cache_button_row), FALSE);
 
+  /* Stop scanning the directories of the previous app */
+  g_cancellable_cancel (self->storage_cancellable);
+  g_clear_object (&self->storage_cancellable);
+  self->storage_cancellable = g_cancellable_new ();
+
   self->app_size = self->data_size = self->cache_size = 0;
 
   update_app_row (self, app_id);
@@ -1435,7 +1431,7 @@ update_panel (CcApplicationsPanel *self,
 {
   GAppInfo *info;
 
-  if (self->perm_store == NULL)
+  if (!self->perm_store_ready)
     {
       /* Async permission store not initialized, row will be re-activated in the callback */
       self->perm_store_pending_row = row;
@@ -1505,6 +1501,7 @@ populate_applications (CcApplicationsPanel *self)
 #endif
 
   infos = g_app_info_get_all ();
+  mime_index_update (self->mime_index, infos);
 
   for (l = infos; l; l = l->next)
     {
@@ -1567,6 +1564,10 @@ app_filter_changed_cb (MctAppFilter        *app_filter,
 static void
 apps_changed (CcApplicationsPanel *self)
 {
+  /* Installing an application can also add MIME types */
+  g_clear_pointer (&self->globs, g_hash_table_unref);
+
+  /* This also reindexes the applications whose types changed */
   populate_applications (self);
 }
 
@@ -1583,19 +1584,21 @@ on_perm_store_ready (GObject      *source_object,
                      gpointer      data)
 {
   CcApplicationsPanel *self = data;
-  GDBusProxy *proxy;
+  CcPermissionStore *store;
   g_autoptr(GError) error = NULL;
 
-  proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
-  if (proxy == NULL)
-    {
-      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-          g_warning ("Failed to connect to portal permission store: %s",
-                     error->message);
-      return;
-    }
+  store = cc_permission_store_new_finish (res, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
 
-  self->perm_store = proxy;
+  /* Without the permission store, the portal permissions are simply
+   * not shown, the rest of the app page still needs to be filled */
+  if (store == NULL)
+    g_warning ("Failed to connect to portal permission store: %s",
+               error->message);
+
+  self->perm_store = store;
+  self->perm_store_ready = TRUE;
 
   if (self->perm_store_pending_row)
     g_signal_emit_by_name (self->perm_store_pending_row, "activate");
@@ -1693,6 +1696,10 @@ cc_applications_panel_dispose (GObject *object)
   g_clear_object (&self->monitor);
   g_clear_object (&self->perm_store);
 
+  g_cancellable_cancel (self->storage_cancellable);
+  g_clear_object (&self->storage_cancellable);
+  file_size_clear_cache ();
+
   G_OBJECT_CLASS (cc_applications_panel_parent_class)->dispose (object);
 }
 
@@ -1720,6 +1727,7 @@ cc_applications_panel_finalize (GObject *object)
   g_clear_pointer (&self->current_app_id, g_free);
   g_clear_pointer (&self->current_portal_app_id, g_free);
   g_clear_pointer (&self->globs, g_hash_table_unref);
+  g_clear_pointer (&self->mime_index, mime_index_free);
   g_clear_pointer (&self->search_providers, g_hash_table_unref);
 
   G_OBJECT_CLASS (cc_applications_panel_parent_class)->finalize (object);
@@ -1909,6 +1917,9 @@ cc_applications_panel_init (CcApplicationsPanel *self)
   self->search_settings = g_settings_new ("org.gnome.desktop.search-providers");
   self->media_handling_settings = g_settings_new ("org.gnome.desktop.media-handling");
 
+  /* Filled in by populate_applications() */
+  self->mime_index = mime_index_new ();
+
   g_settings_bind (self->media_handling_settings,
                    "autorun-never",
                    self->autorun_never_row,
@@ -1945,16 +1956,10 @@ cc_applications_panel_init (CcApplicationsPanel *self)
   self->monitor = g_app_info_monitor_get ();
   self->monitor_id = g_signal_connect_object (self->monitor, "changed", G_CALLBACK (apps_changed), self, G_CONNECT_SWAPPED);
 
-  g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
-                            G_DBUS_PROXY_FLAGS_NONE,
-                            NULL,
-                            "org.freedesktop.impl.portal.PermissionStore",
-                            "/org/freedesktop/impl/portal/PermissionStore",
-                            "org.freedesktop.impl.portal.PermissionStore",
-                            cc_panel_get_cancellable (CC_PANEL (self)),
-                            on_perm_store_ready,
-                            self);
-
-  self->globs = parse_globs ();
+  cc_permission_store_new_async (permission_store_entries,
+                                 cc_panel_get_cancellable (CC_PANEL (self)),
+                                 on_perm_store_ready,
+                                 self);
+
   self->search_providers = parse_search_providers ();
 }
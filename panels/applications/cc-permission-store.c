@@ -0,0 +1,392 @@
+/* cc-permission-store.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "cc-permission-store"
+
+#include "cc-permission-store.h"
+
+/*
+ * A copy of some entries of the portal permission store, so that the
+ * permissions of any app can be read without a D-Bus round trip.
+ *
+ * Each entry, identified by a table and an id, holds the permissions of
+ * every app. They are all looked up once, when the store is created,
+ * and kept up to date with the Changed signal of the permission store.
+ * Permissions set through cc_permission_store_set() are applied to the
+ * copy right away, and written asynchronously.
+ */
+
+struct _CcPermissionStore
+{
+  GObject     parent;
+
+  GDBusProxy *proxy;
+  GHashTable *entries; /* "table\nid" → (app id → GStrv) */
+};
+
+G_DEFINE_TYPE (CcPermissionStore, cc_permission_store, G_TYPE_OBJECT)
+
+static gchar *
+get_entry_key (const gchar *table,
+               const gchar *id)
+{
+  return g_strconcat (table, "\n", id, NULL);
+}
+
+static GHashTable *
+new_app_permissions (void)
+{
+  return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_strfreev);
+}
+
+/* Replaces the permissions of an entry with @permissions, of type a{sas} */
+static void
+update_entry (CcPermissionStore *self,
+              const gchar       *key,
+              GVariant          *permissions)
+{
+  GHashTable *app_permissions;
+  GVariantIter iter;
+  gchar *app_id;
+  GStrv value;
+
+  app_permissions = new_app_permissions ();
+
+  if (permissions)
+    {
+      g_variant_iter_init (&iter, permissions);
+      while (g_variant_iter_next (&iter, "{s^as}", &app_id, &value))
+        g_hash_table_replace (app_permissions, app_id, value);
+    }
+
+  g_hash_table_replace (self->entries, g_strdup (key), app_permissions);
+}
+
+static void
+on_proxy_signal_cb (CcPermissionStore *self,
+                    const gchar       *sender_name,
+                    const gchar       *signal_name,
+                    GVariant          *parameters)
+{
+  g_autoptr(GVariant) permissions = NULL;
+  g_autofree gchar *key = NULL;
+  const gchar *table;
+  const gchar *id;
+  gboolean deleted;
+
+  if (g_strcmp0 (signal_name, "Changed") != 0 ||
+      !g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(ssbva{sas})")))
+    return;
+
+  g_variant_get (parameters, "(&s&sbv@a{sas})", &table, &id, &deleted, NULL, &permissions);
+
+  key = get_entry_key (table, id);
+  if (!g_hash_table_contains (self->entries, key))
+    return;
+
+  g_debug ("Permissions of %s/%s changed", table, id);
+
+  update_entry (self, key, deleted ? NULL : permissions);
+}
+
+static void
+cc_permission_store_finalize (GObject *object)
+{
+  CcPermissionStore *self = CC_PERMISSION_STORE (object);
+
+  g_clear_object (&self->proxy);
+  g_clear_pointer (&self->entries, g_hash_table_unref);
+
+  G_OBJECT_CLASS (cc_permission_store_parent_class)->finalize (object);
+}
+
+static void
+cc_permission_store_class_init (CcPermissionStoreClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = cc_permission_store_finalize;
+}
+
+static void
+cc_permission_store_init (CcPermissionStore *self)
+{
+  self->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+}
+
+/* Creation */
+
+typedef struct
+{
+  CcPermissionStore *self;
+  GStrv              entries;
+  guint              n_pending;
+  GError            *error;
+} LoadData;
+
+typedef struct
+{
+  GTask *task;
+  gchar *key;
+} Lookup;
+
+static void
+load_data_free (LoadData *data)
+{
+  g_clear_object (&data->self);
+  g_strfreev (data->entries);
+  g_clear_error (&data->error);
+  g_free (data);
+}
+
+static void
+lookup_cb (GObject      *source_object,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  Lookup *lookup = user_data;
+  g_autoptr(GTask) task = lookup->task;
+  g_autofree gchar *key = lookup->key;
+  g_autoptr(GVariant) ret = NULL;
+  g_autoptr(GVariant) permissions = NULL;
+  g_autoptr(GError) error = NULL;
+  LoadData *data = g_task_get_task_data (task);
+
+  g_free (lookup);
+
+  ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (source_object), result, &error);
+  if (ret)
+    {
+      g_variant_get (ret, "(@a{sas}v)", &permissions, NULL);
+      update_entry (data->self, key, permissions);
+    }
+  else if (g_dbus_error_is_remote_error (error))
+    {
+      g_debug ("No permissions in %s: %s", key, error->message); /* The entry doesn't exist yet */
+      update_entry (data->self, key, NULL);
+    }
+  else if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      if (!data->error)
+        data->error = g_steal_pointer (&error);
+    }
+  else
+    {
+      /* Leave the entry out, so that it's reported as not loaded */
+      g_warning ("Failed to load the permissions in %s: %s", key, error->message);
+    }
+
+  if (--data->n_pending > 0)
+    return;
+
+  if (data->error)
+    g_task_return_error (task, g_steal_pointer (&data->error));
+  else
+    g_task_return_pointer (task, g_object_ref (data->self), g_object_unref);
+}
+
+static void
+proxy_ready_cb (GObject      *source_object,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  LoadData *data = g_task_get_task_data (task);
+  GDBusProxy *proxy;
+  gsize i;
+
+  proxy = g_dbus_proxy_new_for_bus_finish (result, &error);
+  if (!proxy)
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  data->self = g_object_new (CC_TYPE_PERMISSION_STORE, NULL);
+  data->self->proxy = proxy;
+
+  g_signal_connect_object (proxy, "g-signal", G_CALLBACK (on_proxy_signal_cb), data->self, G_CONNECT_SWAPPED);
+
+  /* Each entry holds the permissions of all apps, so a single
+   * Lookup per entry is needed */
+  for (i = 0; data->entries[i] != NULL && data->entries[i + 1] != NULL; i += 2)
+    {
+      Lookup *lookup;
+
+      lookup = g_new0 (Lookup, 1);
+      lookup->task = g_object_ref (task);
+      lookup->key = get_entry_key (data->entries[i], data->entries[i + 1]);
+      data->n_pending++;
+
+      g_dbus_proxy_call (proxy,
+                         "Lookup",
+                         g_variant_new ("(ss)", data->entries[i], data->entries[i + 1]),
+                         G_DBUS_CALL_FLAGS_NONE,
+                         -1,
+                         g_task_get_cancellable (task),
+                         lookup_cb,
+                         lookup);
+    }
+
+  if (data->n_pending == 0)
+    g_task_return_pointer (task, g_object_ref (data->self), g_object_unref);
+}
+
+/**
+ * cc_permission_store_new_async:
+ * @entries: the entries to load, as pairs of table and id
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: the function to call when the store is ready
+ * @user_data: user data for @callback
+ *
+ * Connects to the portal permission store, and loads the permissions of
+ * every app for each of @entries, a %NULL-terminated array holding a
+ * table followed by an id, e.g. { "devices", "camera", NULL }.
+ * Entries that fail to load are left out, the store is still created.
+ */
+void
+cc_permission_store_new_async (const gchar * const *entries,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  LoadData *data;
+
+  g_return_if_fail (entries != NULL);
+
+  data = g_new0 (LoadData, 1);
+  data->entries = g_strdupv ((gchar **) entries);
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_permission_store_new_async);
+  g_task_set_task_data (task, data, (GDestroyNotify) load_data_free);
+
+  g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
+                            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+                            NULL,
+                            "org.freedesktop.impl.portal.PermissionStore",
+                            "/org/freedesktop/impl/portal/PermissionStore",
+                            "org.freedesktop.impl.portal.PermissionStore",
+                            cancellable,
+                            proxy_ready_cb,
+                            g_steal_pointer (&task));
+}
+
+CcPermissionStore *
+cc_permission_store_new_finish (GAsyncResult  *result,
+                                GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == cc_permission_store_new_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/* Access */
+
+/**
+ * cc_permission_store_get:
+ * @self: a #CcPermissionStore
+ * @table: the table of the entry
+ * @id: the id of the entry
+ * @app_id: the app to get the permissions of
+ *
+ * Returns: (nullable) (transfer none): the permissions of @app_id, or
+ *   %NULL if it has none, or if the entry wasn't loaded.
+ */
+const gchar * const *
+cc_permission_store_get (CcPermissionStore *self,
+                         const gchar       *table,
+                         const gchar       *id,
+                         const gchar       *app_id)
+{
+  g_autofree gchar *key = NULL;
+  GHashTable *app_permissions;
+
+  g_return_val_if_fail (CC_IS_PERMISSION_STORE (self), NULL);
+  g_return_val_if_fail (table != NULL && id != NULL && app_id != NULL, NULL);
+
+  key = get_entry_key (table, id);
+  app_permissions = g_hash_table_lookup (self->entries, key);
+  if (!app_permissions)
+    {
+      g_debug ("Permissions of %s/%s weren't loaded", table, id);
+      return NULL;
+    }
+
+  return g_hash_table_lookup (app_permissions, app_id);
+}
+
+static void
+set_permission_cb (GObject      *source_object,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+  g_autoptr(GVariant) ret = NULL;
+  g_autoptr(GError) error = NULL;
+
+  ret = g_dbus_proxy_call_finish (G_DBUS_PROXY (source_object), result, &error);
+  if (!ret)
+    g_warning ("Error setting portal permissions: %s", error->message);
+}
+
+/**
+ * cc_permission_store_set:
+ * @self: a #CcPermissionStore
+ * @table: the table of the entry
+ * @id: the id of the entry
+ * @app_id: the app to set the permissions of
+ * @permissions: the new permissions
+ *
+ * Sets the permissions of @app_id, creating the entry if needed. The
+ * permissions are returned by cc_permission_store_get() immediately,
+ * and written to the permission store in the background.
+ */
+void
+cc_permission_store_set (CcPermissionStore   *self,
+                         const gchar         *table,
+                         const gchar         *id,
+                         const gchar         *app_id,
+                         const gchar * const *permissions)
+{
+  g_autofree gchar *key = NULL;
+  GHashTable *app_permissions;
+
+  g_return_if_fail (CC_IS_PERMISSION_STORE (self));
+  g_return_if_fail (table != NULL && id != NULL && app_id != NULL);
+  g_return_if_fail (permissions != NULL);
+
+  key = get_entry_key (table, id);
+  app_permissions = g_hash_table_lookup (self->entries, key);
+  if (app_permissions)
+    g_hash_table_replace (app_permissions, g_strdup (app_id), g_strdupv ((gchar **) permissions));
+
+  g_dbus_proxy_call (self->proxy,
+                     "SetPermission",
+                     g_variant_new ("(sbss^as)", table, TRUE, id, app_id, permissions),
+                     G_DBUS_CALL_FLAGS_NONE,
+                     -1,
+                     NULL,
+                     set_permission_cb,
+                     NULL);
+}
@@ -0,0 +1,49 @@
+/* cc-permission-store.h
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define CC_TYPE_PERMISSION_STORE (cc_permission_store_get_type())
+G_DECLARE_FINAL_TYPE (CcPermissionStore, cc_permission_store, CC, PERMISSION_STORE, GObject)
+
+void                 cc_permission_store_new_async  (const gchar * const  *entries,
+                                                     GCancellable         *cancellable,
+                                                     GAsyncReadyCallback   callback,
+                                                     gpointer              user_data);
+
+CcPermissionStore   *cc_permission_store_new_finish (GAsyncResult         *result,
+                                                     GError              **error);
+
+const gchar * const *cc_permission_store_get        (CcPermissionStore    *self,
+                                                     const gchar          *table,
+                                                     const gchar          *id,
+                                                     const gchar          *app_id);
+
+void                 cc_permission_store_set        (CcPermissionStore    *self,
+                                                     const gchar          *table,
+                                                     const gchar          *id,
+                                                     const gchar          *app_id,
+                                                     const gchar * const  *permissions);
+
+G_END_DECLS
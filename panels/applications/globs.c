@@ -20,42 +20,88 @@
 
 #include <config.h>
 
+#include <string.h>
+
 #include "globs.h"
 
-/* parse mime/globs and return a string->string hash table */
+static void
+parse_globs_file (GHashTable  *patterns,
+                  const gchar *dir)
+{
+  g_autofree gchar *file = g_build_filename (dir, "mime", "globs", NULL);
+  g_autofree gchar *contents = NULL;
+  gchar *line, *next;
+
+  if (!g_file_get_contents (file, &contents, NULL, NULL))
+    return;
+
+  /* Lines are "type:pattern", split in place */
+  for (line = contents; line != NULL; line = next)
+    {
+      GPtrArray *type_patterns;
+      gchar *pattern;
+      guint i;
+
+      next = strchr (line, '\n');
+      if (next != NULL)
+        *next++ = '\0';
+
+      if (line[0] == '#' || line[0] == '\0')
+        continue;
+
+      pattern = strchr (line, ':');
+      if (pattern == NULL)
+        continue;
+      *pattern++ = '\0';
+
+      type_patterns = g_hash_table_lookup (patterns, line);
+      if (type_patterns == NULL)
+        {
+          type_patterns = g_ptr_array_new_with_free_func (g_free);
+          g_hash_table_insert (patterns, g_strdup (line), type_patterns);
+        }
+
+      /* The same database is often installed in several data dirs */
+      for (i = 0; i < type_patterns->len; i++)
+        if (g_str_equal (g_ptr_array_index (type_patterns, i), pattern))
+          break;
+
+      if (i == type_patterns->len)
+        g_ptr_array_add (type_patterns, g_strdup (pattern));
+    }
+}
+
+/* parse mime/globs and return a mime type->patterns hash table, where
+ * patterns is a comma-separated list of every glob for the type */
 GHashTable *
 parse_globs (void)
 {
+  g_autoptr(GHashTable) patterns = NULL;
   GHashTable *globs;
+  GHashTableIter iter;
   const gchar * const *dirs;
+  gpointer key, value;
   gint i;
 
-  globs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  patterns = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
 
-  dirs = g_get_system_data_dirs ();
+  parse_globs_file (patterns, g_get_user_data_dir ());
 
+  dirs = g_get_system_data_dirs ();
   for (i = 0; dirs[i]; i++)
-    {
-      g_autofree gchar *file = g_build_filename (dirs[i], "mime", "globs", NULL);
-      g_autofree gchar *contents = NULL;
-
-      if (g_file_get_contents (file, &contents, NULL, NULL))
-        {
-          g_auto(GStrv) strv = NULL;
-          int i;
+    parse_globs_file (patterns, dirs[i]);
 
-          strv = g_strsplit (contents, "\n", 0);
-          for (i = 0; strv[i]; i++)
-            {
-              g_auto(GStrv) parts = NULL;
+  globs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 
-              if (strv[i][0] == '#' || strv[i][0] == '\0')
-                continue;
+  g_hash_table_iter_init (&iter, patterns);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GPtrArray *type_patterns = value;
 
-              parts = g_strsplit (strv[i], ":", 2);
-              g_hash_table_insert (globs, g_strdup (parts[0]), g_strdup (parts[1]));
-            }
-        }
+      g_ptr_array_add (type_patterns, NULL);
+      g_hash_table_insert (globs,
+                           g_strdup (key),
+                           g_strjoinv (", ", (gchar **) type_patterns->pdata));
     }
 
   return globs;
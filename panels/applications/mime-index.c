@@ -0,0 +1,311 @@
+/* mime-index.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <config.h>
+
+#include "mime-index.h"
+
+/*
+ * Reverse index of the applications recommended for each content type,
+ * which is what g_app_info_get_recommended_for_type() returns: the
+ * applications supporting the type, plus the "Added Associations" and
+ * minus the "Removed Associations" of the mimeapps.list files.
+ *
+ * The supported types are indexed from the desktop files in one pass,
+ * and only the applications whose types changed are reindexed on
+ * updates. The associations are small and simply read again.
+ */
+
+struct _MimeIndex
+{
+  GHashTable *app_types; /* app id → GStrv of the MIME types it supports */
+  GHashTable *supported; /* content type → set of app ids */
+  GHashTable *added;     /* content type → set of app ids */
+  GHashTable *removed;   /* content type → set of app ids */
+};
+
+static GHashTable *
+type_table_new (void)
+{
+  return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+}
+
+static void
+type_table_add (GHashTable  *table,
+                const gchar *content_type,
+                const gchar *app_id)
+{
+  GHashTable *ids;
+
+  ids = g_hash_table_lookup (table, content_type);
+  if (ids == NULL)
+    {
+      ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+      g_hash_table_insert (table, g_strdup (content_type), ids);
+    }
+
+  g_hash_table_add (ids, g_strdup (app_id));
+}
+
+static void
+type_table_remove (GHashTable  *table,
+                   const gchar *content_type,
+                   const gchar *app_id)
+{
+  GHashTable *ids;
+
+  ids = g_hash_table_lookup (table, content_type);
+  if (ids == NULL)
+    return;
+
+  g_hash_table_remove (ids, app_id);
+  if (g_hash_table_size (ids) == 0)
+    g_hash_table_remove (table, content_type);
+}
+
+static gboolean
+type_table_contains (GHashTable  *table,
+                     const gchar *content_type,
+                     const gchar *app_id)
+{
+  GHashTable *ids = g_hash_table_lookup (table, content_type);
+
+  return ids != NULL && g_hash_table_contains (ids, app_id);
+}
+
+static void
+index_app_types (MimeIndex           *index,
+                 const gchar         *app_id,
+                 const gchar * const *types,
+                 gboolean             add)
+{
+  gint i;
+
+  for (i = 0; types[i]; i++)
+    {
+      g_autofree gchar *ctype = g_content_type_from_mime_type (types[i]);
+
+      if (ctype == NULL)
+        continue;
+
+      if (add)
+        type_table_add (index->supported, ctype, app_id);
+      else
+        type_table_remove (index->supported, ctype, app_id);
+    }
+}
+
+MimeIndex *
+mime_index_new (void)
+{
+  MimeIndex *index;
+
+  index = g_new0 (MimeIndex, 1);
+  index->app_types = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_strfreev);
+  index->supported = type_table_new ();
+  index->added = type_table_new ();
+  index->removed = type_table_new ();
+
+  return index;
+}
+
+void
+mime_index_free (MimeIndex *index)
+{
+  g_clear_pointer (&index->app_types, g_hash_table_unref);
+  g_clear_pointer (&index->supported, g_hash_table_unref);
+  g_clear_pointer (&index->added, g_hash_table_unref);
+  g_clear_pointer (&index->removed, g_hash_table_unref);
+  g_free (index);
+}
+
+/* Reindexes the applications of @infos whose supported types changed,
+ * drops the ones not in @infos anymore, and reads the associations */
+void
+mime_index_update (MimeIndex *index,
+                   GList     *infos)
+{
+  static const gchar * const no_types[] = { NULL };
+  g_autoptr(GHashTable) seen = NULL;
+  GHashTableIter iter;
+  const gchar *app_id;
+  GStrv types;
+  GList *l;
+
+  seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (l = infos; l; l = l->next)
+    {
+      const gchar * const *new_types;
+      const gchar *id;
+      GStrv old_types;
+
+      id = g_app_info_get_id (l->data);
+      if (id == NULL)
+        continue;
+
+      new_types = (const gchar * const *) g_app_info_get_supported_types (l->data);
+      if (new_types == NULL)
+        new_types = no_types;
+
+      old_types = g_hash_table_lookup (index->app_types, id);
+      if (old_types == NULL || !g_strv_equal ((const gchar * const *) old_types, new_types))
+        {
+          if (old_types != NULL)
+            index_app_types (index, id, (const gchar * const *) old_types, FALSE);
+          index_app_types (index, id, new_types, TRUE);
+
+          g_hash_table_insert (index->app_types, g_strdup (id), g_strdupv ((GStrv) new_types));
+        }
+
+      g_hash_table_add (seen, (gpointer) id);
+    }
+
+  g_hash_table_iter_init (&iter, index->app_types);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &app_id, (gpointer *) &types))
+    {
+      if (g_hash_table_contains (seen, app_id))
+        continue;
+
+      index_app_types (index, app_id, (const gchar * const *) types, FALSE);
+      g_hash_table_iter_remove (&iter);
+    }
+
+  mime_index_reload_associations (index);
+}
+
+static void
+read_associations (MimeIndex   *index,
+                   const gchar *path)
+{
+  g_autoptr(GKeyFile) keyfile = NULL;
+  g_auto(GStrv) removed_types = NULL;
+  g_auto(GStrv) added_types = NULL;
+  gint i, j;
+
+  keyfile = g_key_file_new ();
+  if (!g_key_file_load_from_file (keyfile, path, G_KEY_FILE_NONE, NULL))
+    return;
+
+  /* A file's removals override the files it takes precedence over, and
+   * its own additions override its removals */
+  removed_types = g_key_file_get_keys (keyfile, "Removed Associations", NULL, NULL);
+  for (i = 0; removed_types && removed_types[i]; i++)
+    {
+      g_autofree gchar *ctype = g_content_type_from_mime_type (removed_types[i]);
+      g_auto(GStrv) ids = NULL;
+
+      ids = g_key_file_get_string_list (keyfile, "Removed Associations", removed_types[i], NULL, NULL);
+      for (j = 0; ctype && ids && ids[j]; j++)
+        {
+          type_table_remove (index->added, ctype, ids[j]);
+          type_table_add (index->removed, ctype, ids[j]);
+        }
+    }
+
+  added_types = g_key_file_get_keys (keyfile, "Added Associations", NULL, NULL);
+  for (i = 0; added_types && added_types[i]; i++)
+    {
+      g_autofree gchar *ctype = g_content_type_from_mime_type (added_types[i]);
+      g_auto(GStrv) ids = NULL;
+
+      ids = g_key_file_get_string_list (keyfile, "Added Associations", added_types[i], NULL, NULL);
+      for (j = 0; ctype && ids && ids[j]; j++)
+        {
+          type_table_remove (index->removed, ctype, ids[j]);
+          type_table_add (index->added, ctype, ids[j]);
+        }
+    }
+}
+
+static void
+add_mimeapps_paths (GPtrArray           *paths,
+                    const gchar         *dir,
+                    const gchar * const *desktops)
+{
+  gint i;
+
+  for (i = 0; desktops[i]; i++)
+    {
+      g_autofree gchar *basename = g_strdup_printf ("%s-mimeapps.list", desktops[i]);
+
+      g_ptr_array_add (paths, g_build_filename (dir, basename, NULL));
+    }
+
+  g_ptr_array_add (paths, g_build_filename (dir, "mimeapps.list", NULL));
+}
+
+/* Reads the associations of the mimeapps.list files again, which is
+ * enough after changing them with g_app_info_add_supports_type() and
+ * g_app_info_remove_supports_type() */
+void
+mime_index_reload_associations (MimeIndex *index)
+{
+  g_autoptr(GPtrArray) paths = NULL;
+  g_autofree gchar *lower_desktops = NULL;
+  g_autofree gchar *user_apps_dir = NULL;
+  g_auto(GStrv) desktops = NULL;
+  const gchar * const *dirs;
+  const gchar *current_desktop;
+  guint i;
+
+  g_hash_table_remove_all (index->added);
+  g_hash_table_remove_all (index->removed);
+
+  current_desktop = g_getenv ("XDG_CURRENT_DESKTOP");
+  lower_desktops = g_ascii_strdown (current_desktop ? current_desktop : "", -1);
+  desktops = g_strsplit (lower_desktops, ":", -1);
+
+  /* In order of precedence, as in the XDG MIME applications spec */
+  paths = g_ptr_array_new_with_free_func (g_free);
+
+  add_mimeapps_paths (paths, g_get_user_config_dir (), (const gchar * const *) desktops);
+  dirs = g_get_system_config_dirs ();
+  for (i = 0; dirs[i]; i++)
+    add_mimeapps_paths (paths, dirs[i], (const gchar * const *) desktops);
+
+  user_apps_dir = g_build_filename (g_get_user_data_dir (), "applications", NULL);
+  add_mimeapps_paths (paths, user_apps_dir, (const gchar * const *) desktops);
+  dirs = g_get_system_data_dirs ();
+  for (i = 0; dirs[i]; i++)
+    {
+      g_autofree gchar *dir = g_build_filename (dirs[i], "applications", NULL);
+      add_mimeapps_paths (paths, dir, (const gchar * const *) desktops);
+    }
+
+  for (i = paths->len; i > 0; i--)
+    read_associations (index, g_ptr_array_index (paths, i - 1));
+}
+
+/* Whether the application @app_id is among the ones
+ * g_app_info_get_recommended_for_type() returns for @content_type */
+gboolean
+mime_index_is_recommended (MimeIndex   *index,
+                           const gchar *content_type,
+                           const gchar *app_id)
+{
+  if (type_table_contains (index->added, content_type, app_id))
+    return TRUE;
+
+  if (type_table_contains (index->removed, content_type, app_id))
+    return FALSE;
+
+  return type_table_contains (index->supported, content_type, app_id);
+}
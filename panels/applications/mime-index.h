@@ -0,0 +1,44 @@
+/* mime-index.h
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _MimeIndex MimeIndex;
+
+MimeIndex* mime_index_new                     (void);
+
+void       mime_index_free                    (MimeIndex    *index);
+
+void       mime_index_update                  (MimeIndex    *index,
+                                               GList        *infos);
+
+void       mime_index_reload_associations     (MimeIndex    *index);
+
+gboolean   mime_index_is_recommended          (MimeIndex    *index,
+                                               const gchar  *content_type,
+                                               const gchar  *app_id);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MimeIndex, mime_index_free)
+
+G_END_DECLS
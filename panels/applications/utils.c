@@ -18,8 +18,8 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
-#ifndef _XOPEN_SOURCE
-#define _XOPEN_SOURCE 600
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
 #endif
 
 #include <config.h>
@@ -27,7 +27,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <ftw.h>
+#include <unistd.h>
 
 #include "utils.h"
 #ifdef HAVE_SNAP
@@ -79,18 +82,270 @@ file_remove_finish (GFile        *file,
   return g_task_propagate_boolean (G_TASK (result), error);
 }
 
-static GPrivate size_key = G_PRIVATE_INIT (g_free);
+/*
+ * Directory sizes are computed by several threads sharing a stack of
+ * directories to scan: each thread pops a directory, adds the blocks
+ * allocated to its entries, and pushes its subdirectories back, so
+ * that any idle thread can pick them up.
+ *
+ * The result of each directory, without its subdirectories, is kept
+ * until the panel goes away, and reused while the modification time of
+ * the directory doesn't change. Files rewritten in place don't change
+ * that time, so their new size is only noticed once something is added,
+ * removed or renamed in their directory. When that happens, the entries
+ * of the subdirectories that are gone are dropped with it.
+ */
 
-static gint
-ftw_size_cb (const gchar       *path,
-             const struct stat *sb,
-             gint               typeflags,
-             struct FTW        *ftwbuf)
+#define MAX_SIZE_THREADS 8
+
+/* How many entries are read between checks for cancellation */
+#define SIZE_CANCEL_CHECK_INTERVAL 1024
+
+typedef struct
 {
-  guint64 *size = (guint64*)g_private_get (&size_key);
-  if (typeflags == FTW_F)
-    *size += sb->st_size;
-  return 0;
+  gint64   mtime_ns;
+  guint64  size;    /* Allocated to the directory and its files */
+  GStrv    subdirs; /* Names of the subdirectories */
+} DirSizeEntry;
+
+static void
+dir_size_entry_free (DirSizeEntry *entry)
+{
+  g_strfreev (entry->subdirs);
+  g_free (entry);
+}
+
+G_LOCK_DEFINE_STATIC (dir_size_cache);
+static GHashTable *dir_size_cache = NULL; /* path → DirSizeEntry */
+
+static gboolean
+is_path_or_descendant (const gchar *path,
+                       const gchar *dir)
+{
+  gsize len = strlen (dir);
+
+  return strncmp (path, dir, len) == 0 && (path[len] == '\0' || path[len] == G_DIR_SEPARATOR);
+}
+
+/* Must be called with the cache locked */
+static void
+evict_removed_subdirs (const gchar  *path,
+                       DirSizeEntry *old_entry,
+                       GPtrArray    *subdir_names)
+{
+  GHashTableIter iter;
+  const gchar *key;
+  guint i, j;
+
+  for (i = 0; old_entry->subdirs[i] != NULL; i++)
+    {
+      g_autofree gchar *subdir = NULL;
+      gboolean found = FALSE;
+
+      for (j = 0; j < subdir_names->len && !found; j++)
+        found = g_str_equal (old_entry->subdirs[i], g_ptr_array_index (subdir_names, j));
+
+      if (found)
+        continue;
+
+      subdir = g_build_filename (path, old_entry->subdirs[i], NULL);
+
+      g_hash_table_iter_init (&iter, dir_size_cache);
+      while (g_hash_table_iter_next (&iter, (gpointer *) &key, NULL))
+        {
+          if (is_path_or_descendant (key, subdir))
+            g_hash_table_iter_remove (&iter);
+        }
+    }
+}
+
+typedef struct
+{
+  GMutex        lock;
+  GCond         cond;
+  GPtrArray    *queue;   /* Paths of the directories left to scan */
+  guint         n_busy;  /* Directories being scanned */
+  gboolean      cancelled;
+  guint64       total;
+  GCancellable *cancellable;
+} SizeScan;
+
+static inline guint64
+allocated_size (const struct stat *st)
+{
+  return (guint64) st->st_blocks * 512;
+}
+
+/* Returns whether @path could be fully scanned, with its size in @out_size
+ * and the paths of its subdirectories added to @subdirs */
+static gboolean
+scan_directory (SizeScan    *scan,
+                const gchar *path,
+                GPtrArray   *subdirs,
+                guint64     *out_size)
+{
+  g_autoptr(GPtrArray) subdir_names = NULL;
+  DirSizeEntry *entry;
+  struct dirent *dirent;
+  struct stat st;
+  guint64 size;
+  gint64 mtime_ns;
+  guint n_entries = 0;
+  guint i;
+  DIR *dir;
+  int fd;
+
+  *out_size = 0;
+
+  fd = openat (AT_FDCWD, path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (fd < 0)
+    return TRUE;
+
+  if (fstat (fd, &st) < 0)
+    {
+      close (fd);
+      return TRUE;
+    }
+
+  mtime_ns = (gint64) st.st_mtim.tv_sec * G_GINT64_CONSTANT (1000000000) + st.st_mtim.tv_nsec;
+
+  G_LOCK (dir_size_cache);
+  entry = dir_size_cache ? g_hash_table_lookup (dir_size_cache, path) : NULL;
+  if (entry && entry->mtime_ns == mtime_ns)
+    {
+      for (i = 0; entry->subdirs[i] != NULL; i++)
+        g_ptr_array_add (subdirs, g_build_filename (path, entry->subdirs[i], NULL));
+      *out_size = entry->size;
+
+      G_UNLOCK (dir_size_cache);
+      close (fd);
+      return TRUE;
+    }
+  G_UNLOCK (dir_size_cache);
+
+  dir = fdopendir (fd);
+  if (!dir)
+    {
+      close (fd);
+      return TRUE;
+    }
+
+  size = allocated_size (&st);
+  subdir_names = g_ptr_array_new_with_free_func (g_free);
+
+  while ((dirent = readdir (dir)) != NULL)
+    {
+      if (strcmp (dirent->d_name, ".") == 0 || strcmp (dirent->d_name, "..") == 0)
+        continue;
+
+      if (++n_entries % SIZE_CANCEL_CHECK_INTERVAL == 0 &&
+          g_cancellable_is_cancelled (scan->cancellable))
+        {
+          closedir (dir);
+          return FALSE;
+        }
+
+      /* Subdirectories count themselves when they are scanned */
+      if (dirent->d_type == DT_DIR)
+        {
+          g_ptr_array_add (subdir_names, g_strdup (dirent->d_name));
+          continue;
+        }
+
+      if (fstatat (dirfd (dir), dirent->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0)
+        continue;
+
+      if (S_ISDIR (st.st_mode))
+        g_ptr_array_add (subdir_names, g_strdup (dirent->d_name));
+      else
+        size += allocated_size (&st);
+    }
+
+  closedir (dir);
+
+  for (i = 0; i < subdir_names->len; i++)
+    g_ptr_array_add (subdirs, g_build_filename (path, g_ptr_array_index (subdir_names, i), NULL));
+
+  G_LOCK (dir_size_cache);
+  entry = dir_size_cache ? g_hash_table_lookup (dir_size_cache, path) : NULL;
+  if (entry)
+    evict_removed_subdirs (path, entry, subdir_names);
+  G_UNLOCK (dir_size_cache);
+
+  entry = g_new0 (DirSizeEntry, 1);
+  entry->mtime_ns = mtime_ns;
+  entry->size = size;
+  g_ptr_array_add (subdir_names, NULL);
+  entry->subdirs = (GStrv) g_ptr_array_free (g_steal_pointer (&subdir_names), FALSE);
+
+  G_LOCK (dir_size_cache);
+  if (!dir_size_cache)
+    dir_size_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) dir_size_entry_free);
+  g_hash_table_replace (dir_size_cache, g_strdup (path), entry);
+  G_UNLOCK (dir_size_cache);
+
+  *out_size = size;
+
+  return TRUE;
+}
+
+static gpointer
+size_scan_worker (gpointer data)
+{
+  SizeScan *scan = data;
+  guint64 size = 0;
+
+  g_mutex_lock (&scan->lock);
+
+  while (TRUE)
+    {
+      g_autoptr(GPtrArray) subdirs = NULL;
+      g_autofree gchar *path = NULL;
+      guint64 dir_size;
+      gboolean completed;
+
+      while (scan->queue->len == 0 && scan->n_busy > 0 && !scan->cancelled)
+        g_cond_wait (&scan->cond, &scan->lock);
+
+      if (scan->cancelled || scan->queue->len == 0)
+        break;
+
+      path = g_ptr_array_steal_index_fast (scan->queue, scan->queue->len - 1);
+      scan->n_busy++;
+
+      g_mutex_unlock (&scan->lock);
+
+      subdirs = g_ptr_array_new ();
+      completed = scan_directory (scan, path, subdirs, &dir_size);
+      size += dir_size;
+
+      if (completed && g_cancellable_is_cancelled (scan->cancellable))
+        completed = FALSE;
+
+      g_mutex_lock (&scan->lock);
+
+      scan->n_busy--;
+
+      if (!completed)
+        {
+          g_ptr_array_set_free_func (subdirs, g_free);
+          scan->cancelled = TRUE;
+          g_cond_broadcast (&scan->cond);
+          continue;
+        }
+
+      g_ptr_array_extend_and_steal (scan->queue, g_steal_pointer (&subdirs));
+
+      /* Wake up the idle threads if there is more work, or none at all */
+      if (scan->queue->len > 0 || scan->n_busy == 0)
+        g_cond_broadcast (&scan->cond);
+    }
+
+  scan->total += size;
+
+  g_mutex_unlock (&scan->lock);
+
+  return NULL;
 }
 
 static void
@@ -100,18 +355,47 @@ file_size_thread_func (GTask        *task,
                        GCancellable *cancellable)
 {
   GFile *file = source_object;
+  g_autoptr(GPtrArray) threads = NULL;
   g_autofree gchar *path = g_file_get_path (file);
-  guint64 *total;
+  g_autofree guint64 *total = NULL;
+  SizeScan scan = { 0 };
+  guint n_threads;
+  guint i;
+
+  if (path == NULL)
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                               "Not a local directory");
+      return;
+    }
+
+  g_mutex_init (&scan.lock);
+  g_cond_init (&scan.cond);
+  scan.queue = g_ptr_array_new_with_free_func (g_free);
+  scan.cancellable = cancellable;
+
+  g_ptr_array_add (scan.queue, g_steal_pointer (&path));
+
+  /* This thread is one of the workers */
+  n_threads = MIN (g_get_num_processors (), MAX_SIZE_THREADS);
+  threads = g_ptr_array_new_with_free_func ((GDestroyNotify) g_thread_join);
+  for (i = 1; i < n_threads; i++)
+    g_ptr_array_add (threads, g_thread_new ("file-size", size_scan_worker, &scan));
 
-  g_private_replace (&size_key, g_new0 (guint64, 1));
+  size_scan_worker (&scan);
+  g_clear_pointer (&threads, g_ptr_array_unref);
 
-  nftw (path, ftw_size_cb, 20, FTW_PHYS | FTW_DEPTH);
+  g_clear_pointer (&scan.queue, g_ptr_array_unref);
+  g_cond_clear (&scan.cond);
+  g_mutex_clear (&scan.lock);
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
 
   total = g_new0 (guint64, 1);
-  *total = *(guint64*)g_private_get (&size_key);
+  *total = scan.total;
 
-  if (g_task_set_return_on_cancel (task, FALSE))
-    g_task_return_pointer (task, total, g_free);
+  g_task_return_pointer (task, g_steal_pointer (&total), g_free);
 }
 
 void
@@ -121,10 +405,18 @@ file_size_async (GFile               *file,
                  gpointer             data)
 {
   g_autoptr(GTask) task = g_task_new (file, cancellable, callback, data);
-  g_task_set_return_on_cancel (task, TRUE);
   g_task_run_in_thread (task, file_size_thread_func);
 }
 
+/* Forgets the sizes of the directories scanned so far */
+void
+file_size_clear_cache (void)
+{
+  G_LOCK (dir_size_cache);
+  g_clear_pointer (&dir_size_cache, g_hash_table_destroy);
+  G_UNLOCK (dir_size_cache);
+}
+
 gboolean
 file_size_finish (GFile        *file,
                   GAsyncResult *result,
@@ -163,8 +455,8 @@ get_output_of (const gchar **argv)
   return g_steal_pointer (&output);
 }
 
-GKeyFile *
-get_flatpak_metadata (const gchar *app_id)
+static GKeyFile *
+spawn_flatpak_metadata (const gchar *app_id)
 {
   const gchar *argv[5] = { "flatpak", "info", "-m", "app", NULL };
   g_autofree gchar *data = NULL;
@@ -187,8 +479,8 @@ get_flatpak_metadata (const gchar *app_id)
   return g_steal_pointer (&keyfile);
 }
 
-guint64
-get_flatpak_app_size (const gchar *app_id)
+static guint64
+spawn_flatpak_app_size (const gchar *app_id)
 {
   const gchar *argv[5] = { "flatpak", "info", "-s", "app", NULL };
   g_autofree gchar *data = NULL;
@@ -223,6 +515,227 @@ get_flatpak_app_size (const gchar *app_id)
   return (guint64)(val * factor);
 }
 
+/*
+ * The metadata and installed size of Flatpak apps are read from their
+ * deployment in the installation, like flatpak does, rather than by
+ * spawning flatpak info. They are cached per app, and reused while the
+ * active commit of the app doesn't change.
+ *
+ * Only installations found through the usual paths and
+ * installations.d are looked at; apps in other installations still
+ * go through the flatpak command. This is only used from the main
+ * thread, so nothing is locked.
+ */
+
+/* FLATPAK_DEPLOY_DATA_GVARIANT_FORMAT: origin, commit, subpaths,
+ * installed size (big endian), metadata */
+#define FLATPAK_DEPLOY_DATA_FORMAT "(ssasta{sv})"
+
+typedef struct
+{
+  gchar    *deploy_dir;
+  gchar    *commit;
+  GKeyFile *metadata;
+  guint64   installed_size;
+} FlatpakAppInfo;
+
+static void
+flatpak_app_info_free (FlatpakAppInfo *app_info)
+{
+  g_free (app_info->deploy_dir);
+  g_free (app_info->commit);
+  g_clear_pointer (&app_info->metadata, g_key_file_unref);
+  g_free (app_info);
+}
+
+static GHashTable *flatpak_app_infos = NULL; /* app id → FlatpakAppInfo */
+
+static void
+add_configured_installations (GPtrArray *dirs)
+{
+  g_autofree gchar *config_dir = NULL;
+  g_autoptr(GDir) dir = NULL;
+  const gchar *name;
+
+  if (g_getenv ("FLATPAK_CONFIG_DIR"))
+    config_dir = g_build_filename (g_getenv ("FLATPAK_CONFIG_DIR"), "installations.d", NULL);
+  else
+    config_dir = g_build_filename (G_DIR_SEPARATOR_S "etc", "flatpak", "installations.d", NULL);
+
+  dir = g_dir_open (config_dir, 0, NULL);
+  if (!dir)
+    return;
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      g_autoptr(GKeyFile) keyfile = NULL;
+      g_autofree gchar *path = NULL;
+      g_auto(GStrv) groups = NULL;
+      gsize i;
+
+      if (!g_str_has_suffix (name, ".conf"))
+        continue;
+
+      path = g_build_filename (config_dir, name, NULL);
+      keyfile = g_key_file_new ();
+      if (!g_key_file_load_from_file (keyfile, path, G_KEY_FILE_NONE, NULL))
+        continue;
+
+      groups = g_key_file_get_groups (keyfile, NULL);
+      for (i = 0; groups[i] != NULL; i++)
+        {
+          gchar *installation_path;
+
+          if (!g_str_has_prefix (groups[i], "Installation "))
+            continue;
+
+          installation_path = g_key_file_get_string (keyfile, groups[i], "Path", NULL);
+          if (installation_path)
+            g_ptr_array_add (dirs, installation_path);
+        }
+    }
+}
+
+/* In the order flatpak info looks for apps */
+static const gchar * const *
+get_flatpak_installations (void)
+{
+  static GStrv installations = NULL;
+
+  if (installations == NULL)
+    {
+      g_autoptr(GPtrArray) dirs = g_ptr_array_new ();
+
+      if (g_getenv ("FLATPAK_USER_DIR"))
+        g_ptr_array_add (dirs, g_strdup (g_getenv ("FLATPAK_USER_DIR")));
+      else
+        g_ptr_array_add (dirs, g_build_filename (g_get_user_data_dir (), "flatpak", NULL));
+
+      if (g_getenv ("FLATPAK_SYSTEM_DIR"))
+        g_ptr_array_add (dirs, g_strdup (g_getenv ("FLATPAK_SYSTEM_DIR")));
+      else
+        g_ptr_array_add (dirs, g_build_filename (G_DIR_SEPARATOR_S "var", "lib", "flatpak", NULL));
+
+      add_configured_installations (dirs);
+
+      g_ptr_array_add (dirs, NULL);
+      installations = (GStrv) g_ptr_array_free (g_steal_pointer (&dirs), FALSE);
+    }
+
+  return (const gchar * const *) installations;
+}
+
+static FlatpakAppInfo *
+load_flatpak_app_info (const gchar *deploy_dir,
+                       const gchar *commit)
+{
+  g_autoptr(GKeyFile) metadata = NULL;
+  g_autoptr(GVariant) deploy_data = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *metadata_path = NULL;
+  g_autofree gchar *deploy_path = NULL;
+  g_autofree gchar *contents = NULL;
+  FlatpakAppInfo *app_info;
+  gsize length;
+
+  metadata_path = g_build_filename (deploy_dir, "metadata", NULL);
+  metadata = g_key_file_new ();
+  if (!g_key_file_load_from_file (metadata, metadata_path, G_KEY_FILE_NONE, &error))
+    {
+      g_warning ("Failed to load %s: %s", metadata_path, error->message);
+      return NULL;
+    }
+
+  app_info = g_new0 (FlatpakAppInfo, 1);
+  app_info->deploy_dir = g_strdup (deploy_dir);
+  app_info->commit = g_strdup (commit);
+  app_info->metadata = g_steal_pointer (&metadata);
+
+  deploy_path = g_build_filename (deploy_dir, "deploy", NULL);
+  if (g_file_get_contents (deploy_path, &contents, &length, &error))
+    {
+      guint64 installed_size;
+
+      deploy_data = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE (FLATPAK_DEPLOY_DATA_FORMAT),
+                                                                 contents, length,
+                                                                 FALSE,
+                                                                 g_free, g_steal_pointer (&contents)));
+      g_variant_get_child (deploy_data, 3, "t", &installed_size);
+      app_info->installed_size = GUINT64_FROM_BE (installed_size);
+    }
+  else
+    {
+      g_debug ("Failed to load %s: %s", deploy_path, error->message);
+    }
+
+  return app_info;
+}
+
+static FlatpakAppInfo *
+get_flatpak_app_info (const gchar *app_id)
+{
+  const gchar * const *installations;
+  gsize i;
+
+  if (!flatpak_app_infos)
+    flatpak_app_infos = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) flatpak_app_info_free);
+
+  installations = get_flatpak_installations ();
+  for (i = 0; installations[i] != NULL; i++)
+    {
+      g_autofree gchar *deploy_dir = NULL;
+      g_autofree gchar *commit = NULL;
+      FlatpakAppInfo *app_info;
+
+      /* app/<id>/current links to the default arch/branch, whose
+       * active link is named after the deployed commit */
+      deploy_dir = g_build_filename (installations[i], "app", app_id, "current", "active", NULL);
+      commit = g_file_read_link (deploy_dir, NULL);
+      if (!commit)
+        continue;
+
+      app_info = g_hash_table_lookup (flatpak_app_infos, app_id);
+      if (app_info &&
+          g_str_equal (app_info->deploy_dir, deploy_dir) &&
+          g_str_equal (app_info->commit, commit))
+        return app_info;
+
+      app_info = load_flatpak_app_info (deploy_dir, commit);
+      if (!app_info)
+        continue;
+
+      g_hash_table_replace (flatpak_app_infos, g_strdup (app_id), app_info);
+
+      return app_info;
+    }
+
+  return NULL;
+}
+
+GKeyFile *
+get_flatpak_metadata (const gchar *app_id)
+{
+  FlatpakAppInfo *app_info;
+
+  app_info = get_flatpak_app_info (app_id);
+  if (app_info)
+    return g_key_file_ref (app_info->metadata);
+
+  return spawn_flatpak_metadata (app_id);
+}
+
+guint64
+get_flatpak_app_size (const gchar *app_id)
+{
+  FlatpakAppInfo *app_info;
+
+  app_info = get_flatpak_app_info (app_id);
+  if (app_info && app_info->installed_size > 0)
+    return app_info->installed_size;
+
+  return spawn_flatpak_app_size (app_id);
+}
+
 guint64
 get_snap_app_size (const gchar *snap_name)
 {
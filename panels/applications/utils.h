@@ -44,6 +44,8 @@ gboolean  file_size_finish     (GFile               *file,
                                 guint64             *size,
                                 GError             **error);
 
+void      file_size_clear_cache (void);
+
 GKeyFile* get_flatpak_metadata (const gchar         *app_id);
 
 guint64   get_flatpak_app_size (const gchar         *app_id);
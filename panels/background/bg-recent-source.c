@@ -41,6 +41,9 @@ struct _BgRecentSource
 
 G_DEFINE_TYPE (BgRecentSource, bg_recent_source, BG_TYPE_SOURCE)
 
+/* The number of files queried at once while enumerating */
+#define ENUMERATE_BATCH_SIZE 200
+
 static int
 sort_func (gconstpointer a,
            gconstpointer b,
@@ -50,27 +53,25 @@ sort_func (gconstpointer a,
   CcBackgroundItem *item_b;
   guint64 modified_a;
   guint64 modified_b;
-  int retval;
 
   item_a = (CcBackgroundItem *) a;
   item_b = (CcBackgroundItem *) b;
   modified_a = cc_background_item_get_modified (item_a);
   modified_b = cc_background_item_get_modified (item_b);
 
-  retval = modified_b - modified_a;
+  /* Most recent first */
+  if (modified_a == modified_b)
+    return 0;
 
-  return retval;
+  return modified_a > modified_b ? -1 : 1;
 }
 
-static void
-add_file_from_info (BgRecentSource *self,
-                    GFile          *file,
-                    GFileInfo      *info)
+static CcBackgroundItem *
+create_item_from_info (GFile     *file,
+                       GFileInfo *info)
 {
-  g_autoptr(CcBackgroundItem) item = NULL;
-  g_autofree gchar *source_uri = NULL;
+  CcBackgroundItem *item;
   g_autofree gchar *uri = NULL;
-  GListStore *store;
   const gchar *content_type;
   guint64 mtime;
 
@@ -78,7 +79,7 @@ add_file_from_info (BgRecentSource *self,
   mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
 
   if (!content_type || !g_content_type_is_a (content_type, "image/*"))
-    return;
+    return NULL;
 
   uri = g_file_get_uri (file);
   item = cc_background_item_new (uri);
@@ -87,45 +88,82 @@ add_file_from_info (BgRecentSource *self,
                 "placement", G_DESKTOP_BACKGROUND_STYLE_ZOOM,
                 "modified", mtime,
                 "needs-download", FALSE,
-                "source-url", source_uri,
                 NULL);
 
+  return item;
+}
+
+static void
+remove_item_from_store (BgRecentSource   *self,
+                        CcBackgroundItem *item)
+{
+  GListStore *store;
+  guint position;
+
   store = bg_source_get_liststore (BG_SOURCE (self));
-  g_list_store_insert_sorted (store, item, sort_func, self);
 
-  g_hash_table_insert (self->items, g_strdup (uri), g_object_ref (item));
+  if (g_list_store_find (store, item, &position))
+    g_list_store_remove (store, position);
+}
+
+/* Applies the change of a single file, as reported by the monitor */
+static void
+update_file_from_info (BgRecentSource *self,
+                       GFile          *file,
+                       GFileInfo      *info)
+{
+  g_autoptr(CcBackgroundItem) item = NULL;
+  g_autofree gchar *uri = NULL;
+  CcBackgroundItem *previous_item;
+
+  uri = g_file_get_uri (file);
+  item = create_item_from_info (file, info);
+
+  previous_item = g_hash_table_lookup (self->items, uri);
+  if (previous_item)
+    {
+      /* Same file, same modification time: nothing changed */
+      if (item && cc_background_item_get_modified (previous_item) == cc_background_item_get_modified (item))
+        return;
+
+      remove_item_from_store (self, previous_item);
+      g_hash_table_remove (self->items, uri);
+    }
+
+  if (!item)
+    return;
+
+  g_list_store_insert_sorted (bg_source_get_liststore (BG_SOURCE (self)), item, sort_func, self);
+  g_hash_table_insert (self->items, g_steal_pointer (&uri), g_object_ref (item));
 }
 
 static void
 remove_item (BgRecentSource   *self,
              CcBackgroundItem *item)
 {
-  GListStore *store;
-  const gchar *uri;
-  guint i;
-
   g_return_if_fail (BG_IS_RECENT_SOURCE (self));
   g_return_if_fail (CC_IS_BACKGROUND_ITEM (item));
 
-  uri = cc_background_item_get_uri (item);
-  store = bg_source_get_liststore (BG_SOURCE (self));
+  g_debug ("Removing wallpaper %s", cc_background_item_get_uri (item));
 
-  g_debug ("Removing wallpaper %s", uri);
+  cc_background_item_remove_cached_thumbnails (item);
+  remove_item_from_store (self, item);
 
-  for (i = 0; i < g_list_model_get_n_items (G_LIST_MODEL (store)); i++)
-    {
-      g_autoptr(CcBackgroundItem) tmp = NULL;
+  g_hash_table_remove (self->items, cc_background_item_get_uri (item));
+}
 
-      tmp = g_list_model_get_item (G_LIST_MODEL (store), i);
+static void
+remove_file (BgRecentSource *self,
+             GFile          *file)
+{
+  g_autofree gchar *uri = NULL;
+  CcBackgroundItem *item;
 
-      if (tmp == item)
-        {
-          g_list_store_remove (store, i);
-          break;
-        }
-    }
+  uri = g_file_get_uri (file);
+  item = g_hash_table_lookup (self->items, uri);
 
-  g_hash_table_remove (self->items, cc_background_item_get_uri (item));
+  if (item)
+    remove_item (self, item);
 }
 
 static void
@@ -149,11 +187,22 @@ query_info_finished_cb (GObject      *source,
 
   self = BG_RECENT_SOURCE (user_data);
 
-  g_debug ("Adding wallpaper %s (%d)",
-           g_file_info_get_name (file_info),
-           G_IS_FILE (self->backgrounds_folder));
+  g_debug ("Updating wallpaper %s", g_file_info_get_name (file_info));
 
-  add_file_from_info (self, file, file_info);
+  update_file_from_info (self, file, file_info);
+}
+
+static void
+query_file (BgRecentSource *self,
+            GFile          *file)
+{
+  g_file_query_info_async (file,
+                           ATTRIBUTES,
+                           G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                           G_PRIORITY_DEFAULT,
+                           self->cancellable,
+                           query_info_finished_cb,
+                           self);
 }
 
 static void
@@ -162,23 +211,22 @@ on_file_changed_cb (BgRecentSource    *self,
                     GFile             *other_file,
                     GFileMonitorEvent  event_type)
 {
-  g_autofree gchar *uri = NULL;
-
   switch (event_type)
     {
     case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
-      g_file_query_info_async (file,
-                               ATTRIBUTES,
-                               G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                               G_PRIORITY_DEFAULT,
-                               self->cancellable,
-                               query_info_finished_cb,
-                               self);
+    case G_FILE_MONITOR_EVENT_MOVED_IN:
+      query_file (self, file);
+      break;
+
+    case G_FILE_MONITOR_EVENT_RENAMED:
+      remove_file (self, file);
+      if (other_file)
+        query_file (self, other_file);
       break;
 
     case G_FILE_MONITOR_EVENT_DELETED:
-      uri = g_file_get_uri (file);
-      remove_item (self, g_hash_table_lookup (self->items, uri));
+    case G_FILE_MONITOR_EVENT_MOVED_OUT:
+      remove_file (self, file);
       break;
 
     default:
@@ -186,34 +234,21 @@ on_file_changed_cb (BgRecentSource    *self,
     }
 }
 
-static int
-file_sort_func (gconstpointer a,
-                gconstpointer b)
-{
-  GFileInfo *file_a = G_FILE_INFO (a);
-  GFileInfo *file_b = G_FILE_INFO (b);
-  guint64 modified_a, modified_b;
-
-  modified_a = g_file_info_get_attribute_uint64 (file_a, G_FILE_ATTRIBUTE_TIME_MODIFIED);
-  modified_b = g_file_info_get_attribute_uint64 (file_b, G_FILE_ATTRIBUTE_TIME_MODIFIED);
-
-  return modified_b - modified_a;
-}
-
 static void
 file_info_async_ready_cb (GObject      *source,
                           GAsyncResult *result,
                           gpointer      user_data)
 {
   BgRecentSource *self;
+  GFileEnumerator *enumerator;
   g_autolist(GFileInfo) file_infos = NULL;
+  g_autoptr(GPtrArray) items = NULL;
   g_autoptr(GError) error = NULL;
   GFile *parent = NULL;
   GList *l;
 
-  file_infos = g_file_enumerator_next_files_finish (G_FILE_ENUMERATOR (source),
-                                                    result,
-                                                    &error);
+  enumerator = G_FILE_ENUMERATOR (source);
+  file_infos = g_file_enumerator_next_files_finish (enumerator, result, &error);
   if (error)
     {
       if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
@@ -222,27 +257,50 @@ file_info_async_ready_cb (GObject      *source,
     }
 
   self = BG_RECENT_SOURCE (user_data);
-  parent = g_file_enumerator_get_container (G_FILE_ENUMERATOR (source));
 
-  file_infos = g_list_sort (file_infos, file_sort_func);
+  if (!file_infos)
+    {
+      g_file_enumerator_close (enumerator, self->cancellable, &error);
+
+      if (error)
+        g_warning ("Error closing file enumerator: %s", error->message);
+      return;
+    }
+
+  parent = g_file_enumerator_get_container (enumerator);
+  items = g_ptr_array_new_with_free_func (g_object_unref);
 
   for (l = file_infos; l; l = l->next)
     {
+      g_autoptr(CcBackgroundItem) item = NULL;
       g_autoptr(GFile) file = NULL;
       GFileInfo *info;
 
       info = l->data;
       file = g_file_get_child (parent, g_file_info_get_name (info));
+      item = create_item_from_info (file, info);
+
+      /* The monitor may have reported it already */
+      if (!item || g_hash_table_contains (self->items, cc_background_item_get_uri (item)))
+        continue;
 
       g_debug ("Found recent wallpaper %s", g_file_info_get_name (info));
 
-      add_file_from_info (self, file, info);
+      g_hash_table_insert (self->items,
+                           g_strdup (cc_background_item_get_uri (item)),
+                           g_object_ref (item));
+      g_ptr_array_add (items, g_steal_pointer (&item));
     }
 
-  g_file_enumerator_close (G_FILE_ENUMERATOR (source), self->cancellable, &error);
+  /* Sort once, and add the whole batch at once */
+  bg_source_add_items_sorted (BG_SOURCE (self), items, sort_func, self);
 
-  if (error)
-    g_warning ("Error closing file enumerator: %s", error->message);
+  g_file_enumerator_next_files_async (enumerator,
+                                      ENUMERATE_BATCH_SIZE,
+                                      G_PRIORITY_DEFAULT,
+                                      self->cancellable,
+                                      file_info_async_ready_cb,
+                                      self);
 }
 
 static void
@@ -265,7 +323,7 @@ enumerate_children_finished_cb (GObject      *source,
 
   self = BG_RECENT_SOURCE (user_data);
   g_file_enumerator_next_files_async (enumerator,
-                                      G_MAXINT,
+                                      ENUMERATE_BATCH_SIZE,
                                       G_PRIORITY_DEFAULT,
                                       self->cancellable,
                                       file_info_async_ready_cb,
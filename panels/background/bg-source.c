@@ -100,3 +100,99 @@ bg_source_get_liststore (BgSource *source)
   priv = bg_source_get_instance_private (source);
   return priv->store;
 }
+
+typedef struct
+{
+  GCompareDataFunc compare_func;
+  gpointer         user_data;
+} SortData;
+
+static int
+compare_item_ptrs (gconstpointer a,
+                   gconstpointer b,
+                   gpointer      user_data)
+{
+  SortData *data = user_data;
+
+  return data->compare_func (*(gpointer *) a, *(gpointer *) b, data->user_data);
+}
+
+/**
+ * bg_source_add_items_sorted:
+ * @source: a #BgSource
+ * @items: (element-type CcBackgroundItem): the items to add
+ * @compare_func: the function the store is sorted with
+ * @user_data: user data for @compare_func
+ *
+ * Adds @items to the store, which must be sorted with @compare_func,
+ * with a single items-changed emission.
+ */
+void
+bg_source_add_items_sorted (BgSource         *source,
+                            GPtrArray        *items,
+                            GCompareDataFunc  compare_func,
+                            gpointer          user_data)
+{
+  g_autoptr(GPtrArray) batch = NULL;
+  g_autoptr(GPtrArray) merged = NULL;
+  SortData sort_data = { compare_func, user_data };
+  GListStore *store;
+  guint n_items;
+  guint position;
+  guint i, j;
+
+  g_return_if_fail (BG_IS_SOURCE (source));
+  g_return_if_fail (items != NULL);
+
+  if (items->len == 0)
+    return;
+
+  /* Only the new items need sorting, the store already is */
+  batch = g_ptr_array_new_full (items->len, g_object_unref);
+  for (i = 0; i < items->len; i++)
+    g_ptr_array_add (batch, g_object_ref (g_ptr_array_index (items, i)));
+  g_ptr_array_sort_with_data (batch, compare_item_ptrs, &sort_data);
+
+  store = bg_source_get_liststore (source);
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (store));
+
+  /* Items equal to existing ones go after them, like a stable sort would.
+   * Nothing before the first new item changes */
+  for (position = 0; position < n_items; position++)
+    {
+      g_autoptr(GObject) item = g_list_model_get_item (G_LIST_MODEL (store), position);
+
+      if (compare_func (item, g_ptr_array_index (batch, 0), user_data) > 0)
+        break;
+    }
+
+  merged = g_ptr_array_new_full (batch->len, g_object_unref);
+
+  i = position;
+  j = 0;
+  while (i < n_items && j < batch->len)
+    {
+      g_autoptr(GObject) item = g_list_model_get_item (G_LIST_MODEL (store), i);
+
+      if (compare_func (item, g_ptr_array_index (batch, j), user_data) <= 0)
+        {
+          g_ptr_array_add (merged, g_steal_pointer (&item));
+          i++;
+        }
+      else
+        {
+          g_ptr_array_add (merged, g_object_ref (g_ptr_array_index (batch, j)));
+          j++;
+        }
+    }
+
+  /* Whatever is left of the store after the last new item stays */
+  for (; j < batch->len; j++)
+    g_ptr_array_add (merged, g_object_ref (g_ptr_array_index (batch, j)));
+
+  g_list_store_splice (store,
+                       position,
+                       i - position,
+                       merged->pdata,
+                       merged->len);
+}
@@ -35,4 +35,9 @@ struct _BgSourceClass
 
 GListStore* bg_source_get_liststore (BgSource *source);
 
+void bg_source_add_items_sorted (BgSource         *source,
+                                 GPtrArray        *items,
+                                 GCompareDataFunc  compare_func,
+                                 gpointer          user_data);
+
 G_END_DECLS
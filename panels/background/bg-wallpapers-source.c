@@ -62,19 +62,26 @@ sort_func (gconstpointer a,
 }
 
 static void
-load_wallpapers (gchar              *key,
-                 CcBackgroundItem   *item,
-                 BgWallpapersSource *source)
+load_wallpapers (BgWallpapersSource *source,
+                 GPtrArray          *items)
 {
-  GListStore *store = bg_source_get_liststore (BG_SOURCE (source));
-  gboolean deleted;
+  g_autoptr(GPtrArray) wallpapers = NULL;
+  guint i;
+
+  wallpapers = g_ptr_array_new_full (items->len, g_object_unref);
+
+  for (i = 0; i < items->len; i++)
+    {
+      CcBackgroundItem *item = g_ptr_array_index (items, i);
+      gboolean deleted;
 
-  g_object_get (G_OBJECT (item), "is-deleted", &deleted, NULL);
+      g_object_get (G_OBJECT (item), "is-deleted", &deleted, NULL);
 
-  if (deleted)
-    return;
+      if (!deleted)
+        g_ptr_array_add (wallpapers, g_object_ref (item));
+    }
 
-  g_list_store_insert_sorted (store, item, sort_func, NULL);
+  bg_source_add_items_sorted (BG_SOURCE (source), wallpapers, sort_func, NULL);
 }
 
 static void
@@ -88,10 +95,10 @@ list_load_cb (GObject *source_object,
 }
 
 static void
-item_added (BgWallpapersSource *self,
-            CcBackgroundItem   *item)
+items_added (BgWallpapersSource *self,
+             GPtrArray          *items)
 {
-  load_wallpapers (NULL, item, self);
+  load_wallpapers (self, items);
 }
 
 static void
@@ -122,8 +129,8 @@ bg_wallpapers_source_constructed (GObject *object)
 
   G_OBJECT_CLASS (bg_wallpapers_source_parent_class)->constructed (object);
 
-  g_signal_connect_object (G_OBJECT (self->xml), "added",
-                           G_CALLBACK (item_added), self, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (self->xml), "items-added",
+                           G_CALLBACK (items_added), self, G_CONNECT_SWAPPED);
 
   /* Try adding the default background first */
   load_default_bg (self);
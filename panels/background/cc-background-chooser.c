@@ -37,15 +37,17 @@ struct _CcBackgroundChooser
 {
   GtkBox              parent;
 
-  GtkFlowBox         *flowbox;
-  GtkWidget          *recent_box;
-  GtkFlowBox         *recent_flowbox;
-
-  gboolean            recent_selected;
+  GtkGridView        *grid_view;
 
   BgWallpapersSource *wallpapers_source;
   BgRecentSource     *recent_source;
 
+  /* The recent pictures followed by the wallpapers */
+  GtkSingleSelection *selection;
+
+  /* Cells currently showing an item */
+  GHashTable         *bound_cells;
+
   CcBackgroundItem   *active_item;
 
   GnomeDesktopThumbnailFactory *thumbnail_factory;
@@ -62,84 +64,89 @@ enum
 static guint signals [N_SIGNALS];
 
 static void
-emit_background_chosen (CcBackgroundChooser *self)
+on_delete_background_clicked_cb (GtkButton      *button,
+                                 BgRecentSource *source)
 {
-  g_autoptr(GList) list = NULL;
+  GtkWidget *cell;
   CcBackgroundItem *item;
-  GtkFlowBox *flowbox;
 
-  flowbox = self->recent_selected ? self->recent_flowbox : self->flowbox;
-  list = gtk_flow_box_get_selected_children (flowbox);
-  g_assert (g_list_length (list) == 1);
+  cell = gtk_widget_get_parent (GTK_WIDGET (button));
+  g_assert (GTK_IS_OVERLAY (cell));
 
-  item = g_object_get_data (list->data, "item");
+  item = g_object_get_data (G_OBJECT (cell), "item");
 
-  g_signal_emit (self, signals[BACKGROUND_CHOSEN], 0, item);
+  bg_recent_source_remove_item (source, item);
 }
 
 static void
-on_delete_background_clicked_cb (GtkButton *button,
-                                 BgRecentSource  *source)
+direction_changed_cb (GtkWidget        *widget,
+                      GtkTextDirection *previous_direction,
+                      gpointer          user_data)
 {
-  GtkWidget *parent;
-  CcBackgroundItem *item;
+  GdkPaintable *paintable = gtk_picture_get_paintable (GTK_PICTURE (widget));
 
-  parent = gtk_widget_get_parent (gtk_widget_get_parent (GTK_WIDGET (button)));
-  g_assert (GTK_IS_FLOW_BOX_CHILD (parent));
+  if (paintable)
+    g_object_set (paintable,
+                  "text-direction", gtk_widget_get_direction (widget),
+                  NULL);
+}
 
-  item = g_object_get_data (G_OBJECT (parent), "item");
+static void
+scale_factor_changed_cb (GtkWidget  *widget,
+                         GParamSpec *pspec,
+                         gpointer    user_data)
+{
+  GdkPaintable *paintable = gtk_picture_get_paintable (GTK_PICTURE (widget));
 
-  bg_recent_source_remove_item (source, item);
+  if (paintable)
+    g_object_set (paintable,
+                  "scale-factor", gtk_widget_get_scale_factor (widget),
+                  NULL);
 }
 
 static void
-direction_changed_cb (GtkWidget        *widget,
-                      GtkTextDirection *previous_direction,
-                      GdkPaintable     *paintable)
+picture_unmap_cb (GtkWidget *widget,
+                  gpointer   user_data)
 {
-  g_object_set (paintable,
-                "text-direction", gtk_widget_get_direction (widget),
-                NULL);
+  GdkPaintable *paintable = gtk_picture_get_paintable (GTK_PICTURE (widget));
+
+  if (paintable)
+    cc_background_paintable_cancel_thumbnails (CC_BACKGROUND_PAINTABLE (paintable));
 }
 
-static GtkWidget*
-create_widget_func (gpointer model_item,
-                    gpointer user_data)
+static void
+update_active_item (CcBackgroundChooser *self,
+                    GtkWidget           *cell)
+{
+  CcBackgroundItem *item = g_object_get_data (G_OBJECT (cell), "item");
+
+  if (item && self->active_item && cc_background_item_compare (item, self->active_item))
+    gtk_widget_add_css_class (cell, "active-item");
+  else
+    gtk_widget_remove_css_class (cell, "active-item");
+}
+
+static void
+setup_cell_cb (GtkSignalListItemFactory *factory,
+               GtkListItem              *list_item,
+               CcBackgroundChooser      *self)
 {
-  g_autoptr(CcBackgroundPaintable) paintable = NULL;
-  CcBackgroundChooser *self;
-  CcBackgroundItem *item;
   GtkWidget *overlay;
-  GtkWidget *child;
   GtkWidget *picture;
   GtkWidget *icon;
   GtkWidget *check;
-  GtkWidget *button = NULL;
-  BgSource *source;
-
-  source = BG_SOURCE (user_data);
-  item = CC_BACKGROUND_ITEM (model_item);
-
-  self = g_object_get_data (G_OBJECT (source), "background-chooser");
-
-  paintable = cc_background_paintable_new (self->thumbnail_factory,
-                                           item,
-                                           CC_BACKGROUND_PAINT_LIGHT_DARK,
-                                           THUMBNAIL_WIDTH,
-                                           THUMBNAIL_HEIGHT);
+  GtkWidget *button;
 
-  picture = gtk_picture_new_for_paintable (GDK_PAINTABLE (paintable));
+  picture = gtk_picture_new ();
   gtk_picture_set_can_shrink (GTK_PICTURE (picture), FALSE);
 
-  g_object_bind_property (picture, "scale-factor",
-                          paintable, "scale-factor", G_BINDING_SYNC_CREATE);
-  g_signal_connect_object (picture, "direction-changed",
-                           G_CALLBACK (direction_changed_cb), paintable, 0);
+  g_signal_connect (picture, "notify::scale-factor", G_CALLBACK (scale_factor_changed_cb), NULL);
+  g_signal_connect (picture, "direction-changed", G_CALLBACK (direction_changed_cb), NULL);
+  g_signal_connect (picture, "unmap", G_CALLBACK (picture_unmap_cb), NULL);
 
   icon = gtk_image_new_from_icon_name ("slideshow-symbolic");
   gtk_widget_set_halign (icon, GTK_ALIGN_START);
   gtk_widget_set_valign (icon, GTK_ALIGN_END);
-  gtk_widget_set_visible (icon, cc_background_item_changes_with_time (item));
   gtk_widget_add_css_class (icon, "slideshow-icon");
 
   check = gtk_image_new_from_icon_name ("background-selected-symbolic");
@@ -147,103 +154,140 @@ create_widget_func (gpointer model_item,
   gtk_widget_set_valign (check, GTK_ALIGN_END);
   gtk_widget_add_css_class (check, "selected-check");
 
-  if (BG_IS_RECENT_SOURCE (source))
-    {
-      button = gtk_button_new_from_icon_name ("cross-small-symbolic");
-      gtk_widget_set_halign (button, GTK_ALIGN_END);
-      gtk_widget_set_valign (button, GTK_ALIGN_START);
+  /* Only shown for recent pictures, see bind_cell_cb() */
+  button = gtk_button_new_from_icon_name ("cross-small-symbolic");
+  gtk_widget_set_halign (button, GTK_ALIGN_END);
+  gtk_widget_set_valign (button, GTK_ALIGN_START);
 
-      gtk_widget_add_css_class (button, "osd");
-      gtk_widget_add_css_class (button, "circular");
-      gtk_widget_add_css_class (button, "remove-button");
+  gtk_widget_add_css_class (button, "osd");
+  gtk_widget_add_css_class (button, "circular");
+  gtk_widget_add_css_class (button, "remove-button");
 
-     gtk_widget_set_tooltip_text (GTK_WIDGET (button), _("Remove Background"));
+  gtk_widget_set_tooltip_text (GTK_WIDGET (button), _("Remove Background"));
 
-      g_signal_connect (button,
-                        "clicked",
-                        G_CALLBACK (on_delete_background_clicked_cb),
-                        source);
-    }
+  g_signal_connect (button,
+                    "clicked",
+                    G_CALLBACK (on_delete_background_clicked_cb),
+                    self->recent_source);
 
   overlay = gtk_overlay_new ();
+  gtk_widget_set_halign (overlay, GTK_ALIGN_CENTER);
+  gtk_widget_set_valign (overlay, GTK_ALIGN_CENTER);
   gtk_widget_set_overflow (overlay, GTK_OVERFLOW_HIDDEN);
   gtk_widget_add_css_class (overlay, "background-thumbnail");
   gtk_overlay_set_child (GTK_OVERLAY (overlay), picture);
   gtk_overlay_add_overlay (GTK_OVERLAY (overlay), icon);
   gtk_overlay_add_overlay (GTK_OVERLAY (overlay), check);
-  if (button)
-    gtk_overlay_add_overlay (GTK_OVERLAY (overlay), button);
+  gtk_overlay_add_overlay (GTK_OVERLAY (overlay), button);
+
+  g_object_set_data (G_OBJECT (overlay), "picture", picture);
+  g_object_set_data (G_OBJECT (overlay), "slideshow-icon", icon);
+  g_object_set_data (G_OBJECT (overlay), "remove-button", button);
+
+  gtk_list_item_set_child (list_item, overlay);
+}
+
+static void
+bind_cell_cb (GtkSignalListItemFactory *factory,
+              GtkListItem              *list_item,
+              CcBackgroundChooser      *self)
+{
+  g_autoptr(CcBackgroundPaintable) paintable = NULL;
+  CcBackgroundItem *item;
+  GListStore *recent_store;
+  GtkWidget *overlay;
+  GtkWidget *picture;
+  GtkWidget *icon;
+  GtkWidget *button;
+
+  item = CC_BACKGROUND_ITEM (gtk_list_item_get_item (list_item));
+  overlay = gtk_list_item_get_child (list_item);
+  picture = g_object_get_data (G_OBJECT (overlay), "picture");
+  icon = g_object_get_data (G_OBJECT (overlay), "slideshow-icon");
+  button = g_object_get_data (G_OBJECT (overlay), "remove-button");
+  recent_store = bg_source_get_liststore (BG_SOURCE (self->recent_source));
+
+  /* The thumbnails are only requested once the picture is drawn */
+  paintable = cc_background_paintable_new (self->thumbnail_factory,
+                                           item,
+                                           CC_BACKGROUND_PAINT_LIGHT_DARK,
+                                           THUMBNAIL_WIDTH,
+                                           THUMBNAIL_HEIGHT);
+  g_object_set (paintable,
+                "scale-factor", gtk_widget_get_scale_factor (picture),
+                "text-direction", gtk_widget_get_direction (picture),
+                NULL);
+  gtk_picture_set_paintable (GTK_PICTURE (picture), GDK_PAINTABLE (paintable));
+
+  gtk_widget_set_visible (icon, cc_background_item_changes_with_time (item));
+  gtk_widget_set_visible (button, g_list_store_find (recent_store, item, NULL));
+
   gtk_accessible_update_property (GTK_ACCESSIBLE (overlay),
                                   GTK_ACCESSIBLE_PROPERTY_LABEL,
                                   cc_background_item_get_name (item),
                                   -1);
 
+  g_object_set_data_full (G_OBJECT (overlay), "item", g_object_ref (item), g_object_unref);
+  update_active_item (self, overlay);
 
-  child = gtk_flow_box_child_new ();
-  gtk_widget_set_halign (child, GTK_ALIGN_CENTER);
-  gtk_widget_set_valign (child, GTK_ALIGN_CENTER);
-  gtk_flow_box_child_set_child (GTK_FLOW_BOX_CHILD (child), overlay);
-
-  g_object_set_data_full (G_OBJECT (child), "item", g_object_ref (item), g_object_unref);
-
-  if (self->active_item && cc_background_item_compare (item, self->active_item))
-    gtk_widget_add_css_class (GTK_WIDGET (child), "active-item");
-
-  return child;
+  g_hash_table_add (self->bound_cells, overlay);
 }
 
 static void
-update_recent_visibility (CcBackgroundChooser *self)
+unbind_cell_cb (GtkSignalListItemFactory *factory,
+                GtkListItem              *list_item,
+                CcBackgroundChooser      *self)
 {
-  GListStore *store;
-  gboolean has_items;
+  GtkWidget *overlay;
+  GtkWidget *picture;
 
-  store = bg_source_get_liststore (BG_SOURCE (self->recent_source));
-  has_items = g_list_model_get_n_items (G_LIST_MODEL (store)) != 0;
+  overlay = gtk_list_item_get_child (list_item);
+  picture = g_object_get_data (G_OBJECT (overlay), "picture");
 
-  gtk_widget_set_visible (self->recent_box, has_items);
+  /* Disposing the paintable cancels its pending thumbnails */
+  gtk_picture_set_paintable (GTK_PICTURE (picture), NULL);
+  g_object_set_data (G_OBJECT (overlay), "item", NULL);
+
+  g_hash_table_remove (self->bound_cells, overlay);
 }
 
 static void
-setup_flowbox (CcBackgroundChooser *self)
+setup_grid_view (CcBackgroundChooser *self)
 {
-  GListStore *store;
-
-  store = bg_source_get_liststore (BG_SOURCE (self->wallpapers_source));
-
-  gtk_flow_box_bind_model (self->flowbox,
-                           G_LIST_MODEL (store),
-                           create_widget_func,
-                           self->wallpapers_source,
-                           NULL);
-
-  store = bg_source_get_liststore (BG_SOURCE (self->recent_source));
-
-  gtk_flow_box_bind_model (self->recent_flowbox,
-                           G_LIST_MODEL (store),
-                           create_widget_func,
-                           self->recent_source,
-                           NULL);
-
-  update_recent_visibility (self);
-  g_signal_connect_object (store,
-                           "items-changed",
-                           G_CALLBACK (update_recent_visibility),
-                           self,
-                           G_CONNECT_SWAPPED);
+  g_autoptr(GtkListItemFactory) factory = NULL;
+  g_autoptr(GListStore) models = NULL;
+  GtkFlattenListModel *model;
+
+  models = g_list_store_new (G_TYPE_LIST_MODEL);
+  g_list_store_append (models, bg_source_get_liststore (BG_SOURCE (self->recent_source)));
+  g_list_store_append (models, bg_source_get_liststore (BG_SOURCE (self->wallpapers_source)));
+  model = gtk_flatten_list_model_new (G_LIST_MODEL (g_steal_pointer (&models)));
+
+  self->selection = gtk_single_selection_new (G_LIST_MODEL (model));
+  gtk_single_selection_set_autoselect (self->selection, FALSE);
+  gtk_single_selection_set_can_unselect (self->selection, TRUE);
+  gtk_selection_model_unselect_all (GTK_SELECTION_MODEL (self->selection));
+
+  factory = gtk_signal_list_item_factory_new ();
+  g_signal_connect (factory, "setup", G_CALLBACK (setup_cell_cb), self);
+  g_signal_connect (factory, "bind", G_CALLBACK (bind_cell_cb), self);
+  g_signal_connect (factory, "unbind", G_CALLBACK (unbind_cell_cb), self);
+
+  gtk_grid_view_set_factory (self->grid_view, factory);
+  gtk_grid_view_set_model (self->grid_view, GTK_SELECTION_MODEL (self->selection));
 }
 
 static void
 on_item_activated_cb (CcBackgroundChooser *self,
-                      GtkFlowBoxChild     *child,
-                      GtkFlowBox          *flowbox)
+                      guint                position,
+                      GtkGridView         *grid_view)
 {
-  self->recent_selected = flowbox == self->recent_flowbox;
-  if (self->recent_selected)
-    gtk_flow_box_unselect_all (self->flowbox);
-  else
-    gtk_flow_box_unselect_all (self->recent_flowbox);
-  emit_background_chosen (self);
+  g_autoptr(CcBackgroundItem) item = NULL;
+
+  gtk_single_selection_set_selected (self->selection, position);
+
+  item = g_list_model_get_item (G_LIST_MODEL (self->selection), position);
+  g_signal_emit (self, signals[BACKGROUND_CHOSEN], 0, item);
 }
 
 static void
@@ -281,9 +325,11 @@ cc_background_chooser_finalize (GObject *object)
 {
   CcBackgroundChooser *self = (CcBackgroundChooser *)object;
 
+  g_clear_object (&self->selection);
   g_clear_object (&self->recent_source);
   g_clear_object (&self->wallpapers_source);
   g_clear_object (&self->thumbnail_factory);
+  g_clear_pointer (&self->bound_cells, g_hash_table_destroy);
 
   G_OBJECT_CLASS (cc_background_chooser_parent_class)->finalize (object);
 }
@@ -306,9 +352,7 @@ cc_background_chooser_class_init (CcBackgroundChooserClass *klass)
 
   gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/control-center/background/cc-background-chooser.ui");
 
-  gtk_widget_class_bind_template_child (widget_class, CcBackgroundChooser, flowbox);
-  gtk_widget_class_bind_template_child (widget_class, CcBackgroundChooser, recent_box);
-  gtk_widget_class_bind_template_child (widget_class, CcBackgroundChooser, recent_flowbox);
+  gtk_widget_class_bind_template_child (widget_class, CcBackgroundChooser, grid_view);
 
   gtk_widget_class_bind_template_callback (widget_class, on_item_activated_cb);
 }
@@ -318,14 +362,14 @@ cc_background_chooser_init (CcBackgroundChooser *self)
 {
   gtk_widget_init_template (GTK_WIDGET (self));
 
+  self->bound_cells = g_hash_table_new (NULL, NULL);
+
   self->recent_source = bg_recent_source_new ();
   self->wallpapers_source = bg_wallpapers_source_new ();
 
   self->thumbnail_factory = gnome_desktop_thumbnail_factory_new (GNOME_DESKTOP_THUMBNAIL_SIZE_LARGE);
-  g_object_set_data (G_OBJECT (self->recent_source), "background-chooser", self);
-  g_object_set_data (G_OBJECT (self->wallpapers_source), "background-chooser", self);
 
-  setup_flowbox (self);
+  setup_grid_view (self);
 }
 
 void
@@ -362,31 +406,19 @@ cc_background_chooser_select_file (CcBackgroundChooser *self)
                                  self);
 }
 
-static void flow_box_set_active_item (GtkFlowBox *flowbox, CcBackgroundItem *active_item)
-{
-  GtkFlowBoxChild *child = NULL;
-  CcBackgroundItem *item;
-  int idx = 0;
-
-  while ((child = gtk_flow_box_get_child_at_index (flowbox, idx++)))
-    {
-      item = g_object_get_data (G_OBJECT (child), "item");
-
-      if (cc_background_item_compare (item, active_item))
-        gtk_widget_add_css_class (GTK_WIDGET (child), "active-item");
-      else
-        gtk_widget_remove_css_class (GTK_WIDGET (child), "active-item");
-    }
-}
-
 void
 cc_background_chooser_set_active_item (CcBackgroundChooser *self, CcBackgroundItem *active_item)
 {
+  GHashTableIter iter;
+  GtkWidget *cell;
+
   g_return_if_fail (CC_IS_BACKGROUND_CHOOSER (self));
   g_return_if_fail (CC_IS_BACKGROUND_ITEM (active_item));
 
   self->active_item = active_item;
 
-  flow_box_set_active_item (self->flowbox, active_item);
-  flow_box_set_active_item (self->recent_flowbox, active_item);
+  /* Cells that aren't bound are updated when they are */
+  g_hash_table_iter_init (&iter, self->bound_cells);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &cell, NULL))
+    update_active_item (self, cell);
 }
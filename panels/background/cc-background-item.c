@@ -19,12 +19,14 @@
 
 #include "config.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 #include <gtk/gtk.h>
 #include <gio/gio.h>
 #include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
 
 #include <gnome-bg/gnome-bg.h>
 #include <gdesktop-enums.h>
@@ -33,6 +35,10 @@
 #include "gdesktop-enums-types.h"
 #include "cc-background-enum-types.h"
 
+/* Decoding wallpapers takes a lot of memory, so only a few are decoded
+ * at the same time, whatever the number of processors */
+#define MAX_THUMBNAIL_THREADS 4
+
 typedef struct {
         int        width;
         int        height;
@@ -71,8 +77,33 @@ struct _CcBackgroundItem
 
         CachedThumbnail cached_thumbnail;
         CachedThumbnail cached_thumbnail_dark;
+
+        /* Creating a thumbnail failed, don't try again */
+        gboolean         thumbnail_failed;
+        gboolean         thumbnail_failed_dark;
 };
 
+/* A snapshot of the item's properties when the job was created. The
+ * job only holds plain data, its GnomeBG is created where it runs, see
+ * run_thumbnail_job() */
+typedef struct {
+        GnomeDesktopThumbnailFactory *thumbs;
+        char                         *uri;
+        char                         *filename;
+        char                         *disk_cache_key; /* NULL if not cacheable */
+        GdkRectangle                  monitor_layout;
+        GDesktopBackgroundStyle       placement;
+        GDesktopBackgroundShading     shading;
+        char                         *primary_color;
+        char                         *secondary_color;
+        int                           width;
+        int                           height;
+        int                           scale_factor;
+        int                           frame;
+        gboolean                      dark;
+        GdkPixbuf                    *pixbuf;
+} ThumbnailJob;
+
 enum {
         PROP_0,
         PROP_NAME,
@@ -99,40 +130,43 @@ static void     cc_background_item_finalize       (GObject               *object
 G_DEFINE_TYPE (CcBackgroundItem, cc_background_item, G_TYPE_OBJECT)
 
 static void
-set_bg_properties (CcBackgroundItem *item)
+configure_bg (GnomeBG                   *bg,
+              const char                *uri,
+              GDesktopBackgroundStyle    placement,
+              GDesktopBackgroundShading  shading,
+              const char                *primary_color,
+              const char                *secondary_color)
 {
         GdkRGBA pcolor = { 0, 0, 0, 0 };
         GdkRGBA scolor = { 0, 0, 0, 0 };
 
-        if (item->uri) {
-		g_autoptr(GFile) file = NULL;
-		g_autofree gchar *filename = NULL;
-
-		file = g_file_new_for_commandline_arg (item->uri);
-		filename = g_file_get_path (file);
-		gnome_bg_set_filename (item->bg, filename);
-	}
-
-        if (item->uri_dark) {
+        if (uri) {
 		g_autoptr(GFile) file = NULL;
 		g_autofree gchar *filename = NULL;
 
-		file = g_file_new_for_commandline_arg (item->uri_dark);
+		file = g_file_new_for_commandline_arg (uri);
 		filename = g_file_get_path (file);
-		gnome_bg_set_filename (item->bg_dark, filename);
+		gnome_bg_set_filename (bg, filename);
 	}
 
-        if (item->primary_color != NULL) {
-                gdk_rgba_parse (&pcolor, item->primary_color);
+        if (primary_color != NULL) {
+                gdk_rgba_parse (&pcolor, primary_color);
         }
-        if (item->secondary_color != NULL) {
-                gdk_rgba_parse (&scolor, item->secondary_color);
+        if (secondary_color != NULL) {
+                gdk_rgba_parse (&scolor, secondary_color);
         }
 
-        gnome_bg_set_rgba (item->bg, item->shading, &pcolor, &scolor);
-        gnome_bg_set_rgba (item->bg_dark, item->shading, &pcolor, &scolor);
-        gnome_bg_set_placement (item->bg, item->placement);
-        gnome_bg_set_placement (item->bg_dark, item->placement);
+        gnome_bg_set_rgba (bg, shading, &pcolor, &scolor);
+        gnome_bg_set_placement (bg, placement);
+}
+
+static void
+set_bg_properties (CcBackgroundItem *item)
+{
+        configure_bg (item->bg, item->uri, item->placement, item->shading,
+                      item->primary_color, item->secondary_color);
+        configure_bg (item->bg_dark, item->uri_dark, item->placement, item->shading,
+                      item->primary_color, item->secondary_color);
 }
 
 
@@ -144,12 +178,14 @@ cc_background_item_changes_with_time (CcBackgroundItem *item)
 	g_return_val_if_fail (CC_IS_BACKGROUND_ITEM (item), FALSE);
 
         changes = FALSE;
+
         if (item->bg != NULL) {
                 changes = gnome_bg_changes_with_time (item->bg);
         }
         if (item->bg_dark != NULL) {
                 changes |= gnome_bg_changes_with_time (item->bg_dark);
         }
+
         return changes;
 }
 
@@ -169,10 +205,16 @@ update_size (CcBackgroundItem *item)
 	if (item->uri == NULL) {
 		item->size = g_strdup ("");
 	} else {
-		if (gnome_bg_has_multiple_sizes (item->bg) || gnome_bg_changes_with_time (item->bg)) {
+		g_autofree gchar *filename = NULL;
+		gboolean multiple_sizes;
+
+		multiple_sizes = gnome_bg_has_multiple_sizes (item->bg) || gnome_bg_changes_with_time (item->bg);
+		filename = g_strdup (gnome_bg_get_filename (item->bg));
+
+		if (multiple_sizes) {
 			item->size = g_strdup (_("multiple sizes"));
 		} else {
-			gdk_pixbuf_get_file_info (gnome_bg_get_filename (item->bg),
+			gdk_pixbuf_get_file_info (filename,
 						  &item->width,
 						  &item->height);
 			/* translators: 100 × 100px
@@ -184,28 +226,17 @@ update_size (CcBackgroundItem *item)
 	}
 }
 
-GdkPixbuf *
-cc_background_item_get_frame_thumbnail (CcBackgroundItem             *item,
-                                        GnomeDesktopThumbnailFactory *thumbs,
-                                        int                           width,
-                                        int                           height,
-                                        int                           scale_factor,
-                                        int                           frame,
-                                        gboolean                      dark)
+static CachedThumbnail *
+get_cached_thumbnail (CcBackgroundItem *item,
+                      int               width,
+                      int               height,
+                      int               scale_factor,
+                      int               frame,
+                      gboolean          dark)
 {
-        GdkPixbuf *pixbuf;
         CachedThumbnail *thumbnail;
-        GnomeBG *bg;
-        g_autoptr(GdkMonitor) monitor = NULL;
-        GdkDisplay *display;
-        GListModel *monitors;
-        GdkRectangle monitor_layout;
-
-	g_return_val_if_fail (CC_IS_BACKGROUND_ITEM (item), NULL);
-	g_return_val_if_fail (width > 0 && height > 0, NULL);
 
         thumbnail = dark ? &item->cached_thumbnail_dark : &item->cached_thumbnail;
-        bg = dark ? item->bg_dark : item->bg;
 
         /* Use the cached thumbnail if the sizes match */
         if (thumbnail->thumbnail &&
@@ -213,38 +244,544 @@ cc_background_item_get_frame_thumbnail (CcBackgroundItem             *item,
             thumbnail->height == height &&
             thumbnail->scale_factor == scale_factor &&
             thumbnail->frame == frame)
-                    return g_object_ref (thumbnail->thumbnail);
+                return thumbnail;
 
-        set_bg_properties (item);
+        return NULL;
+}
+
+static void
+cache_thumbnail (CcBackgroundItem *item,
+                 GdkPixbuf        *pixbuf,
+                 int               width,
+                 int               height,
+                 int               scale_factor,
+                 int               frame,
+                 gboolean          dark)
+{
+        CachedThumbnail *thumbnail;
+
+        thumbnail = dark ? &item->cached_thumbnail_dark : &item->cached_thumbnail;
+
+        g_set_object (&thumbnail->thumbnail, pixbuf);
+        thumbnail->width = width;
+        thumbnail->height = height;
+        thumbnail->scale_factor = scale_factor;
+        thumbnail->frame = frame;
+}
+
+static void
+get_monitor_layout (GdkRectangle *monitor_layout)
+{
+        g_autoptr(GdkMonitor) monitor = NULL;
+        GdkDisplay *display;
+        GListModel *monitors;
 
         display = gdk_display_get_default ();
         monitors = gdk_display_get_monitors (display);
         monitor = g_list_model_get_item (monitors, 0);
-        gdk_monitor_get_geometry (monitor, &monitor_layout);
+        gdk_monitor_get_geometry (monitor, monitor_layout);
+}
+
+/*
+ * Thumbnails are also kept on disk, so that reopening the panel doesn't
+ * decode any wallpaper again. They are stored as the raw pixels of the
+ * pixbuf, in a serialized GVariant that is mapped when loading, so they
+ * can be uploaded as is.
+ *
+ * Each background file has its own directory, named after a hash of its
+ * path, with one file per set of parameters that change how the
+ * thumbnail looks. File names start with the modification time of the
+ * background, and files for other modification times are removed when a
+ * new thumbnail is saved.
+ */
+
+#define DISK_CACHE_VERSION 2
+#define DISK_CACHE_FORMAT "(uiiibay)"
+
+static gchar *
+get_disk_cache_dir (const char *filename)
+{
+        g_autofree gchar *hash = NULL;
+
+        hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, filename, -1);
+
+        return g_build_filename (g_get_user_cache_dir (),
+                                 "gnome-control-center",
+                                 "background-thumbnails",
+                                 hash,
+                                 NULL);
+}
+
+static gchar *
+get_disk_cache_key (ThumbnailJob *job,
+                    GnomeBG      *bg)
+{
+        g_autofree gchar *parameters = NULL;
+
+        if (!job->filename)
+                return NULL;
+
+        /* Slideshows show a different slide depending on the time */
+        if (job->frame < 0 && gnome_bg_changes_with_time (bg))
+                return NULL;
+
+        parameters = g_strdup_printf ("%dx%d@%d|%d|%d|%d|%s|%s|%dx%d",
+                                      job->width,
+                                      job->height,
+                                      job->scale_factor,
+                                      job->frame,
+                                      job->placement,
+                                      job->shading,
+                                      job->primary_color ? job->primary_color : "",
+                                      job->secondary_color ? job->secondary_color : "",
+                                      job->monitor_layout.width,
+                                      job->monitor_layout.height);
+
+        return g_compute_checksum_for_string (G_CHECKSUM_SHA256, parameters, -1);
+}
+
+static gchar *
+get_disk_cache_path (ThumbnailJob *job,
+                     gchar       **out_prefix)
+{
+        g_autofree gchar *basename = NULL;
+        g_autofree gchar *dir = NULL;
+        GStatBuf buf;
+
+        if (g_stat (job->filename, &buf) != 0)
+                return NULL;
+
+        *out_prefix = g_strdup_printf ("%" G_GINT64_FORMAT "-", (gint64) buf.st_mtime);
+        basename = g_strconcat (*out_prefix, job->disk_cache_key, ".thumbnail", NULL);
+        dir = get_disk_cache_dir (job->filename);
+
+        return g_build_filename (dir, basename, NULL);
+}
+
+static GdkPixbuf *
+load_disk_thumbnail (const gchar *path)
+{
+        g_autoptr(GMappedFile) mapped_file = NULL;
+        g_autoptr(GVariant) thumbnail = NULL;
+        g_autoptr(GVariant) pixels = NULL;
+        g_autoptr(GBytes) pixel_bytes = NULL;
+        g_autoptr(GBytes) bytes = NULL;
+        gboolean has_alpha;
+        guint32 version;
+        gint32 width, height, rowstride;
+        gsize min_size;
+
+        mapped_file = g_mapped_file_new (path, FALSE, NULL);
+        if (!mapped_file)
+                return NULL;
+
+        bytes = g_mapped_file_get_bytes (mapped_file);
+        thumbnail = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (DISK_CACHE_FORMAT), bytes, FALSE));
+
+        g_variant_get (thumbnail, "(uiiib@ay)", &version, &width, &height, &rowstride, &has_alpha, &pixels);
+        if (version != DISK_CACHE_VERSION || width <= 0 || height <= 0)
+                return NULL;
+
+        /* The last row doesn't need to be padded to the rowstride */
+        min_size = (gsize) rowstride * (height - 1) + (gsize) width * (has_alpha ? 4 : 3);
+        if (rowstride < width * (has_alpha ? 4 : 3) || g_variant_get_size (pixels) < min_size) {
+                g_debug ("Ignoring invalid background thumbnail %s", path);
+                return NULL;
+        }
+
+        pixel_bytes = g_variant_get_data_as_bytes (pixels);
+
+        return gdk_pixbuf_new_from_bytes (pixel_bytes,
+                                          GDK_COLORSPACE_RGB,
+                                          has_alpha,
+                                          8,
+                                          width,
+                                          height,
+                                          rowstride);
+}
+
+/* Removes the thumbnails in @dir_path, except those starting with @prefix */
+static void
+remove_disk_thumbnails (const gchar *dir_path,
+                        const gchar *prefix)
+{
+        g_autoptr(GDir) dir = NULL;
+        const gchar *name;
+
+        dir = g_dir_open (dir_path, 0, NULL);
+        if (!dir)
+                return;
+
+        while ((name = g_dir_read_name (dir)) != NULL) {
+                g_autofree gchar *path = NULL;
+
+                if (prefix && g_str_has_prefix (name, prefix))
+                        continue;
+
+                path = g_build_filename (dir_path, name, NULL);
+                g_unlink (path);
+        }
+}
+
+static void
+save_disk_thumbnail (const gchar *path,
+                     const gchar *prefix,
+                     GdkPixbuf   *pixbuf)
+{
+        g_autoptr(GVariant) thumbnail = NULL;
+        g_autoptr(GBytes) pixel_bytes = NULL;
+        g_autoptr(GBytes) bytes = NULL;
+        g_autoptr(GError) error = NULL;
+        g_autofree gchar *dir = NULL;
+
+        dir = g_path_get_dirname (path);
+        if (g_mkdir_with_parents (dir, 0700) != 0) {
+                g_debug ("Failed to create %s, not saving the background thumbnail", dir);
+                return;
+        }
+
+        remove_disk_thumbnails (dir, prefix);
+
+        pixel_bytes = gdk_pixbuf_read_pixel_bytes (pixbuf);
+        thumbnail = g_variant_ref_sink (g_variant_new ("(uiiib@ay)",
+                                                       DISK_CACHE_VERSION,
+                                                       gdk_pixbuf_get_width (pixbuf),
+                                                       gdk_pixbuf_get_height (pixbuf),
+                                                       gdk_pixbuf_get_rowstride (pixbuf),
+                                                       gdk_pixbuf_get_has_alpha (pixbuf),
+                                                       g_variant_new_from_bytes (G_VARIANT_TYPE_BYTESTRING,
+                                                                                 pixel_bytes,
+                                                                                 TRUE)));
+        bytes = g_variant_get_data_as_bytes (thumbnail);
+
+        if (!g_file_set_contents (path,
+                                  g_bytes_get_data (bytes, NULL),
+                                  g_bytes_get_size (bytes),
+                                  &error))
+                g_debug ("Failed to save background thumbnail %s: %s", path, error->message);
+}
+
+static void
+thumbnail_job_free (ThumbnailJob *job)
+{
+        g_clear_object (&job->thumbs);
+        g_clear_object (&job->pixbuf);
+        g_free (job->uri);
+        g_free (job->filename);
+        g_free (job->disk_cache_key);
+        g_free (job->primary_color);
+        g_free (job->secondary_color);
+        g_free (job);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ThumbnailJob, thumbnail_job_free)
+
+static ThumbnailJob *
+thumbnail_job_new (CcBackgroundItem             *item,
+                   GnomeDesktopThumbnailFactory *thumbs,
+                   int                           width,
+                   int                           height,
+                   int                           scale_factor,
+                   int                           frame,
+                   gboolean                      dark)
+{
+        ThumbnailJob *job;
+
+        set_bg_properties (item);
+
+        job = g_new0 (ThumbnailJob, 1);
+        job->uri = g_strdup (dark ? item->uri_dark : item->uri);
+        job->thumbs = g_object_ref (thumbs);
+        job->width = width;
+        job->height = height;
+        job->scale_factor = scale_factor;
+        job->frame = frame;
+        job->dark = dark;
+        job->placement = item->placement;
+        job->shading = item->shading;
+        job->primary_color = g_strdup (item->primary_color);
+        job->secondary_color = g_strdup (item->secondary_color);
+        if (job->uri) {
+                g_autoptr(GFile) file = g_file_new_for_commandline_arg (job->uri);
+                job->filename = g_file_get_path (file);
+        }
+        get_monitor_layout (&job->monitor_layout);
+
+        return job;
+}
+
+/* Makes sure the thumbnail factory has a thumbnail of the image at
+ * @filename. Generating it means decoding the whole image, which is what
+ * makes thumbnailing slow, and can be done in parallel: gnome-bg then
+ * only loads the small thumbnail. */
+static void
+prepare_factory_thumbnail (GnomeDesktopThumbnailFactory *thumbs,
+                           const char                   *filename,
+                           GCancellable                 *cancellable)
+{
+        g_autoptr(GFile) file = NULL;
+        g_autoptr(GFileInfo) info = NULL;
+        g_autoptr(GdkPixbuf) pixbuf = NULL;
+        g_autoptr(GError) error = NULL;
+        g_autofree gchar *thumbnail_path = NULL;
+        g_autofree gchar *uri = NULL;
+        const char *content_type;
+        time_t mtime;
+
+        file = g_file_new_for_path (filename);
+        info = g_file_query_info (file,
+                                  G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ","
+                                  G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                  G_FILE_QUERY_INFO_NONE,
+                                  cancellable,
+                                  NULL);
+        if (!info)
+                return;
+
+        /* Slideshows are left to gnome-bg */
+        content_type = g_file_info_get_content_type (info);
+        if (!content_type || !g_str_has_prefix (content_type, "image/"))
+                return;
+
+        uri = g_filename_to_uri (filename, NULL, NULL);
+        if (!uri)
+                return;
+
+        mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+        thumbnail_path = gnome_desktop_thumbnail_factory_lookup (thumbs, uri, mtime);
+        if (thumbnail_path ||
+            gnome_desktop_thumbnail_factory_has_valid_failed_thumbnail (thumbs, uri, mtime) ||
+            !gnome_desktop_thumbnail_factory_can_thumbnail (thumbs, uri, content_type, mtime))
+                return;
+
+        pixbuf = gnome_desktop_thumbnail_factory_generate_thumbnail (thumbs, uri, content_type, cancellable, &error);
+        if (!pixbuf) {
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        g_debug ("Failed to generate thumbnail for %s: %s", filename, error->message);
+                return;
+        }
+
+        if (!gnome_desktop_thumbnail_factory_save_thumbnail (thumbs, pixbuf, uri, mtime, cancellable, &error))
+                g_debug ("Failed to save thumbnail for %s: %s", filename, error->message);
+}
+
+/* Decodes the image at @filename straight at about the size of the
+ * thumbnail. This lets the JPEG loader downscale while decoding, so a
+ * large wallpaper only needs a few MB, instead of being fully decoded as
+ * gnome-bg does when the thumbnail factory has no thumbnail for it.
+ *
+ * Only the placements where gnome-bg wouldn't draw anything else than the
+ * scaled image, and possibly a solid colour, are handled. Returns %NULL
+ * when gnome-bg has to create the thumbnail instead. */
+static GdkPixbuf *
+create_scaled_thumbnail (ThumbnailJob *job)
+{
+        g_autoptr(GdkPixbuf) decoded = NULL;
+        g_autoptr(GdkPixbuf) oriented = NULL;
+        g_autoptr(GError) error = NULL;
+        GdkPixbuf *pixbuf;
+        GdkRGBA color;
+        int image_width, image_height;
+        int dest_width, dest_height;
+        double scale_x, scale_y;
+
+        switch (job->placement) {
+        case G_DESKTOP_BACKGROUND_STYLE_ZOOM:
+        case G_DESKTOP_BACKGROUND_STYLE_SPANNED:
+        case G_DESKTOP_BACKGROUND_STYLE_STRETCHED:
+                break;
+        case G_DESKTOP_BACKGROUND_STYLE_SCALED:
+                if (job->shading != G_DESKTOP_BACKGROUND_SHADING_SOLID ||
+                    !job->primary_color ||
+                    !gdk_rgba_parse (&color, job->primary_color))
+                        return NULL;
+                break;
+        default:
+                return NULL;
+        }
+
+        /* Slideshows aren't images */
+        if (!gdk_pixbuf_get_file_info (job->filename, &image_width, &image_height) ||
+            image_width <= 0 || image_height <= 0)
+                return NULL;
+
+        dest_width = job->scale_factor * job->width;
+        dest_height = job->scale_factor * job->height;
+
+        /* The image may be rotated by its EXIF orientation, which is only
+         * known once decoded, so make its shortest side cover the thumbnail */
+        scale_x = (double) MAX (dest_width, dest_height) / MIN (image_width, image_height);
+        if (scale_x < 1.0)
+                decoded = gdk_pixbuf_new_from_file_at_scale (job->filename,
+                                                             MAX (1, (int) ceil (image_width * scale_x)),
+                                                             MAX (1, (int) ceil (image_height * scale_x)),
+                                                             FALSE,
+                                                             &error);
+        else
+                decoded = gdk_pixbuf_new_from_file (job->filename, &error);
+
+        if (!decoded) {
+                g_debug ("Failed to load %s: %s", job->filename, error->message);
+                return NULL;
+        }
 
-        if (frame >= 0) {
+        /* Transparent images show the shading, which is left to gnome-bg */
+        if (gdk_pixbuf_get_has_alpha (decoded))
+                return NULL;
+
+        oriented = gdk_pixbuf_apply_embedded_orientation (decoded);
+        image_width = gdk_pixbuf_get_width (oriented);
+        image_height = gdk_pixbuf_get_height (oriented);
+
+        pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, dest_width, dest_height);
+        if (!pixbuf)
+                return NULL;
+
+        scale_x = (double) dest_width / image_width;
+        scale_y = (double) dest_height / image_height;
+
+        switch (job->placement) {
+        case G_DESKTOP_BACKGROUND_STYLE_STRETCHED:
+                break;
+        case G_DESKTOP_BACKGROUND_STYLE_SCALED:
+                scale_x = scale_y = MIN (scale_x, scale_y);
+                gdk_pixbuf_fill (pixbuf,
+                                 ((guint32) (color.red * 255) << 24) |
+                                 ((guint32) (color.green * 255) << 16) |
+                                 ((guint32) (color.blue * 255) << 8) |
+                                 0xff);
+                break;
+        default:
+                scale_x = scale_y = MAX (scale_x, scale_y);
+                break;
+        }
+
+        gdk_pixbuf_composite (oriented,
+                              pixbuf,
+                              MAX (0, (int) floor ((dest_width - image_width * scale_x) / 2.0)),
+                              MAX (0, (int) floor ((dest_height - image_height * scale_y) / 2.0)),
+                              MIN (dest_width, (int) ceil (image_width * scale_x)),
+                              MIN (dest_height, (int) ceil (image_height * scale_y)),
+                              (dest_width - image_width * scale_x) / 2.0,
+                              (dest_height - image_height * scale_y) / 2.0,
+                              scale_x,
+                              scale_y,
+                              GDK_INTERP_BILINEAR,
+                              255);
+
+        return pixbuf;
+}
+
+static GdkPixbuf *
+create_thumbnail (ThumbnailJob *job,
+                  GnomeBG      *bg,
+                  GCancellable *cancellable)
+{
+        g_autofree gchar *disk_cache_path = NULL;
+        g_autofree gchar *disk_cache_prefix = NULL;
+        GdkPixbuf *pixbuf;
+
+        /* Telling whether it is a slideshow may mean parsing it */
+        job->disk_cache_key = get_disk_cache_key (job, bg);
+
+        if (job->disk_cache_key) {
+                disk_cache_path = get_disk_cache_path (job, &disk_cache_prefix);
+
+                pixbuf = disk_cache_path ? load_disk_thumbnail (disk_cache_path) : NULL;
+                if (pixbuf)
+                        return pixbuf;
+        }
+
+        if (job->filename && job->frame < 0) {
+                pixbuf = create_scaled_thumbnail (job);
+                if (pixbuf) {
+                        if (disk_cache_path)
+                                save_disk_thumbnail (disk_cache_path, disk_cache_prefix, pixbuf);
+                        return pixbuf;
+                }
+
+                prepare_factory_thumbnail (job->thumbs, job->filename, cancellable);
+        }
+
+        if (g_cancellable_is_cancelled (cancellable))
+                return NULL;
+
+        if (job->frame >= 0) {
                 pixbuf = gnome_bg_create_frame_thumbnail (bg,
-                                                          thumbs,
-                                                          &monitor_layout,
-                                                          scale_factor * width,
-                                                          scale_factor * height,
-                                                          frame);
+                                                          job->thumbs,
+                                                          &job->monitor_layout,
+                                                          job->scale_factor * job->width,
+                                                          job->scale_factor * job->height,
+                                                          job->frame);
         } else {
                 pixbuf = gnome_bg_create_thumbnail (bg,
-                                                    thumbs,
-                                                    &monitor_layout,
-                                                    scale_factor * width,
-                                                    scale_factor * height);
+                                                    job->thumbs,
+                                                    &job->monitor_layout,
+                                                    job->scale_factor * job->width,
+                                                    job->scale_factor * job->height);
         }
 
+        if (pixbuf && disk_cache_path)
+                save_disk_thumbnail (disk_cache_path, disk_cache_prefix, pixbuf);
+
+        return pixbuf;
+}
+
+/* Only uses the job, so it can run in any thread. GnomeBG isn't
+ * thread-safe, and monitors its file once configured, so the job's
+ * GnomeBG is created, used and destroyed here, with its monitors
+ * attached to a context of its own which is never iterated. */
+static GdkPixbuf *
+run_thumbnail_job (ThumbnailJob *job,
+                   GCancellable *cancellable)
+{
+        g_autoptr(GMainContext) context = NULL;
+        GnomeBG *bg;
+        GdkPixbuf *pixbuf;
+
+        context = g_main_context_new ();
+        g_main_context_push_thread_default (context);
+
+        bg = gnome_bg_new ();
+        configure_bg (bg, job->uri, job->placement, job->shading,
+                      job->primary_color, job->secondary_color);
+
+        pixbuf = create_thumbnail (job, bg, cancellable);
+
+        g_object_unref (bg);
+        g_main_context_pop_thread_default (context);
+
+        return pixbuf;
+}
+
+GdkPixbuf *
+cc_background_item_get_frame_thumbnail (CcBackgroundItem             *item,
+                                        GnomeDesktopThumbnailFactory *thumbs,
+                                        int                           width,
+                                        int                           height,
+                                        int                           scale_factor,
+                                        int                           frame,
+                                        gboolean                      dark)
+{
+        g_autoptr(ThumbnailJob) job = NULL;
+        CachedThumbnail *thumbnail;
+        GdkPixbuf *pixbuf;
+
+	g_return_val_if_fail (CC_IS_BACKGROUND_ITEM (item), NULL);
+	g_return_val_if_fail (width > 0 && height > 0, NULL);
+
+        thumbnail = get_cached_thumbnail (item, width, height, scale_factor, frame, dark);
+        if (thumbnail)
+                return g_object_ref (thumbnail->thumbnail);
+
+        job = thumbnail_job_new (item, thumbs, width, height, scale_factor, frame, dark);
+        pixbuf = run_thumbnail_job (job, NULL);
+
         update_size (item);
 
         /* Cache the new thumbnail */
-        g_set_object (&thumbnail->thumbnail, pixbuf);
-        thumbnail->width = width;
-        thumbnail->height = height;
-        thumbnail->scale_factor = scale_factor;
-        thumbnail->frame = frame;
+        cache_thumbnail (item, pixbuf, width, height, scale_factor, frame, dark);
 
         return pixbuf;
 }
@@ -261,6 +798,185 @@ cc_background_item_get_thumbnail (CcBackgroundItem             *item,
         return cc_background_item_get_frame_thumbnail (item, thumbs, width, height, scale_factor, -1, dark);
 }
 
+static gboolean
+thumbnail_job_done_cb (gpointer user_data)
+{
+        g_autoptr(GTask) task = user_data;
+        CcBackgroundItem *item = g_task_get_source_object (task);
+        ThumbnailJob *job = g_task_get_task_data (task);
+
+        if (!job->pixbuf) {
+                if (job->dark)
+                        item->thumbnail_failed_dark = TRUE;
+                else
+                        item->thumbnail_failed = TRUE;
+
+                g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                                         "Failed to create thumbnail");
+                return G_SOURCE_REMOVE;
+        }
+
+        update_size (item);
+        cache_thumbnail (item, job->pixbuf, job->width, job->height, job->scale_factor, job->frame, job->dark);
+
+        g_task_return_pointer (task, g_object_ref (job->pixbuf), g_object_unref);
+
+        return G_SOURCE_REMOVE;
+}
+
+static void
+thumbnail_thread (gpointer data,
+                  gpointer user_data)
+{
+        g_autoptr(GTask) task = data;
+        ThumbnailJob *job = g_task_get_task_data (task);
+
+        /* The widget may have gone away while the job was queued */
+        if (g_task_return_error_if_cancelled (task))
+                return;
+
+        job->pixbuf = run_thumbnail_job (job, g_task_get_cancellable (task));
+
+        if (g_task_return_error_if_cancelled (task))
+                return;
+
+        /* The item is only touched from the main thread */
+        g_main_context_invoke (g_task_get_context (task),
+                               thumbnail_job_done_cb,
+                               g_steal_pointer (&task));
+}
+
+static GThreadPool *
+get_thumbnail_pool (void)
+{
+        static GThreadPool *pool = NULL;
+
+        if (g_once_init_enter (&pool)) {
+                GThreadPool *new_pool;
+
+                new_pool = g_thread_pool_new (thumbnail_thread,
+                                              NULL,
+                                              MIN (g_get_num_processors (), MAX_THUMBNAIL_THREADS),
+                                              FALSE,
+                                              NULL);
+
+                g_once_init_leave (&pool, new_pool);
+        }
+
+        return pool;
+}
+
+/**
+ * cc_background_item_get_thumbnail_async:
+ * @item: a #CcBackgroundItem
+ * @thumbs: the thumbnail factory to use
+ * @width: the width of the thumbnail, in logical pixels
+ * @height: the height of the thumbnail, in logical pixels
+ * @scale_factor: the scale factor of the thumbnail
+ * @dark: whether to create a thumbnail of the dark version
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: the function to call when the thumbnail is ready
+ * @user_data: data for @callback
+ *
+ * Like cc_background_item_get_thumbnail(), but decodes and scales the
+ * image in a worker thread. Cancelling @cancellable drops the job if it
+ * didn't start yet.
+ */
+void
+cc_background_item_get_thumbnail_async (CcBackgroundItem             *item,
+                                        GnomeDesktopThumbnailFactory *thumbs,
+                                        int                           width,
+                                        int                           height,
+                                        int                           scale_factor,
+                                        gboolean                      dark,
+                                        GCancellable                 *cancellable,
+                                        GAsyncReadyCallback           callback,
+                                        gpointer                      user_data)
+{
+        g_autoptr(GTask) task = NULL;
+        CachedThumbnail *thumbnail;
+
+        g_return_if_fail (CC_IS_BACKGROUND_ITEM (item));
+        g_return_if_fail (GNOME_DESKTOP_IS_THUMBNAIL_FACTORY (thumbs));
+        g_return_if_fail (width > 0 && height > 0);
+
+        task = g_task_new (item, cancellable, callback, user_data);
+        g_task_set_source_tag (task, cc_background_item_get_thumbnail_async);
+
+        thumbnail = get_cached_thumbnail (item, width, height, scale_factor, -1, dark);
+        if (thumbnail) {
+                g_task_return_pointer (task, g_object_ref (thumbnail->thumbnail), g_object_unref);
+                return;
+        }
+
+        if (dark ? item->thumbnail_failed_dark : item->thumbnail_failed) {
+                g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                                         "Creating the thumbnail failed before");
+                return;
+        }
+
+        g_task_set_task_data (task,
+                              thumbnail_job_new (item, thumbs, width, height, scale_factor, -1, dark),
+                              (GDestroyNotify) thumbnail_job_free);
+
+        g_thread_pool_push (get_thumbnail_pool (), g_steal_pointer (&task), NULL);
+}
+
+/**
+ * cc_background_item_get_thumbnail_finish:
+ * @item: a #CcBackgroundItem
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for a #GError
+ *
+ * Returns: (transfer full): the thumbnail, or %NULL on error
+ */
+GdkPixbuf *
+cc_background_item_get_thumbnail_finish (CcBackgroundItem  *item,
+                                         GAsyncResult      *result,
+                                         GError           **error)
+{
+        g_return_val_if_fail (g_task_is_valid (result, item), NULL);
+
+        return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * cc_background_item_remove_cached_thumbnails:
+ * @item: a #CcBackgroundItem
+ *
+ * Removes the thumbnails of @item kept on disk, for instance because its
+ * file was deleted.
+ */
+void
+cc_background_item_remove_cached_thumbnails (CcBackgroundItem *item)
+{
+        const char *uris[2];
+        guint i;
+
+        g_return_if_fail (CC_IS_BACKGROUND_ITEM (item));
+
+        uris[0] = item->uri;
+        uris[1] = item->uri_dark;
+
+        for (i = 0; i < G_N_ELEMENTS (uris); i++) {
+                g_autoptr(GFile) file = NULL;
+                g_autofree gchar *filename = NULL;
+                g_autofree gchar *dir = NULL;
+
+                if (!uris[i])
+                        continue;
+
+                file = g_file_new_for_commandline_arg (uris[i]);
+                filename = g_file_get_path (file);
+                if (!filename)
+                        continue;
+
+                dir = get_disk_cache_dir (filename);
+                remove_disk_thumbnails (dir, NULL);
+                g_rmdir (dir);
+        }
+}
+
 static void
 update_info (CcBackgroundItem *item,
 	     GFileInfo        *_info)
@@ -374,6 +1090,7 @@ _set_uri (CcBackgroundItem *item,
 			g_warning ("URI '%s' is invalid", value);
 		item->uri = g_strdup (value);
 	}
+        item->thumbnail_failed = FALSE;
         _add_flag (item, CC_BACKGROUND_ITEM_HAS_URI);
 }
 
@@ -390,6 +1107,7 @@ _set_uri_dark (CcBackgroundItem *item,
 			g_warning ("URI '%s' is invalid", value);
 		item->uri_dark = g_strdup (value);
 	}
+        item->thumbnail_failed_dark = FALSE;
         _add_flag (item, CC_BACKGROUND_ITEM_HAS_URI_DARK);
 }
 
@@ -58,6 +58,18 @@ GdkPixbuf *        cc_background_item_get_thumbnail       (CcBackgroundItem
                                                            int                           height,
                                                            int                           scale_factor,
                                                            gboolean                      dark);
+void               cc_background_item_get_thumbnail_async (CcBackgroundItem             *item,
+                                                           GnomeDesktopThumbnailFactory *thumbs,
+                                                           int                           width,
+                                                           int                           height,
+                                                           int                           scale_factor,
+                                                           gboolean                      dark,
+                                                           GCancellable                 *cancellable,
+                                                           GAsyncReadyCallback           callback,
+                                                           gpointer                      user_data);
+GdkPixbuf *        cc_background_item_get_thumbnail_finish (CcBackgroundItem            *item,
+                                                            GAsyncResult                *result,
+                                                            GError                     **error);
 GdkPixbuf *        cc_background_item_get_frame_thumbnail (CcBackgroundItem             *item,
                                                            GnomeDesktopThumbnailFactory *thumbs,
                                                            int                           width,
@@ -65,6 +77,7 @@ GdkPixbuf *        cc_background_item_get_frame_thumbnail (CcBackgroundItem
                                                            int                           scale_factor,
                                                            int                           frame,
                                                            gboolean                      dark);
+void               cc_background_item_remove_cached_thumbnails (CcBackgroundItem        *item);
 
 GDesktopBackgroundStyle   cc_background_item_get_placement  (CcBackgroundItem *item);
 GDesktopBackgroundShading cc_background_item_get_shading    (CcBackgroundItem *item);
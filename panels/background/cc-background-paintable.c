@@ -36,6 +36,12 @@ struct _CcBackgroundPaintable
   GdkPaintable     *texture;
   GdkPaintable     *dark_texture;
 
+  /* Thumbnails are only requested when first drawn */
+  gboolean          thumbnails_requested;
+  guint             n_pending_thumbnails;
+  gboolean          thumbnails_failed;
+  GCancellable     *cancellable;
+
   CcBackgroundPaintFlags  paint_flags;
 };
 
@@ -60,64 +66,134 @@ G_DEFINE_TYPE_WITH_CODE (CcBackgroundPaintable, cc_background_paintable, G_TYPE_
                          G_IMPLEMENT_INTERFACE (GDK_TYPE_PAINTABLE,
                                                 cc_background_paintable_paintable_init))
 
+/* Drawn until the thumbnails arrive */
+static const GdkRGBA placeholder_color = { 0.5, 0.5, 0.5, 0.2 };
+
+/* Drawn over the placeholder when no thumbnail could be created */
+#define BROKEN_IMAGE_ICON_SIZE 32
+
 static void
-update_cache (CcBackgroundPaintable *self)
+thumbnail_ready_cb (GObject      *source_object,
+                    GAsyncResult *result,
+                    gpointer      user_data,
+                    gboolean      dark)
 {
+  g_autoptr(GdkTexture) texture = NULL;
   g_autoptr(GdkPixbuf) pixbuf = NULL;
-  g_autoptr(GdkPixbuf) dark_pixbuf = NULL;
+  g_autoptr(GError) error = NULL;
+  CcBackgroundPaintable *self;
+
+  pixbuf = cc_background_item_get_thumbnail_finish (CC_BACKGROUND_ITEM (source_object), result, &error);
+
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = CC_BACKGROUND_PAINTABLE (user_data);
+  self->n_pending_thumbnails--;
+
+  if (!pixbuf)
+    {
+      g_warning ("Failed to create thumbnail for %s: %s",
+                 cc_background_item_get_name (self->item),
+                 error->message);
+
+      self->thumbnails_failed = TRUE;
+      gdk_paintable_invalidate_contents (GDK_PAINTABLE (self));
+      return;
+    }
+
+  texture = gdk_texture_new_for_pixbuf (pixbuf);
+  g_set_object (dark ? &self->dark_texture : &self->texture, GDK_PAINTABLE (texture));
+
+  gdk_paintable_invalidate_contents (GDK_PAINTABLE (self));
+}
+
+static void
+light_thumbnail_ready_cb (GObject      *source_object,
+                          GAsyncResult *result,
+                          gpointer      user_data)
+{
+  thumbnail_ready_cb (source_object, result, user_data, FALSE);
+}
+
+static void
+dark_thumbnail_ready_cb (GObject      *source_object,
+                         GAsyncResult *result,
+                         gpointer      user_data)
+{
+  thumbnail_ready_cb (source_object, result, user_data, TRUE);
+}
+
+static void
+request_thumbnails (CcBackgroundPaintable *self)
+{
   gboolean has_dark;
 
-  g_clear_object (&self->texture);
-  g_clear_object (&self->dark_texture);
+  if (self->thumbnails_requested)
+    return;
+
+  self->thumbnails_requested = TRUE;
+  self->cancellable = g_cancellable_new ();
 
   has_dark = cc_background_item_has_dark_version (self->item);
 
   if ((self->paint_flags & CC_BACKGROUND_PAINT_LIGHT) || !has_dark)
     {
-      pixbuf = cc_background_item_get_thumbnail (self->item,
-                                                 self->thumbnail_factory,
-                                                 self->width,
-                                                 self->height,
-                                                 self->scale_factor,
-                                                 FALSE);
-      self->texture = GDK_PAINTABLE (gdk_texture_new_for_pixbuf (pixbuf));
+      self->n_pending_thumbnails++;
+      cc_background_item_get_thumbnail_async (self->item,
+                                              self->thumbnail_factory,
+                                              self->width,
+                                              self->height,
+                                              self->scale_factor,
+                                              FALSE,
+                                              self->cancellable,
+                                              light_thumbnail_ready_cb,
+                                              self);
     }
 
   if ((self->paint_flags & CC_BACKGROUND_PAINT_DARK) && has_dark)
     {
-      dark_pixbuf = cc_background_item_get_thumbnail (self->item,
-                                                      self->thumbnail_factory,
-                                                      self->width,
-                                                      self->height,
-                                                      self->scale_factor,
-                                                      TRUE);
-      self->dark_texture = GDK_PAINTABLE (gdk_texture_new_for_pixbuf (dark_pixbuf));
+      self->n_pending_thumbnails++;
+      cc_background_item_get_thumbnail_async (self->item,
+                                              self->thumbnail_factory,
+                                              self->width,
+                                              self->height,
+                                              self->scale_factor,
+                                              TRUE,
+                                              self->cancellable,
+                                              dark_thumbnail_ready_cb,
+                                              self);
     }
-
-  gdk_paintable_invalidate_size (GDK_PAINTABLE (self));
 }
 
 static void
-cc_background_paintable_dispose (GObject *object)
+update_cache (CcBackgroundPaintable *self)
 {
-  CcBackgroundPaintable *self = CC_BACKGROUND_PAINTABLE (object);
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+  self->thumbnails_requested = FALSE;
+  self->n_pending_thumbnails = 0;
+  self->thumbnails_failed = FALSE;
 
-  g_clear_object (&self->item);
-  g_clear_object (&self->thumbnail_factory);
   g_clear_object (&self->texture);
   g_clear_object (&self->dark_texture);
 
-  G_OBJECT_CLASS (cc_background_paintable_parent_class)->dispose (object);
+  gdk_paintable_invalidate_contents (GDK_PAINTABLE (self));
 }
 
 static void
-cc_background_paintable_constructed (GObject *object)
+cc_background_paintable_dispose (GObject *object)
 {
   CcBackgroundPaintable *self = CC_BACKGROUND_PAINTABLE (object);
 
-  G_OBJECT_CLASS (cc_background_paintable_parent_class)->constructed (object);
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+  g_clear_object (&self->item);
+  g_clear_object (&self->thumbnail_factory);
+  g_clear_object (&self->texture);
+  g_clear_object (&self->dark_texture);
 
-  update_cache (self);
+  G_OBJECT_CLASS (cc_background_paintable_parent_class)->dispose (object);
 }
 
 static void
@@ -190,6 +266,8 @@ cc_background_paintable_set_property (GObject      *object,
       break;
 
     case PROP_SCALE_FACTOR:
+      if (self->scale_factor == g_value_get_int (value))
+        break;
       self->scale_factor = g_value_get_int (value);
       update_cache (self);
       break;
@@ -214,7 +292,6 @@ cc_background_paintable_class_init (CcBackgroundPaintableClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->dispose = cc_background_paintable_dispose;
-  object_class->constructed = cc_background_paintable_constructed;
   object_class->get_property = cc_background_paintable_get_property;
   object_class->set_property = cc_background_paintable_set_property;
 
@@ -291,6 +368,34 @@ cc_background_paintable_init (CcBackgroundPaintable *self)
   self->text_direction = GTK_TEXT_DIR_LTR;
 }
 
+static void
+snapshot_broken_image (CcBackgroundPaintable *self,
+                       GdkSnapshot           *snapshot,
+                       double                 width,
+                       double                 height)
+{
+  g_autoptr(GtkIconPaintable) icon = NULL;
+  GtkIconTheme *icon_theme;
+  double size;
+
+  size = MIN (BROKEN_IMAGE_ICON_SIZE, MIN (width, height));
+
+  icon_theme = gtk_icon_theme_get_for_display (gdk_display_get_default ());
+  icon = gtk_icon_theme_lookup_icon (icon_theme,
+                                     "image-missing-symbolic",
+                                     NULL,
+                                     size,
+                                     self->scale_factor,
+                                     self->text_direction,
+                                     0);
+
+  gtk_snapshot_save (GTK_SNAPSHOT (snapshot));
+  gtk_snapshot_translate (GTK_SNAPSHOT (snapshot),
+                          &GRAPHENE_POINT_INIT ((width - size) / 2.0f, (height - size) / 2.0f));
+  gdk_paintable_snapshot (GDK_PAINTABLE (icon), snapshot, size, size);
+  gtk_snapshot_restore (GTK_SNAPSHOT (snapshot));
+}
+
 static void
 cc_background_paintable_snapshot (GdkPaintable *paintable,
                                   GdkSnapshot  *snapshot,
@@ -300,6 +405,19 @@ cc_background_paintable_snapshot (GdkPaintable *paintable,
   CcBackgroundPaintable *self = CC_BACKGROUND_PAINTABLE (paintable);
   gboolean is_rtl;
 
+  if (!self->texture && !self->dark_texture)
+    {
+      request_thumbnails (self);
+      gtk_snapshot_append_color (GTK_SNAPSHOT (snapshot),
+                                 &placeholder_color,
+                                 &GRAPHENE_RECT_INIT (0.0f, 0.0f, width, height));
+
+      if (self->thumbnails_failed && self->n_pending_thumbnails == 0)
+        snapshot_broken_image (self, snapshot, width, height);
+
+      return;
+    }
+
   if (!self->dark_texture)
     {
       gdk_paintable_snapshot (self->texture, snapshot, width, height);
@@ -337,6 +455,9 @@ cc_background_paintable_get_intrinsic_width (GdkPaintable *paintable)
   CcBackgroundPaintable *self = CC_BACKGROUND_PAINTABLE (paintable);
   GdkPaintable *valid_texture = self->texture ? self->texture : self->dark_texture;
 
+  if (!valid_texture)
+    return self->width;
+
   return gdk_paintable_get_intrinsic_width (valid_texture) / self->scale_factor;
 }
 
@@ -346,6 +467,9 @@ cc_background_paintable_get_intrinsic_height (GdkPaintable *paintable)
   CcBackgroundPaintable *self = CC_BACKGROUND_PAINTABLE (paintable);
   GdkPaintable *valid_texture = self->texture ? self->texture : self->dark_texture;
 
+  if (!valid_texture)
+    return self->height;
+
   return gdk_paintable_get_intrinsic_height (valid_texture) / self->scale_factor;
 }
 
@@ -355,6 +479,9 @@ cc_background_paintable_get_intrinsic_aspect_ratio (GdkPaintable *paintable)
   CcBackgroundPaintable *self = CC_BACKGROUND_PAINTABLE (paintable);
   GdkPaintable *valid_texture = self->texture ? self->texture : self->dark_texture;
 
+  if (!valid_texture)
+    return (double) self->width / self->height;
+
   return gdk_paintable_get_intrinsic_aspect_ratio (valid_texture);
 }
 
@@ -388,3 +515,20 @@ cc_background_paintable_new (GnomeDesktopThumbnailFactory *thumbnail_factory,
                        "height", height,
                        NULL);
 }
+
+/**
+ * cc_background_paintable_cancel_thumbnails:
+ * @self: a #CcBackgroundPaintable
+ *
+ * Cancels the creation of the thumbnails that didn't arrive yet, for
+ * instance because the widget showing @self is not visible anymore. They
+ * are requested again the next time @self is drawn.
+ */
+void
+cc_background_paintable_cancel_thumbnails (CcBackgroundPaintable *self)
+{
+  g_return_if_fail (CC_IS_BACKGROUND_PAINTABLE (self));
+
+  if (self->n_pending_thumbnails > 0)
+    update_cache (self);
+}
@@ -44,4 +44,6 @@ CcBackgroundPaintable * cc_background_paintable_new (GnomeDesktopThumbnailFactor
                                                      int                           width,
                                                      int                           height);
 
+void                    cc_background_paintable_cancel_thumbnails (CcBackgroundPaintable *self);
+
 G_END_DECLS
@@ -22,57 +22,53 @@
 #include <gio/gio.h>
 #include <string.h>
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 #include <gdesktop-enums.h>
 
 #include "gdesktop-enums-types.h"
 #include "cc-background-item.h"
 #include "cc-background-xml.h"
 
-/* The number of items we signal as "added" before
- * returning to the main loop */
-#define NUM_ITEMS_PER_BATCH 1
+/* Files are parsed by up to this many threads at once */
+#define MAX_PARSER_THREADS 4
+
+/* Items parsed in threads are collected for this long before
+ * being signalled as a single batch */
+#define BATCH_INTERVAL_MS 100
 
 struct _CcBackgroundXml
 {
   GObject      parent_instance;
 
   GHashTable  *wp_hash;
-  GAsyncQueue *item_added_queue;
-  guint        item_added_id;
   GSList      *monitors; /* GSList of GFileMonitor */
 };
 
 enum {
-	ADDED,
+	ITEMS_ADDED,
 	LAST_SIGNAL
 };
 
-static guint signals[LAST_SIGNAL] = { 0 };
+typedef struct {
+  gchar            *id;
+  CcBackgroundItem *item;
+} ParsedItem;
 
-G_DEFINE_TYPE (CcBackgroundXml, cc_background_xml, G_TYPE_OBJECT)
+/* Shared between the threads of a cc_background_xml_load_list_async() call */
+typedef struct {
+  CcBackgroundXml *xml;
+  GMainContext    *context;
+  GCancellable    *cancellable;
+  GPtrArray       *directories; /* GFile */
 
-static gboolean
-cc_background_xml_get_bool (const xmlNode *parent,
-			    const gchar   *prop_name)
-{
-  xmlChar *prop;
-  gboolean ret_val = FALSE;
+  GMutex           lock;
+  GPtrArray       *pending_items; /* ParsedItem */
+  GSource         *batch_source;
+} LoadData;
 
-  g_return_val_if_fail (parent != NULL, FALSE);
-  g_return_val_if_fail (prop_name != NULL, FALSE);
-
-  prop = xmlGetProp ((xmlNode *) parent, (xmlChar*)prop_name);
-  if (prop != NULL) {
-    if (!g_ascii_strcasecmp ((gchar *)prop, "true") || !g_ascii_strcasecmp ((gchar *)prop, "1")) {
-      ret_val = TRUE;
-    } else {
-      ret_val = FALSE;
-    }
-    xmlFree (prop);
-  }
+static guint signals[LAST_SIGNAL] = { 0 };
 
-  return ret_val;
-}
+G_DEFINE_TYPE (CcBackgroundXml, cc_background_xml, G_TYPE_OBJECT)
 
 static struct {
 	int value;
@@ -107,230 +103,311 @@ enum_string_to_value (GType type,
 	return value->value;
 }
 
+static void
+parsed_item_free (ParsedItem *parsed)
+{
+  g_free (parsed->id);
+  g_object_unref (parsed->item);
+  g_free (parsed);
+}
+
+/* Returns the stripped text content of the element the reader is on */
+static gchar *
+read_element_text (xmlTextReaderPtr reader)
+{
+  xmlChar *text;
+  gchar *ret;
+
+  if (xmlTextReaderIsEmptyElement (reader))
+    return NULL;
+
+  text = xmlTextReaderReadString (reader);
+  if (text == NULL)
+    return NULL;
+
+  ret = g_strdup (g_strstrip ((gchar *) text));
+  xmlFree (text);
+
+  return ret;
+}
+
 static gboolean
-idle_emit (CcBackgroundXml *xml)
+read_bool_attribute (xmlTextReaderPtr  reader,
+		     const gchar      *name)
 {
-	gint i;
+  xmlChar *prop;
+  gboolean ret_val = FALSE;
 
-	g_async_queue_lock (xml->item_added_queue);
+  prop = xmlTextReaderGetAttribute (reader, (xmlChar *) name);
+  if (prop != NULL) {
+    ret_val = !g_ascii_strcasecmp ((gchar *) prop, "true") || !g_ascii_strcasecmp ((gchar *) prop, "1");
+    xmlFree (prop);
+  }
 
-	for (i = 0; i < NUM_ITEMS_PER_BATCH; i++) {
-		g_autoptr(GObject) item = NULL;
+  return ret_val;
+}
 
-		item = g_async_queue_try_pop_unlocked (xml->item_added_queue);
-		if (item == NULL)
-			break;
-		g_signal_emit (G_OBJECT (xml), signals[ADDED], 0, item);
-	}
+#define NONE "(none)"
 
-	g_async_queue_unlock (xml->item_added_queue);
+static gchar *
+resolve_uri (const gchar *content,
+	     const gchar *dirname)
+{
+  g_autoptr(GFile) file = NULL;
 
-        if (g_async_queue_length (xml->item_added_queue) > 0) {
-                return TRUE;
-        } else {
-                xml->item_added_id = 0;
-                return FALSE;
-        }
+  /* FIXME same rubbish as in other parts of the code */
+  if (strcmp (content, NONE) == 0)
+    return NULL;
+
+  file = g_file_new_for_commandline_arg_and_cwd (content, dirname);
+  return g_file_get_uri (file);
 }
 
+typedef struct {
+  const gchar      *filename;
+  const gchar      *file_uri;
+  const gchar      *dirname;
+  GPtrArray        *items;
+
+  CcBackgroundItem *item;
+  gchar            *cname;
+  gchar            *name;
+  guint             name_rank;
+  gchar            *bg_uri;
+  gchar            *bg_uri_dark;
+  gboolean          truncated;
+} ParseState;
+
 static void
-emit_added_in_idle (CcBackgroundXml *xml,
-		    GObject         *object)
+begin_wallpaper (ParseState       *state,
+		 xmlTextReaderPtr  reader)
 {
-	g_async_queue_lock (xml->item_added_queue);
-	g_async_queue_push_unlocked (xml->item_added_queue, object);
-	if (xml->item_added_id == 0)
-		xml->item_added_id = g_idle_add ((GSourceFunc) idle_emit, xml);
-	g_async_queue_unlock (xml->item_added_queue);
+  state->item = cc_background_item_new (NULL);
+  state->name_rank = G_MAXUINT;
+  state->truncated = FALSE;
+
+  g_object_set (G_OBJECT (state->item),
+		"is-deleted", read_bool_attribute (reader, "deleted"),
+		"source-xml", state->filename,
+		NULL);
 }
 
-#define NONE "(none)"
+static void
+end_wallpaper (ParseState *state)
+{
+  g_autoptr(CcBackgroundItem) item = g_steal_pointer (&state->item);
+  g_autofree gchar *cname = g_steal_pointer (&state->cname);
+  g_autofree gchar *name = g_steal_pointer (&state->name);
+  g_autofree gchar *bg_uri = g_steal_pointer (&state->bg_uri);
+  g_autofree gchar *bg_uri_dark = g_steal_pointer (&state->bg_uri_dark);
+  const char *uri;
+  ParsedItem *parsed;
+
+  if (name != NULL)
+    g_object_set (G_OBJECT (item), "name", name, NULL);
+
+  /* Check whether the target file exists */
+  uri = cc_background_item_get_uri (item);
+  if (uri != NULL) {
+    g_autoptr(GFile) file = NULL;
+
+    file = g_file_new_for_uri (uri);
+    if (g_file_query_exists (file, NULL) == FALSE)
+      return;
+  }
 
-static gboolean
-cc_background_xml_load_xml_internal (CcBackgroundXml *xml,
-				     const gchar     *filename,
-				     gboolean         in_thread)
+  parsed = g_new0 (ParsedItem, 1);
+  parsed->item = g_steal_pointer (&item);
+
+  /* FIXME, this is a broken way of doing,
+   * need to use proper code here */
+  if (bg_uri || bg_uri_dark)
+    parsed->id = g_strdup_printf ("%s#%s#%s", state->file_uri, cname, bg_uri ? bg_uri : bg_uri_dark);
+  else
+    parsed->id = g_strdup_printf ("%s#%s", state->file_uri, cname);
+
+  g_ptr_array_add (state->items, parsed);
+}
+
+static void
+parse_wallpaper_property (ParseState       *state,
+			  xmlTextReaderPtr  reader)
 {
-  xmlDoc * wplist;
-  xmlNode * root, * list, * wpa;
-  xmlChar * nodelang;
-  const gchar * const * syslangs;
-  gint i;
-  gboolean retval;
-
-  wplist = xmlParseFile (filename);
-  retval = FALSE;
-
-  if (!wplist)
-    return retval;
-
-  syslangs = g_get_language_names ();
-
-  root = xmlDocGetRootElement (wplist);
-
-  for (list = root->children; list != NULL; list = list->next) {
-    if (!strcmp ((gchar *)list->name, "wallpaper")) {
-      g_autoptr(CcBackgroundItem) item = NULL;
-      g_autofree gchar *uri = NULL;
-      g_autofree gchar *cname = NULL;
-      g_autofree gchar *id = NULL;
-      g_autofree gchar *bg_uri = NULL;
-      g_autofree gchar *bg_uri_dark = NULL;
-
-      item = cc_background_item_new (NULL);
-
-      g_object_set (G_OBJECT (item),
-		    "is-deleted", cc_background_xml_get_bool (list, "deleted"),
-		    "source-xml", filename,
-		    NULL);
-
-      for (wpa = list->children; wpa != NULL; wpa = wpa->next) {
-	if (wpa->type == XML_COMMENT_NODE) {
-	  continue;
-	} else if (!strcmp ((gchar *)wpa->name, "filename")) {
-	  if (wpa->last != NULL && wpa->last->content != NULL) {
-	    gchar *content = g_strstrip ((gchar *)wpa->last->content);
-
-	    /* FIXME same rubbish as in other parts of the code */
-	    if (strcmp (content, NONE) == 0) {
-	      bg_uri = NULL;
-	    } else {
-	      g_autoptr(GFile) file = NULL;
-	      g_autofree gchar *dirname = NULL;
-
-	      dirname = g_path_get_dirname (filename);
-	      file = g_file_new_for_commandline_arg_and_cwd (content, dirname);
-	      bg_uri = g_file_get_uri (file);
-	    }
-	    g_object_set (G_OBJECT (item), "uri", bg_uri, NULL);
-	  } else {
-	    break;
-	  }
-	} else if (!strcmp ((gchar *)wpa->name, "filename-dark")) {
-	  if (wpa->last != NULL && wpa->last->content != NULL) {
-	    gchar *content = g_strstrip ((gchar *)wpa->last->content);
-
-	    /* FIXME same rubbish as in other parts of the code */
-	    if (strcmp (content, NONE) == 0) {
-	      bg_uri_dark = NULL;
-	    } else {
-	      g_autoptr(GFile) file = NULL;
-	      g_autofree gchar *dirname = NULL;
-
-	      dirname = g_path_get_dirname (filename);
-	      file = g_file_new_for_commandline_arg_and_cwd (content, dirname);
-	      bg_uri_dark = g_file_get_uri (file);
-	    }
-	    g_object_set (G_OBJECT (item), "uri-dark", bg_uri_dark, NULL);
-	  } else {
-	    break;
-	  }
-	} else if (!strcmp ((gchar *)wpa->name, "name")) {
-	  if (wpa->last != NULL && wpa->last->content != NULL) {
-	    g_autofree gchar *name = NULL;
-	    nodelang = xmlNodeGetLang (wpa->last);
-
-	    g_object_get (G_OBJECT (item), "name", &name, NULL);
-
-	    if (name == NULL && nodelang == NULL) {
-	       g_free (cname);
-	       cname = g_strdup (g_strstrip ((gchar *)wpa->last->content));
-	       g_object_set (G_OBJECT (item), "name", cname, NULL);
-            } else {
-	       for (i = 0; syslangs[i] != NULL; i++) {
-	         if (!strcmp (syslangs[i], (gchar *)nodelang)) {
-		   g_object_set (G_OBJECT (item), "name",
-				 g_strstrip ((gchar *)wpa->last->content), NULL);
-	           break;
-	         }
-	       }
-	    }
-
-	    xmlFree (nodelang);
-	  } else {
-	    break;
-	  }
-	} else if (!strcmp ((gchar *)wpa->name, "options")) {
-	  if (wpa->last != NULL) {
-	    g_object_set (G_OBJECT (item), "placement",
-			  enum_string_to_value (G_DESKTOP_TYPE_BACKGROUND_STYLE,
-						g_strstrip ((gchar *)wpa->last->content)), NULL);
-	  }
-	} else if (!strcmp ((gchar *)wpa->name, "shade_type")) {
-	  if (wpa->last != NULL) {
-	    g_object_set (G_OBJECT (item), "shading",
-			  enum_string_to_value (G_DESKTOP_TYPE_BACKGROUND_SHADING,
-						g_strstrip ((gchar *)wpa->last->content)), NULL);
-	  }
-	} else if (!strcmp ((gchar *)wpa->name, "pcolor")) {
-	  if (wpa->last != NULL) {
-	    g_object_set (G_OBJECT (item), "primary-color",
-			  g_strstrip ((gchar *)wpa->last->content), NULL);
-	  }
-	} else if (!strcmp ((gchar *)wpa->name, "scolor")) {
-	  if (wpa->last != NULL) {
-	    g_object_set (G_OBJECT (item), "secondary-color",
-			  g_strstrip ((gchar *)wpa->last->content), NULL);
-	  }
-	} else if (!strcmp ((gchar *)wpa->name, "source_url")) {
-	   if (wpa->last != NULL) {
-             g_object_set (G_OBJECT (item),
-			   "source-url", g_strstrip ((gchar *)wpa->last->content),
-			   "needs-download", FALSE,
-			   NULL);
-	   }
-	} else if (!strcmp ((gchar *)wpa->name, "text")) {
-	  /* Do nothing here, libxml2 is being weird */
-	} else {
-	  g_debug ("Unknown Tag in %s: %s", filename, wpa->name);
-	}
-      }
+  const gchar *tag = (const gchar *) xmlTextReaderConstName (reader);
+  g_autofree gchar *content = NULL;
+
+  content = read_element_text (reader);
+
+  /* Like the DOM parser this replaced, stop reading properties
+   * after an empty filename or name */
+  if (content == NULL) {
+    if (g_str_equal (tag, "filename") ||
+	g_str_equal (tag, "filename-dark") ||
+	g_str_equal (tag, "name"))
+      state->truncated = TRUE;
+    return;
+  }
 
-      /* Check whether the target file exists */
-      {
-        const char *uri;
-
-	uri = cc_background_item_get_uri (item);
-	if (uri != NULL)
-	  {
-            g_autoptr(GFile) file = NULL;
-
-            file = g_file_new_for_uri (uri);
-	    if (g_file_query_exists (file, NULL) == FALSE)
-	      {
-	        g_clear_pointer (&cname, g_free);
-	        g_clear_object (&item);
-	        continue;
-	      }
-	  }
+  if (g_str_equal (tag, "filename")) {
+    g_free (state->bg_uri);
+    state->bg_uri = resolve_uri (content, state->dirname);
+    g_object_set (G_OBJECT (state->item), "uri", state->bg_uri, NULL);
+  } else if (g_str_equal (tag, "filename-dark")) {
+    g_free (state->bg_uri_dark);
+    state->bg_uri_dark = resolve_uri (content, state->dirname);
+    g_object_set (G_OBJECT (state->item), "uri-dark", state->bg_uri_dark, NULL);
+  } else if (g_str_equal (tag, "name")) {
+    const gchar *nodelang = (const gchar *) xmlTextReaderConstXmlLang (reader);
+
+    if (nodelang == NULL) {
+      g_free (state->cname);
+      state->cname = g_strdup (content);
+      if (state->name == NULL)
+        state->name = g_strdup (content);
+    } else {
+      const gchar * const *syslangs = g_get_language_names ();
+      guint i;
+
+      /* Prefer the translation for the most specific system language */
+      for (i = 0; syslangs[i] != NULL && i < state->name_rank; i++) {
+        if (strcmp (syslangs[i], nodelang) == 0) {
+          g_free (state->name);
+          state->name = g_steal_pointer (&content);
+          state->name_rank = i;
+          break;
+        }
       }
+    }
+  } else if (g_str_equal (tag, "options")) {
+    g_object_set (G_OBJECT (state->item), "placement",
+		  enum_string_to_value (G_DESKTOP_TYPE_BACKGROUND_STYLE, content), NULL);
+  } else if (g_str_equal (tag, "shade_type")) {
+    g_object_set (G_OBJECT (state->item), "shading",
+		  enum_string_to_value (G_DESKTOP_TYPE_BACKGROUND_SHADING, content), NULL);
+  } else if (g_str_equal (tag, "pcolor")) {
+    g_object_set (G_OBJECT (state->item), "primary-color", content, NULL);
+  } else if (g_str_equal (tag, "scolor")) {
+    g_object_set (G_OBJECT (state->item), "secondary-color", content, NULL);
+  } else if (g_str_equal (tag, "source_url")) {
+    g_object_set (G_OBJECT (state->item),
+		  "source-url", content,
+		  "needs-download", FALSE,
+		  NULL);
+  } else {
+    g_debug ("Unknown Tag in %s: %s", state->filename, tag);
+  }
+}
 
-      /* FIXME, this is a broken way of doing,
-       * need to use proper code here */
-      uri = g_filename_to_uri (filename, NULL, NULL);
-      if (bg_uri || bg_uri_dark)
-        id = g_strdup_printf ("%s#%s#%s", uri, cname, bg_uri ? bg_uri : bg_uri_dark);
-      else
-        id = g_strdup_printf ("%s#%s", uri, cname);
-
-      /* Make sure we don't already have this one and that filename exists */
-      if (g_hash_table_lookup (xml->wp_hash, id) != NULL) {
-	continue;
+/*
+ * Parses @filename with a streaming reader, without building a
+ * document tree. This doesn't touch any CcBackgroundXml state, so
+ * it can run in any thread.
+ *
+ * Returns: (transfer full) (nullable): the ParsedItems of the file,
+ *   or %NULL if it isn't a valid wallpaper list.
+ */
+static GPtrArray *
+parse_xml_file (const gchar *filename)
+{
+  g_autoptr(GPtrArray) items = NULL;
+  g_autofree gchar *file_uri = NULL;
+  g_autofree gchar *dirname = NULL;
+  xmlTextReaderPtr reader;
+  ParseState state = { 0 };
+  int ret;
+
+  reader = xmlReaderForFile (filename, NULL, XML_PARSE_NONET);
+  if (reader == NULL)
+    return NULL;
+
+  items = g_ptr_array_new_with_free_func ((GDestroyNotify) parsed_item_free);
+  file_uri = g_filename_to_uri (filename, NULL, NULL);
+  dirname = g_path_get_dirname (filename);
+
+  state.filename = filename;
+  state.file_uri = file_uri;
+  state.dirname = dirname;
+  state.items = items;
+
+  while ((ret = xmlTextReaderRead (reader)) == 1) {
+    int type = xmlTextReaderNodeType (reader);
+    int depth = xmlTextReaderDepth (reader);
+
+    if (depth == 1 &&
+        g_str_equal ((const gchar *) xmlTextReaderConstName (reader), "wallpaper")) {
+      if (type == XML_READER_TYPE_ELEMENT) {
+        begin_wallpaper (&state, reader);
+        if (xmlTextReaderIsEmptyElement (reader))
+          end_wallpaper (&state);
+      } else if (type == XML_READER_TYPE_END_ELEMENT && state.item != NULL) {
+        end_wallpaper (&state);
       }
-
-      g_hash_table_insert (xml->wp_hash,
-                           g_strdup (id),
-                           g_object_ref (item));
-      if (in_thread)
-        emit_added_in_idle (xml, g_object_ref (G_OBJECT (item)));
-      else
-        g_signal_emit (G_OBJECT (xml), signals[ADDED], 0, item);
-      retval = TRUE;
+    } else if (depth == 2 &&
+               type == XML_READER_TYPE_ELEMENT &&
+               state.item != NULL &&
+               !state.truncated) {
+      parse_wallpaper_property (&state, reader);
     }
   }
-  xmlFreeDoc (wplist);
 
-  return retval;
+  xmlFreeTextReader (reader);
+
+  g_clear_object (&state.item);
+  g_clear_pointer (&state.cname, g_free);
+  g_clear_pointer (&state.name, g_free);
+  g_clear_pointer (&state.bg_uri, g_free);
+  g_clear_pointer (&state.bg_uri_dark, g_free);
+
+  if (ret != 0) {
+    g_debug ("Failed to parse %s", filename);
+    return NULL;
+  }
+
+  return g_steal_pointer (&items);
+}
+
+/* Adds the items that aren't known yet, and signals them as one batch */
+static gboolean
+add_parsed_items (CcBackgroundXml *xml,
+		  GPtrArray       *parsed_items)
+{
+  g_autoptr(GPtrArray) added = NULL;
+  guint i;
+
+  added = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (i = 0; i < parsed_items->len; i++) {
+    ParsedItem *parsed = g_ptr_array_index (parsed_items, i);
+
+    /* Make sure we don't already have this one */
+    if (g_hash_table_contains (xml->wp_hash, parsed->id))
+      continue;
+
+    g_hash_table_insert (xml->wp_hash,
+                         g_strdup (parsed->id),
+                         g_object_ref (parsed->item));
+    g_ptr_array_add (added, g_object_ref (parsed->item));
+  }
+
+  if (added->len == 0)
+    return FALSE;
+
+  g_signal_emit (G_OBJECT (xml), signals[ITEMS_ADDED], 0, added);
+
+  return TRUE;
+}
+
+static gboolean
+cc_background_xml_load_xml_internal (CcBackgroundXml *xml,
+				     const gchar     *filename)
+{
+  g_autoptr(GPtrArray) parsed_items = NULL;
+
+  parsed_items = parse_xml_file (filename);
+  if (parsed_items == NULL)
+    return FALSE;
+
+  return add_parsed_items (xml, parsed_items);
 }
 
 static void
@@ -345,7 +422,7 @@ gnome_wp_file_changed (CcBackgroundXml *xml,
   case G_FILE_MONITOR_EVENT_CHANGED:
   case G_FILE_MONITOR_EVENT_CREATED:
     filename = g_file_get_path (file);
-    cc_background_xml_load_xml_internal (xml, filename, FALSE);
+    cc_background_xml_load_xml_internal (xml, filename);
     break;
   default:
     break;
@@ -380,9 +457,79 @@ cc_background_xml_add_monitor (GFile      *directory,
 }
 
 static void
-cc_background_xml_load_from_dir (const gchar      *path,
-				 CcBackgroundXml  *data,
-				 gboolean          in_thread)
+load_data_clear (LoadData *data)
+{
+  g_clear_object (&data->xml);
+  g_clear_pointer (&data->context, g_main_context_unref);
+  g_clear_object (&data->cancellable);
+  g_clear_pointer (&data->directories, g_ptr_array_unref);
+  g_clear_pointer (&data->pending_items, g_ptr_array_unref);
+  g_mutex_clear (&data->lock);
+}
+
+static void
+load_data_unref (LoadData *data)
+{
+  g_atomic_rc_box_release_full (data, (GDestroyNotify) load_data_clear);
+}
+
+/* Runs in the main context, at most every BATCH_INTERVAL_MS */
+static gboolean
+flush_pending_items (gpointer user_data)
+{
+  LoadData *data = user_data;
+  g_autoptr(GPtrArray) parsed_items = NULL;
+
+  g_mutex_lock (&data->lock);
+  parsed_items = g_steal_pointer (&data->pending_items);
+  data->pending_items = g_ptr_array_new_with_free_func ((GDestroyNotify) parsed_item_free);
+  if (data->batch_source != NULL) {
+    g_source_destroy (data->batch_source);
+    g_clear_pointer (&data->batch_source, g_source_unref);
+  }
+  g_mutex_unlock (&data->lock);
+
+  add_parsed_items (data->xml, parsed_items);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Runs in the parser threads */
+static void
+parse_file_func (gpointer data,
+		 gpointer user_data)
+{
+  g_autofree gchar *filename = data;
+  LoadData *load_data = user_data;
+  g_autoptr(GPtrArray) parsed_items = NULL;
+
+  if (g_cancellable_is_cancelled (load_data->cancellable))
+    return;
+
+  parsed_items = parse_xml_file (filename);
+  if (parsed_items == NULL || parsed_items->len == 0)
+    return;
+
+  g_mutex_lock (&load_data->lock);
+
+  g_ptr_array_extend_and_steal (load_data->pending_items, g_steal_pointer (&parsed_items));
+
+  if (load_data->batch_source == NULL) {
+    load_data->batch_source = g_timeout_source_new (BATCH_INTERVAL_MS);
+    g_source_set_callback (load_data->batch_source,
+                           flush_pending_items,
+                           g_atomic_rc_box_acquire (load_data),
+                           (GDestroyNotify) load_data_unref);
+    g_source_attach (load_data->batch_source, load_data->context);
+  }
+
+  g_mutex_unlock (&load_data->lock);
+}
+
+static void
+list_directory (const gchar *path,
+		LoadData    *data,
+		GPtrArray   *filenames)
 {
   g_autoptr(GFile) directory = NULL;
   g_autoptr(GFileEnumerator) enumerator = NULL;
@@ -405,35 +552,32 @@ cc_background_xml_load_from_dir (const gchar      *path,
 
   while (TRUE) {
     g_autoptr(GFileInfo) info = NULL;
-    const gchar *filename;
-    g_autofree gchar *fullpath = NULL;
 
     info = g_file_enumerator_next_file (enumerator, NULL, NULL);
     if (info == NULL) {
         g_file_enumerator_close (enumerator, NULL, NULL);
-        cc_background_xml_add_monitor (directory, data);
+        g_ptr_array_add (data->directories, g_steal_pointer (&directory));
         return;
     }
 
-    filename = g_file_info_get_name (info);
-    fullpath = g_build_filename (path, filename, NULL);
-
-    cc_background_xml_load_xml_internal (data, fullpath, in_thread);
+    g_ptr_array_add (filenames, g_build_filename (path, g_file_info_get_name (info), NULL));
   }
 }
 
-static void
-cc_background_xml_load_list (CcBackgroundXml *data,
-			     gboolean         in_thread)
+static GPtrArray *
+list_files (LoadData *data)
 {
   const char * const *system_data_dirs;
   g_autofree gchar *datadir = NULL;
+  GPtrArray *filenames;
   gint i;
 
+  filenames = g_ptr_array_new_with_free_func (g_free);
+
   datadir = g_build_filename (g_get_user_data_dir (),
                               "gnome-background-properties",
                               NULL);
-  cc_background_xml_load_from_dir (datadir, data, in_thread);
+  list_directory (datadir, data, filenames);
 
   system_data_dirs = g_get_system_data_dirs ();
   for (i = 0; system_data_dirs[i]; i++) {
@@ -441,8 +585,10 @@ cc_background_xml_load_list (CcBackgroundXml *data,
     sdatadir = g_build_filename (system_data_dirs[i],
                                 "gnome-background-properties",
 				NULL);
-    cc_background_xml_load_from_dir (sdatadir, data, in_thread);
+    list_directory (sdatadir, data, filenames);
   }
+
+  return filenames;
 }
 
 gboolean
@@ -455,15 +601,64 @@ cc_background_xml_load_list_finish (CcBackgroundXml *xml,
 	return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+/* Runs in the main context once every file has been parsed */
+static gboolean
+load_list_done (gpointer user_data)
+{
+	GTask *task = user_data;
+	LoadData *data = g_task_get_task_data (task);
+	guint i;
+
+	if (g_task_return_error_if_cancelled (task)) {
+		/* The batch source holds a reference on the data */
+		g_mutex_lock (&data->lock);
+		if (data->batch_source != NULL) {
+			g_source_destroy (data->batch_source);
+			g_clear_pointer (&data->batch_source, g_source_unref);
+		}
+		g_mutex_unlock (&data->lock);
+		return G_SOURCE_REMOVE;
+	}
+
+	flush_pending_items (data);
+
+	for (i = 0; i < data->directories->len; i++)
+		cc_background_xml_add_monitor (g_ptr_array_index (data->directories, i), data->xml);
+
+	g_task_return_boolean (task, TRUE);
+
+	return G_SOURCE_REMOVE;
+}
+
 static void
 load_list_thread (GTask *task,
 		  gpointer source_object,
 		  gpointer task_data,
 		  GCancellable *cancellable)
 {
-	CcBackgroundXml *xml = CC_BACKGROUND_XML (source_object);
-	cc_background_xml_load_list (xml, TRUE);
-	g_task_return_boolean (task, TRUE);
+	LoadData *data = task_data;
+	g_autoptr(GPtrArray) filenames = NULL;
+	GThreadPool *pool;
+	guint i;
+
+	filenames = list_files (data);
+
+	/* Parse the files concurrently; items reach the main context
+	 * in batches through flush_pending_items() */
+	pool = g_thread_pool_new (parse_file_func,
+				  data,
+				  MIN (g_get_num_processors (), MAX_PARSER_THREADS),
+				  FALSE,
+				  NULL);
+	for (i = 0; i < filenames->len; i++)
+		g_thread_pool_push (pool, g_strdup (g_ptr_array_index (filenames, i)), NULL);
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	g_main_context_invoke_full (data->context,
+				    G_PRIORITY_DEFAULT,
+				    load_list_done,
+				    g_object_ref (task),
+				    g_object_unref);
 }
 
 void
@@ -473,10 +668,20 @@ cc_background_xml_load_list_async (CcBackgroundXml *xml,
 				   gpointer user_data)
 {
 	g_autoptr(GTask) task = NULL;
+	LoadData *data;
 
 	g_return_if_fail (CC_IS_BACKGROUND_XML (xml));
 
+	data = g_atomic_rc_box_new0 (LoadData);
+	data->xml = g_object_ref (xml);
+	data->context = g_main_context_ref_thread_default ();
+	data->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	data->directories = g_ptr_array_new_with_free_func (g_object_unref);
+	data->pending_items = g_ptr_array_new_with_free_func ((GDestroyNotify) parsed_item_free);
+	g_mutex_init (&data->lock);
+
 	task = g_task_new (xml, cancellable, callback, user_data);
+	g_task_set_task_data (task, data, (GDestroyNotify) load_data_unref);
 	g_task_run_in_thread (task, load_list_thread);
 }
 
@@ -489,16 +694,16 @@ cc_background_xml_load_xml (CcBackgroundXml *xml,
 	if (g_file_test (filename, G_FILE_TEST_IS_REGULAR) == FALSE)
 		return FALSE;
 
-	return cc_background_xml_load_xml_internal (xml, filename, FALSE);
+	return cc_background_xml_load_xml_internal (xml, filename);
 }
 
 static void
 single_xml_added (CcBackgroundXml   *xml,
-		  CcBackgroundItem  *item,
+		  GPtrArray         *items,
 		  CcBackgroundItem **ret)
 {
 	g_assert (*ret == NULL);
-	*ret = g_object_ref (item);
+	*ret = g_object_ref (g_ptr_array_index (items, 0));
 }
 
 CcBackgroundItem *
@@ -511,7 +716,7 @@ cc_background_xml_get_item (const char *filename)
 		return NULL;
 
 	xml = cc_background_xml_new ();
-	g_signal_connect (G_OBJECT (xml), "added",
+	g_signal_connect (G_OBJECT (xml), "items-added",
 			  G_CALLBACK (single_xml_added), &item);
 	if (cc_background_xml_load_xml (xml, filename) == FALSE)
 		return NULL;
@@ -618,8 +823,6 @@ cc_background_xml_finalize (GObject *object)
         g_slist_free_full (xml->monitors, g_object_unref);
 
 	g_clear_pointer (&xml->wp_hash, g_hash_table_destroy);
-	g_clear_handle_id (&xml->item_added_id, g_source_remove);
-	g_clear_pointer (&xml->item_added_queue, g_async_queue_unref);
 
         G_OBJECT_CLASS (cc_background_xml_parent_class)->finalize (object);
 }
@@ -631,13 +834,15 @@ cc_background_xml_class_init (CcBackgroundXmlClass *klass)
 
         object_class->finalize = cc_background_xml_finalize;
 
-	signals[ADDED] = g_signal_new ("added",
-				       G_OBJECT_CLASS_TYPE (object_class),
-				       G_SIGNAL_RUN_LAST,
-				       0,
-				       NULL, NULL,
-				       g_cclosure_marshal_VOID__OBJECT,
-				       G_TYPE_NONE, 1, CC_TYPE_BACKGROUND_ITEM);
+	/* Emitted with a GPtrArray of the CcBackgroundItems found since
+	 * the last emission, so that listeners can add them at once */
+	signals[ITEMS_ADDED] = g_signal_new ("items-added",
+					     G_OBJECT_CLASS_TYPE (object_class),
+					     G_SIGNAL_RUN_LAST,
+					     0,
+					     NULL, NULL,
+					     g_cclosure_marshal_VOID__BOXED,
+					     G_TYPE_NONE, 1, G_TYPE_PTR_ARRAY);
 }
 
 static void
@@ -647,7 +852,6 @@ cc_background_xml_init (CcBackgroundXml *xml)
                                               g_str_equal,
                                               (GDestroyNotify) g_free,
                                               (GDestroyNotify) g_object_unref);
-	xml->item_added_queue = g_async_queue_new_full ((GDestroyNotify) g_object_unref);
 }
 
 CcBackgroundXml *
@@ -42,6 +42,7 @@ struct _CcBluetoothPanel {
 	/* Killswitch */
 	GDBusProxy              *rfkill;
 	GDBusProxy              *properties;
+	gboolean                 rfkill_ready;
 	gboolean                 airplane_mode;
 	gboolean                 bt_airplane_mode;
 	gboolean                 hardware_airplane_mode;
@@ -93,7 +94,8 @@ airplane_mode_changed_cb (GObject *source_object,
 			 state ? "on" : "off");
 
 		gtk_switch_set_state (self->enable_switch, state);
-		if (!bluetooth_settings_widget_get_default_adapter_powered (self->settings_widget))
+		if (self->settings_widget &&
+		    !bluetooth_settings_widget_get_default_adapter_powered (self->settings_widget))
 			bluetooth_settings_widget_set_default_adapter_powered(self->settings_widget, TRUE);
 	}
 }
@@ -102,6 +104,10 @@ static gboolean
 enable_switch_state_set_cb (CcBluetoothPanel *self, gboolean state)
 {
 	g_debug ("Power switched to %s", state ? "on" : "off");
+
+	if (!self->properties)
+		return TRUE;
+
 	g_dbus_proxy_call (self->properties,
 			   "Set",
 			   g_variant_new_parsed ("('org.gnome.SettingsDaemon.Rfkill', 'BluetoothAirplaneMode', %v)",
@@ -121,12 +127,21 @@ adapter_status_changed_cb (CcBluetoothPanel *self)
 	gboolean sensitive, powered;
 	const char *page;
 
+	/* Suspended, updated again when resumed */
+	if (!self->settings_widget)
+		return;
+
 	g_debug ("Updating airplane mode: BluetoothHasAirplaneMode %d, BluetoothHardwareAirplaneMode %d, BluetoothAirplaneMode %d, AirplaneMode %d",
 		 self->has_airplane_mode, self->hardware_airplane_mode, self->bt_airplane_mode, self->airplane_mode);
 
 	valign = GTK_ALIGN_CENTER;
 
-	if (self->has_airplane_mode == FALSE) {
+	if (!self->rfkill_ready) {
+		g_debug ("Waiting for the Rfkill proxies");
+		sensitive = FALSE;
+		powered = FALSE;
+		page = "loading-page";
+	} else if (self->has_airplane_mode == FALSE) {
 		g_debug ("No Bluetooth available");
 		sensitive = FALSE;
 		powered = FALSE;
@@ -214,6 +229,36 @@ panel_changed_cb (CcBluetoothPanel *self,
 		g_warning ("Failed to activate '%s' panel: %s", panel, error->message);
 }
 
+static void
+cc_bluetooth_panel_suspend (CcPanel *panel)
+{
+	CcBluetoothPanel *self = CC_BLUETOOTH_PANEL (panel);
+	GtkWidget *settings_widget = GTK_WIDGET (self->settings_widget);
+
+	/* The settings widget makes the adapter discoverable and scans
+	 * for devices as long as it exists, so drop it while hidden */
+	self->settings_widget = NULL;
+	gtk_stack_remove (self->stack, settings_widget);
+}
+
+static void
+cc_bluetooth_panel_resume (CcPanel *panel)
+{
+	CcBluetoothPanel *self = CC_BLUETOOTH_PANEL (panel);
+
+	self->settings_widget = BLUETOOTH_SETTINGS_WIDGET (bluetooth_settings_widget_new ());
+	g_signal_connect_object (self->settings_widget, "panel-changed",
+				 G_CALLBACK (panel_changed_cb), self, G_CONNECT_SWAPPED);
+	g_signal_connect_object (self->settings_widget, "adapter-status-changed",
+				 G_CALLBACK (adapter_status_changed_cb), self, G_CONNECT_SWAPPED);
+	gtk_stack_add_named (self->stack, GTK_WIDGET (self->settings_widget), "bluetooth-page");
+
+	if (self->rfkill)
+		airplane_mode_changed (self);
+	else
+		adapter_status_changed_cb (self);
+}
+
 static void
 cc_bluetooth_panel_class_init (CcBluetoothPanelClass *klass)
 {
@@ -224,6 +269,8 @@ cc_bluetooth_panel_class_init (CcBluetoothPanelClass *klass)
 	object_class->finalize = cc_bluetooth_panel_finalize;
 
 	panel_class->get_help_uri = cc_bluetooth_panel_get_help_uri;
+	panel_class->suspend = cc_bluetooth_panel_suspend;
+	panel_class->resume = cc_bluetooth_panel_resume;
 
 	gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/control-center/bluetooth/cc-bluetooth-panel.ui");
 
@@ -238,6 +285,44 @@ cc_bluetooth_panel_class_init (CcBluetoothPanelClass *klass)
 	gtk_widget_class_bind_template_callback (widget_class, panel_changed_cb);
 }
 
+static const CcDBusProxyInfo rfkill_proxies[] = {
+	{ "org.gnome.SettingsDaemon.Rfkill", "/org/gnome/SettingsDaemon/Rfkill", "org.gnome.SettingsDaemon.Rfkill" },
+	{ "org.gnome.SettingsDaemon.Rfkill", "/org/gnome/SettingsDaemon/Rfkill", "org.freedesktop.DBus.Properties" },
+};
+
+static void
+rfkill_proxies_ready_cb (GObject      *source_object,
+			 GAsyncResult *res,
+			 gpointer      user_data)
+{
+	CcBluetoothPanel *self;
+	g_autoptr(GPtrArray) proxies = NULL;
+	g_autoptr(GError) error = NULL;
+
+	proxies = cc_object_storage_create_dbus_proxies_finish (res, &error);
+	if (!proxies) {
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			return;
+
+		g_warning ("Failed to create Rfkill proxies: %s", error->message);
+
+		/* Without the killswitch, Bluetooth can't be used */
+		self = CC_BLUETOOTH_PANEL (user_data);
+		self->rfkill_ready = TRUE;
+		adapter_status_changed_cb (self);
+		return;
+	}
+
+	self = CC_BLUETOOTH_PANEL (user_data);
+	self->rfkill_ready = TRUE;
+	self->rfkill = g_object_ref (g_ptr_array_index (proxies, 0));
+	self->properties = g_object_ref (g_ptr_array_index (proxies, 1));
+
+	airplane_mode_changed (self);
+	g_signal_connect_object (self->rfkill, "g-properties-changed",
+				 G_CALLBACK (airplane_mode_changed), self, G_CONNECT_SWAPPED);
+}
+
 static void
 cc_bluetooth_panel_init (CcBluetoothPanel *self)
 {
@@ -247,20 +332,11 @@ cc_bluetooth_panel_init (CcBluetoothPanel *self)
 	gtk_widget_init_template (GTK_WIDGET (self));
 
 	/* RFKill */
-	self->rfkill = cc_object_storage_create_dbus_proxy_sync (G_BUS_TYPE_SESSION,
-								 G_DBUS_PROXY_FLAGS_NONE,
-								 "org.gnome.SettingsDaemon.Rfkill",
-								 "/org/gnome/SettingsDaemon/Rfkill",
-								 "org.gnome.SettingsDaemon.Rfkill",
-								 NULL, NULL);
-	self->properties = cc_object_storage_create_dbus_proxy_sync (G_BUS_TYPE_SESSION,
-								     G_DBUS_PROXY_FLAGS_NONE,
-								     "org.gnome.SettingsDaemon.Rfkill",
-								     "/org/gnome/SettingsDaemon/Rfkill",
-								     "org.freedesktop.DBus.Properties",
-								     NULL, NULL);
-
-	airplane_mode_changed (self);
-	g_signal_connect_object (self->rfkill, "g-properties-changed",
-				 G_CALLBACK (airplane_mode_changed), self, G_CONNECT_SWAPPED);
+	cc_object_storage_create_dbus_proxies (G_BUS_TYPE_SESSION,
+					       G_DBUS_PROXY_FLAGS_NONE,
+					       rfkill_proxies,
+					       G_N_ELEMENTS (rfkill_proxies),
+					       cc_panel_get_cancellable (CC_PANEL (self)),
+					       rfkill_proxies_ready_cb,
+					       self);
 }
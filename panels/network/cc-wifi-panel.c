@@ -69,6 +69,8 @@ struct _CcWifiPanel
 
   GBinding           *spinner_binding;
 
+  gboolean            suspended;
+
   /* Command-line arguments */
   CmdlineOperation    arg_operation;
   gchar              *arg_device;
@@ -122,28 +124,69 @@ update_panel_visibility (NMClient *client)
   g_debug ("Wi-Fi panel visible: %s", visible ? "yes" : "no");
 }
 
-void
-cc_wifi_panel_static_init_func (void)
+static void
+monitor_wifi_devices (NMClient *client)
 {
+  g_debug ("Monitoring NetworkManager for Wi-Fi devices");
+
+  /* Update the panel visibility and monitor for changes */
+  g_signal_connect (client, "device-added", G_CALLBACK (update_panel_visibility), NULL);
+  g_signal_connect (client, "device-removed", G_CALLBACK (update_panel_visibility), NULL);
+
+  update_panel_visibility (client);
+}
+
+static void
+nm_client_ready_cb (GObject      *source_object,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+  g_autoptr(GTask) task = G_TASK (user_data);
+  g_autoptr(NMClient) new_client = NULL;
   g_autoptr(NMClient) client = NULL;
+  g_autoptr(GError) error = NULL;
 
-  g_debug ("Monitoring NetworkManager for Wi-Fi devices");
+  new_client = nm_client_new_finish (result, &error);
 
-  /* Create and store a NMClient instance if it doesn't exist yet */
+  /* A panel may have created its own client in the meantime */
   if (!cc_object_storage_has_object (CC_OBJECT_NMCLIENT))
     {
-      g_autoptr(NMClient) new_client = nm_client_new (NULL, NULL);
+      if (!new_client)
+        {
+          g_task_return_error (task, g_steal_pointer (&error));
+          return;
+        }
+
       cc_object_storage_add_object (CC_OBJECT_NMCLIENT, new_client);
     }
 
   client = cc_object_storage_get_object (CC_OBJECT_NMCLIENT);
+  monitor_wifi_devices (client);
 
-  /* Update the panel visibility and monitor for changes */
+  g_task_return_boolean (task, TRUE);
+}
 
-  g_signal_connect (client, "device-added", G_CALLBACK (update_panel_visibility), NULL);
-  g_signal_connect (client, "device-removed", G_CALLBACK (update_panel_visibility), NULL);
+void
+cc_wifi_panel_static_init_func (GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
 
-  update_panel_visibility (client);
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_wifi_panel_static_init_func);
+
+  /* Reuse the stored NMClient instance if it exists already */
+  if (cc_object_storage_has_object (CC_OBJECT_NMCLIENT))
+    {
+      g_autoptr(NMClient) client = cc_object_storage_get_object (CC_OBJECT_NMCLIENT);
+
+      monitor_wifi_devices (client);
+      g_task_return_boolean (task, TRUE);
+      return;
+    }
+
+  nm_client_new_async (cancellable, nm_client_ready_cb, g_steal_pointer (&task));
 }
 
 /* Auxiliary methods */
@@ -237,6 +280,9 @@ add_wifi_device (CcWifiPanel *self,
                                     self->client,
                                     device);
 
+  if (self->suspended)
+    net_device_wifi_suspend (net_device);
+
   /* And add to the header widgets */
   header_widget = net_device_wifi_get_header_widget (net_device);
 
@@ -724,6 +770,31 @@ cc_wifi_panel_get_help_uri (CcPanel *panel)
   return "help:gnome-help/net-wireless";
 }
 
+static void
+cc_wifi_panel_suspend (CcPanel *panel)
+{
+  CcWifiPanel *self = CC_WIFI_PANEL (panel);
+  guint i;
+
+  self->suspended = TRUE;
+
+  /* Don't keep scanning for access points while hidden */
+  for (i = 0; i < self->devices->len; i++)
+    net_device_wifi_suspend (g_ptr_array_index (self->devices, i));
+}
+
+static void
+cc_wifi_panel_resume (CcPanel *panel)
+{
+  CcWifiPanel *self = CC_WIFI_PANEL (panel);
+  guint i;
+
+  self->suspended = FALSE;
+
+  for (i = 0; i < self->devices->len; i++)
+    net_device_wifi_resume (g_ptr_array_index (self->devices, i));
+}
+
 static void
 cc_wifi_panel_finalize (GObject *object)
 {
@@ -814,6 +885,8 @@ cc_wifi_panel_class_init (CcWifiPanelClass *klass)
   CcPanelClass *panel_class = CC_PANEL_CLASS (klass);
 
   panel_class->get_help_uri = cc_wifi_panel_get_help_uri;
+  panel_class->suspend = cc_wifi_panel_suspend;
+  panel_class->resume = cc_wifi_panel_resume;
 
   object_class->finalize = cc_wifi_panel_finalize;
   object_class->get_property = cc_wifi_panel_get_property;
@@ -92,6 +92,7 @@ struct _NetDeviceWifi
 
         guint                    monitor_scanning_id;
         guint                    scan_id;
+        gboolean                 suspended;
         GCancellable            *cancellable;
 };
 
@@ -359,6 +360,7 @@ nm_device_wifi_refresh_ui (NetDeviceWifi *self)
         }
 
         if (self->scan_id == 0 &&
+            !self->suspended &&
             nm_client_wireless_get_enabled (self->client)) {
                 self->scan_id = g_timeout_add_seconds (PERIODIC_WIFI_SCAN_TIMEOUT,
                                                        request_scan, self);
@@ -1225,3 +1227,23 @@ net_device_wifi_turn_off_hotspot (NetDeviceWifi *self)
 
         stop_shared_connection (self);
 }
+
+/* Stops the periodic scans until net_device_wifi_resume() is called */
+void
+net_device_wifi_suspend (NetDeviceWifi *self)
+{
+        g_return_if_fail (NET_IS_DEVICE_WIFI (self));
+
+        self->suspended = TRUE;
+        disable_scan_timeout (self);
+        set_scanning (self, FALSE, self->last_scan);
+}
+
+void
+net_device_wifi_resume (NetDeviceWifi *self)
+{
+        g_return_if_fail (NET_IS_DEVICE_WIFI (self));
+
+        self->suspended = FALSE;
+        nm_device_wifi_refresh_ui (self);
+}
@@ -43,5 +43,9 @@ GtkWidget     *net_device_wifi_get_title_widget  (NetDeviceWifi *device);
 
 void           net_device_wifi_turn_off_hotspot  (NetDeviceWifi *self);
 
+void           net_device_wifi_suspend           (NetDeviceWifi *self);
+
+void           net_device_wifi_resume            (NetDeviceWifi *self);
+
 G_END_DECLS
 
@@ -55,6 +55,9 @@
 
 #define CUPS_STATUS_CHECK_INTERVAL 5
 
+/* Notifications arriving within this many milliseconds are handled together */
+#define REFRESH_DELAY 250
+
 #if (CUPS_VERSION_MAJOR > 1) || (CUPS_VERSION_MINOR > 5)
 #define HAVE_CUPS_1_6 1
 #endif
@@ -100,6 +103,11 @@ struct _CcPrintersPanel
   guint            cups_status_check_id;
   guint            dbus_subscription_id;
   guint            remove_printer_timeout_id;
+  guint            refresh_timeout_id;
+
+  /* Printer name -> PrinterState, waiting for refresh_timeout_id */
+  GHashTable      *pending_printer_states;
+  gboolean         pending_full_refresh;
 
   PPDList      *all_ppds_list;
 
@@ -127,6 +135,13 @@ typedef struct
   GCancellable *cancellable;
 } SetPPDItem;
 
+typedef struct
+{
+  guint     state;
+  gchar    *state_reasons;
+  gboolean  is_accepting_jobs;
+} PrinterState;
+
 enum {
   PROP_0,
   PROP_PARAMETERS,
@@ -316,6 +331,8 @@ cc_printers_panel_dispose (GObject *object)
   g_clear_object (&self->permission);
   g_clear_handle_id (&self->cups_status_check_id, g_source_remove);
   g_clear_handle_id (&self->remove_printer_timeout_id, g_source_remove);
+  g_clear_handle_id (&self->refresh_timeout_id, g_source_remove);
+  g_clear_pointer (&self->pending_printer_states, g_hash_table_destroy);
   g_clear_pointer (&self->deleted_printer_name, g_free);
   g_clear_pointer (&self->action, g_variant_unref);
   g_clear_pointer (&self->printer_entries, g_hash_table_destroy);
@@ -380,6 +397,144 @@ on_get_job_attributes_cb (GObject      *source_object,
     }
 }
 
+static void
+printer_state_free (PrinterState *state)
+{
+  g_free (state->state_reasons);
+  g_free (state);
+}
+
+static void
+update_printer_state (CcPrintersPanel    *self,
+                      const gchar        *printer_name,
+                      const PrinterState *state)
+{
+  g_autofree gchar *state_value = NULL;
+  PpPrinterEntry   *printer_entry;
+  gint              i;
+
+  printer_entry = g_hash_table_lookup (self->printer_entries, printer_name);
+  state_value = g_strdup_printf ("%u", state->state);
+
+  for (i = 0; i < self->num_dests; i++)
+    {
+      cups_dest_t *dest = &self->dests[i];
+
+      if (g_strcmp0 (dest->name, printer_name) != 0)
+        continue;
+
+      dest->num_options = cupsAddOption ("printer-state", state_value,
+                                         dest->num_options, &dest->options);
+      dest->num_options = cupsAddOption ("printer-state-reasons", state->state_reasons,
+                                         dest->num_options, &dest->options);
+      dest->num_options = cupsAddOption ("printer-is-accepting-jobs",
+                                         state->is_accepting_jobs ? "true" : "false",
+                                         dest->num_options, &dest->options);
+
+      if (printer_entry != NULL)
+        pp_printer_entry_update (printer_entry, *dest, self->is_authorized);
+    }
+}
+
+static void
+get_printers_attributes_cb (GObject      *source_object,
+                            GAsyncResult *result,
+                            gpointer      user_data)
+{
+  CcPrintersPanel     *self = user_data;
+  g_autoptr(GHashTable) printers = NULL;
+  g_autoptr(GError)     error = NULL;
+  PpPrinterEntry      *printer_entry;
+  GHashTableIter       iter;
+  GHashTable          *attributes;
+  gpointer             key, value;
+  gint                 i;
+
+  printers = pp_cups_get_printers_attributes_finish (PP_CUPS (source_object), result, &error);
+  if (printers == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_debug ("%s", error->message);
+
+      return;
+    }
+
+  for (i = 0; i < self->num_dests; i++)
+    {
+      cups_dest_t *dest = &self->dests[i];
+
+      attributes = g_hash_table_lookup (printers, dest->name);
+      if (attributes == NULL)
+        continue;
+
+      g_hash_table_iter_init (&iter, attributes);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        dest->num_options = cupsAddOption (key, value, dest->num_options, &dest->options);
+
+      printer_entry = g_hash_table_lookup (self->printer_entries, dest->name);
+      if (printer_entry != NULL)
+        pp_printer_entry_update (printer_entry, *dest, self->is_authorized);
+    }
+}
+
+static gboolean
+refresh_timeout_cb (gpointer user_data)
+{
+  CcPrintersPanel  *self = user_data;
+  g_autofree gchar **printer_names = NULL;
+  GHashTableIter    iter;
+  gpointer          key, value;
+
+  self->refresh_timeout_id = 0;
+
+  if (self->pending_full_refresh)
+    {
+      /* The new list of destinations has the latest states as well */
+      self->pending_full_refresh = FALSE;
+      g_hash_table_remove_all (self->pending_printer_states);
+
+      actualize_printers_list (self);
+
+      return G_SOURCE_REMOVE;
+    }
+
+  g_hash_table_iter_init (&iter, self->pending_printer_states);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    update_printer_state (self, key, value);
+
+  /* Notifications don't carry supply levels, get them for all
+   * the changed printers at once */
+  if (g_hash_table_size (self->pending_printer_states) > 0)
+    {
+      printer_names = (gchar **) g_hash_table_get_keys_as_array (self->pending_printer_states, NULL);
+      pp_cups_get_printers_attributes_async (self->cups,
+                                             (const gchar * const *) printer_names,
+                                             cc_panel_get_cancellable (CC_PANEL (self)),
+                                             get_printers_attributes_cb,
+                                             self);
+    }
+
+  g_hash_table_remove_all (self->pending_printer_states);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+schedule_refresh (CcPrintersPanel *self)
+{
+  if (self->refresh_timeout_id == 0)
+    self->refresh_timeout_id = g_timeout_add (REFRESH_DELAY, refresh_timeout_cb, self);
+}
+
+static gboolean
+printer_is_known (CcPrintersPanel *self,
+                  const gchar     *printer_name)
+{
+  return printer_name != NULL &&
+         self->dests != NULL &&
+         g_hash_table_contains (self->printer_entries, printer_name);
+}
+
 static void
 on_cups_notification (GDBusConnection *connection,
                       const char      *sender_name,
@@ -442,11 +597,35 @@ on_cups_notification (GDBusConnection *connection,
                      &job_impressions_completed);
     }
 
-  if (g_strcmp0 (signal_name, "PrinterAdded") == 0 ||
-      g_strcmp0 (signal_name, "PrinterDeleted") == 0 ||
-      g_strcmp0 (signal_name, "PrinterStateChanged") == 0 ||
+  if (g_strcmp0 (signal_name, "PrinterStateChanged") == 0 ||
       g_strcmp0 (signal_name, "PrinterStopped") == 0)
-    actualize_printers_list (self);
+    {
+      PrinterState *state;
+
+      /* Only a new list of destinations can tell about printers
+       * we don't have an entry for yet */
+      if (!printer_is_known (self, printer_name) || printer_state_reasons == NULL)
+        {
+          self->pending_full_refresh = TRUE;
+        }
+      else
+        {
+          state = g_new0 (PrinterState, 1);
+          state->state = printer_state;
+          state->state_reasons = g_strdup (printer_state_reasons);
+          state->is_accepting_jobs = printer_is_accepting_jobs;
+
+          g_hash_table_insert (self->pending_printer_states, g_strdup (printer_name), state);
+        }
+
+      schedule_refresh (self);
+    }
+  else if (g_strcmp0 (signal_name, "PrinterAdded") == 0 ||
+           g_strcmp0 (signal_name, "PrinterDeleted") == 0)
+    {
+      self->pending_full_refresh = TRUE;
+      schedule_refresh (self);
+    }
   else if (g_strcmp0 (signal_name, "JobCreated") == 0 ||
            g_strcmp0 (signal_name, "JobCompleted") == 0)
     {
@@ -466,6 +645,7 @@ static gchar *subscription_events[] = {
   "printer-deleted",
   "printer-stopped",
   "printer-state-changed",
+  "printer-modified",
   "job-created",
   "job-completed",
   NULL};
@@ -1254,6 +1434,11 @@ cc_printers_panel_init (CcPrintersPanel *self)
                                                  g_free,
                                                  NULL);
 
+  self->pending_printer_states = g_hash_table_new_full (g_str_hash,
+                                                        g_str_equal,
+                                                        g_free,
+                                                        (GDestroyNotify) printer_state_free);
+
   g_type_ensure (CC_TYPE_PERMISSION_INFOBAR);
 
   g_object_set_data_full (self->reference, "self", self, NULL);
@@ -21,14 +21,38 @@
 #include "config.h"
 
 #include "pp-cups.h"
+#include "pp-dest-cache.h"
+#include "pp-ipp-pool.h"
 
 #if (CUPS_VERSION_MAJOR > 1) || (CUPS_VERSION_MINOR > 5)
 #define HAVE_CUPS_1_6 1
 #endif
 
 #ifndef HAVE_CUPS_1_6
+#define ippGetCount(attr)     attr->num_values
+#define ippGetGroupTag(attr)  attr->group_tag
+#define ippGetValueTag(attr)  attr->value_tag
+#define ippGetName(attr)      attr->name
+#define ippGetBoolean(attr, element) attr->values[element].boolean
 #define ippGetInteger(attr, element) attr->values[element].integer
+#define ippGetString(attr, element, language) attr->values[element].string.text
 #define ippGetStatusCode(ipp) ipp->request.status.status_code
+
+static ipp_attribute_t *
+ippFirstAttribute (ipp_t *ipp)
+{
+  if (!ipp)
+    return (NULL);
+  return (ipp->current = ipp->attrs);
+}
+
+static ipp_attribute_t *
+ippNextAttribute (ipp_t *ipp)
+{
+  if (!ipp || !ipp->current)
+    return (NULL);
+  return (ipp->current = ipp->current->next);
+}
 #endif
 
 struct _PpCups
@@ -66,10 +90,15 @@ _pp_cups_get_dests_thread (GTask        *task,
                            gpointer      task_data,
                            GCancellable *cancellable)
 {
+  g_autoptr(PpDestSnapshot) snapshot = NULL;
   PpCupsDests *dests;
 
+  /* The list is always fetched again, and shared with the other users of
+   * the cache; the panel gets its own copy, which it is free to modify */
+  snapshot = pp_dest_cache_refresh (pp_dest_cache_get_default ());
+
   dests = g_new0 (PpCupsDests, 1);
-  dests->num_of_dests = cupsGetDests (&dests->dests);
+  dests->num_of_dests = pp_dest_snapshot_copy_dests (snapshot, &dests->dests);
 
   if (g_task_set_return_on_cancel (task, FALSE))
     {
@@ -149,6 +178,214 @@ pp_cups_connection_test_finish (PpCups         *self,
   return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+/* The attributes which change while a printer is in use */
+static const char * const printer_status_attributes[] =
+{
+  "printer-name",
+  "printer-state",
+  "printer-state-reasons",
+  "printer-is-accepting-jobs",
+  "marker-names",
+  "marker-levels",
+  "marker-colors",
+  "marker-types"
+};
+
+/* Formats the values of @attr the way cupsGetDests() stores them
+ * as options of a destination: separated by commas, with commas
+ * and backslashes inside of strings escaped by a backslash */
+static gchar *
+format_attribute_value (ipp_attribute_t *attr)
+{
+  g_autoptr(GString) value = g_string_new (NULL);
+  const gchar       *text;
+  gint               i;
+
+  for (i = 0; i < ippGetCount (attr); i++)
+    {
+      if (i > 0)
+        g_string_append_c (value, ',');
+
+      switch (ippGetValueTag (attr))
+        {
+          case IPP_TAG_INTEGER:
+          case IPP_TAG_ENUM:
+            g_string_append_printf (value, "%d", ippGetInteger (attr, i));
+            break;
+
+          case IPP_TAG_BOOLEAN:
+            g_string_append (value, ippGetBoolean (attr, i) ? "true" : "false");
+            break;
+
+          case IPP_TAG_TEXT:
+          case IPP_TAG_NAME:
+          case IPP_TAG_KEYWORD:
+          case IPP_TAG_URI:
+          case IPP_TAG_STRING:
+            for (text = ippGetString (attr, i, NULL); text != NULL && *text != '\0'; text++)
+              {
+                if (*text == ',' || *text == '\\')
+                  g_string_append_c (value, '\\');
+                g_string_append_c (value, *text);
+              }
+            break;
+
+          default:
+            return NULL;
+        }
+    }
+
+  return g_strdup (value->str);
+}
+
+/* Gets the status attributes of the printers with a single CUPS-Get-Printers
+ * request, instead of a Get-Printer-Attributes request per printer.
+ *
+ * CUPS-Get-Printers returns the printers sorted by name, starting at
+ * "first-printer-name", so the request starts at the first of the wanted
+ * printers, and stops there if it is the only one. Otherwise the printers
+ * following it are all returned, and the unwanted ones skipped here: there
+ * is no filter by name, and a request per printer costs more than the few
+ * extra attributes. */
+static gpointer
+get_printers_attributes_func (gpointer user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  ipp_attribute_t *attr;
+  GHashTable      *result;
+  GHashTable      *attributes = NULL;
+  const gchar     *printer_name = NULL;
+  const gchar     *first_printer_name = NULL;
+  gchar          **printer_names = g_task_get_task_data (task);
+  http_t          *http;
+  ipp_t           *request;
+  ipp_t           *response;
+  gint             i;
+
+  request = ippNewRequest (CUPS_GET_PRINTERS);
+  ippAddString (request, IPP_TAG_OPERATION, IPP_TAG_NAME,
+                "requesting-user-name", NULL, cupsUser ());
+  ippAddStrings (request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD,
+                 "requested-attributes", G_N_ELEMENTS (printer_status_attributes), NULL,
+                 printer_status_attributes);
+
+  for (i = 0; printer_names != NULL && printer_names[i] != NULL; i++)
+    {
+      if (first_printer_name == NULL || g_ascii_strcasecmp (printer_names[i], first_printer_name) < 0)
+        first_printer_name = printer_names[i];
+    }
+
+  if (first_printer_name != NULL)
+    {
+      ippAddString (request, IPP_TAG_OPERATION, IPP_TAG_NAME,
+                    "first-printer-name", NULL, first_printer_name);
+      if (i == 1)
+        ippAddInteger (request, IPP_TAG_OPERATION, IPP_TAG_INTEGER,
+                       "limit", 1);
+    }
+
+  http = pp_ipp_pool_get_connection (NULL, 0);
+  response = cupsDoRequest (http != NULL ? http : CUPS_HTTP_DEFAULT, request, "/");
+
+  if (response == NULL || ippGetStatusCode (response) > IPP_OK_CONFLICT)
+    {
+      ippDelete (response);
+
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_FAILED,
+                               "Could not get attributes of printers: %s",
+                               cupsLastErrorString ());
+
+      return NULL;
+    }
+
+  result = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                  g_free, (GDestroyNotify) g_hash_table_unref);
+
+  /* Attributes of each printer form a group, and groups are
+   * separated by an attribute without a name */
+  for (attr = ippFirstAttribute (response); ; attr = ippNextAttribute (response))
+    {
+      if (attr == NULL || ippGetGroupTag (attr) != IPP_TAG_PRINTER || ippGetName (attr) == NULL)
+        {
+          if (printer_name != NULL && attributes != NULL &&
+              (printer_names == NULL || g_strv_contains ((const gchar * const *) printer_names, printer_name)))
+            g_hash_table_insert (result, g_strdup (printer_name), g_steal_pointer (&attributes));
+
+          g_clear_pointer (&attributes, g_hash_table_unref);
+          printer_name = NULL;
+
+          if (attr == NULL)
+            break;
+
+          continue;
+        }
+
+      if (attributes == NULL)
+        attributes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+      if (g_str_equal (ippGetName (attr), "printer-name") && ippGetValueTag (attr) == IPP_TAG_NAME)
+        {
+          printer_name = ippGetString (attr, 0, NULL);
+        }
+      else
+        {
+          gchar *value = format_attribute_value (attr);
+
+          if (value != NULL)
+            g_hash_table_insert (attributes, g_strdup (ippGetName (attr)), value);
+        }
+    }
+
+  g_task_return_pointer (task, result, (GDestroyNotify) g_hash_table_unref);
+
+  ippDelete (response);
+
+  return NULL;
+}
+
+static void
+get_printers_attributes_cancelled (gpointer user_data)
+{
+  g_autoptr(GTask) task = user_data;
+
+  g_task_return_error_if_cancelled (task);
+}
+
+/* Gets state, state reasons and supply levels of @printer_names,
+ * or of all printers if it is %NULL, in one round trip */
+void
+pp_cups_get_printers_attributes_async (PpCups              *self,
+                                       const gchar * const *printer_names,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_task_data (task, g_strdupv ((gchar **) printer_names), (GDestroyNotify) g_strfreev);
+
+  pp_ipp_pool_push (G_PRIORITY_DEFAULT,
+                    cancellable,
+                    get_printers_attributes_func,
+                    g_steal_pointer (&task),
+                    get_printers_attributes_cancelled);
+}
+
+/* Returns a hash table mapping names of printers to hash tables
+ * of their attributes, formatted as options of a cups_dest_t */
+GHashTable *
+pp_cups_get_printers_attributes_finish (PpCups        *self,
+                                        GAsyncResult  *result,
+                                        GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 /* Cancels subscription of given id */
 static void
 cancel_subscription_thread (GTask        *task,
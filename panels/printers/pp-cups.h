@@ -54,6 +54,16 @@ gboolean     pp_cups_connection_test_finish (PpCups         *cups,
                                              GAsyncResult   *result,
                                              GError        **error);
 
+void         pp_cups_get_printers_attributes_async  (PpCups               *cups,
+                                                     const gchar * const  *printer_names,
+                                                     GCancellable         *cancellable,
+                                                     GAsyncReadyCallback   callback,
+                                                     gpointer              user_data);
+
+GHashTable  *pp_cups_get_printers_attributes_finish (PpCups               *cups,
+                                                     GAsyncResult         *result,
+                                                     GError              **error);
+
 void         pp_cups_cancel_subscription_async    (PpCups              *cups,
                                                    gint                 subscription_id,
                                                    GAsyncReadyCallback  callback,
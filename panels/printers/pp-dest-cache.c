@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+
+#include "pp-dest-cache.h"
+
+/*
+ * PpDestCache keeps the result of the last cupsGetDests() call, so that
+ * reading an option of a single printer doesn't list every destination
+ * again.
+ *
+ * The list is held in an immutable, reference counted PpDestSnapshot.
+ * A refresh builds a new snapshot and swaps it in, so worker threads can
+ * keep using the one they got. Snapshots must not be modified, callers
+ * that need to change destinations work on pp_dest_snapshot_copy_dests().
+ *
+ * The snapshot is dropped when the CUPS notifier reports a change to any
+ * printer. The notifier only emits signals while a subscription with a
+ * dbus:// recipient exists, which the Printers panel holds, so snapshots
+ * also expire after CACHE_MAX_AGE seconds.
+ */
+
+#define CUPS_DBUS_PATH      "/org/cups/cupsd/Notifier"
+#define CUPS_DBUS_INTERFACE "org.cups.cupsd.Notifier"
+
+#define CACHE_MAX_AGE 30
+
+struct _PpDestSnapshot
+{
+  gint         ref_count;
+
+  cups_dest_t *dests;
+  gint         num_dests;
+
+  /* Name -> cups_dest_t of the destination without instance */
+  GHashTable  *by_name;
+
+  gint64       timestamp;
+};
+
+struct _PpDestCache
+{
+  GObject parent_instance;
+
+  GMutex          lock;
+  PpDestSnapshot *snapshot;
+  guint           generation;
+
+  /* Serializes cupsGetDests() calls */
+  GMutex          refresh_lock;
+
+  GDBusConnection *bus;
+  guint            subscription_id;
+};
+
+G_DEFINE_TYPE (PpDestCache, pp_dest_cache, G_TYPE_OBJECT)
+
+static PpDestSnapshot *
+pp_dest_snapshot_new (void)
+{
+  PpDestSnapshot *snapshot;
+  gint            i;
+
+  snapshot = g_new0 (PpDestSnapshot, 1);
+  snapshot->ref_count = 1;
+  snapshot->num_dests = cupsGetDests (&snapshot->dests);
+  snapshot->by_name = g_hash_table_new (g_str_hash, g_str_equal);
+  snapshot->timestamp = g_get_monotonic_time ();
+
+  for (i = 0; i < snapshot->num_dests; i++)
+    {
+      if (snapshot->dests[i].instance == NULL)
+        g_hash_table_insert (snapshot->by_name,
+                             snapshot->dests[i].name,
+                             &snapshot->dests[i]);
+    }
+
+  return snapshot;
+}
+
+PpDestSnapshot *
+pp_dest_snapshot_ref (PpDestSnapshot *snapshot)
+{
+  g_return_val_if_fail (snapshot != NULL, NULL);
+
+  g_atomic_int_inc (&snapshot->ref_count);
+
+  return snapshot;
+}
+
+void
+pp_dest_snapshot_unref (PpDestSnapshot *snapshot)
+{
+  g_return_if_fail (snapshot != NULL);
+
+  if (g_atomic_int_dec_and_test (&snapshot->ref_count))
+    {
+      g_hash_table_destroy (snapshot->by_name);
+      if (snapshot->num_dests > 0)
+        cupsFreeDests (snapshot->num_dests, snapshot->dests);
+      g_free (snapshot);
+    }
+}
+
+/*
+ * Returns the number of destinations, and sets @dests to them. They
+ * belong to @snapshot and must not be modified.
+ */
+gint
+pp_dest_snapshot_get_dests (PpDestSnapshot  *snapshot,
+                            cups_dest_t    **dests)
+{
+  g_return_val_if_fail (snapshot != NULL, 0);
+
+  if (dests != NULL)
+    *dests = snapshot->dests;
+
+  return snapshot->num_dests;
+}
+
+/*
+ * Returns the destination called @name without instance, owned by
+ * @snapshot, or %NULL.
+ */
+cups_dest_t *
+pp_dest_snapshot_lookup (PpDestSnapshot *snapshot,
+                         const gchar    *name)
+{
+  g_return_val_if_fail (snapshot != NULL, NULL);
+
+  if (name == NULL)
+    return NULL;
+
+  return g_hash_table_lookup (snapshot->by_name, name);
+}
+
+/*
+ * Copies the destinations of @snapshot into a new list, to be freed
+ * with cupsFreeDests().
+ */
+gint
+pp_dest_snapshot_copy_dests (PpDestSnapshot  *snapshot,
+                             cups_dest_t    **dests)
+{
+  gint num_dests = 0;
+  gint i, j;
+
+  g_return_val_if_fail (snapshot != NULL, 0);
+  g_return_val_if_fail (dests != NULL, 0);
+
+  /* cupsCopyDest() needs CUPS 1.6 */
+  *dests = NULL;
+  for (i = 0; i < snapshot->num_dests; i++)
+    {
+      cups_dest_t *source = &snapshot->dests[i];
+      cups_dest_t *dest;
+
+      num_dests = cupsAddDest (source->name, source->instance, num_dests, dests);
+      dest = cupsGetDest (source->name, source->instance, num_dests, *dests);
+      if (dest == NULL)
+        continue;
+
+      dest->is_default = source->is_default;
+      for (j = 0; j < source->num_options; j++)
+        dest->num_options = cupsAddOption (source->options[j].name,
+                                           source->options[j].value,
+                                           dest->num_options,
+                                           &dest->options);
+    }
+
+  return num_dests;
+}
+
+static void
+on_cups_notification (GDBusConnection *connection,
+                      const gchar     *sender_name,
+                      const gchar     *object_path,
+                      const gchar     *interface_name,
+                      const gchar     *signal_name,
+                      GVariant        *parameters,
+                      gpointer         user_data)
+{
+  PpDestCache *self = user_data;
+
+  /* Job notifications don't change destinations */
+  if (g_str_has_prefix (signal_name, "Printer"))
+    pp_dest_cache_invalidate (self);
+}
+
+static void
+pp_dest_cache_finalize (GObject *object)
+{
+  PpDestCache *self = PP_DEST_CACHE (object);
+
+  if (self->subscription_id != 0)
+    g_dbus_connection_signal_unsubscribe (self->bus, self->subscription_id);
+  g_clear_object (&self->bus);
+
+  g_clear_pointer (&self->snapshot, pp_dest_snapshot_unref);
+  g_mutex_clear (&self->lock);
+  g_mutex_clear (&self->refresh_lock);
+
+  G_OBJECT_CLASS (pp_dest_cache_parent_class)->finalize (object);
+}
+
+static void
+pp_dest_cache_class_init (PpDestCacheClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = pp_dest_cache_finalize;
+}
+
+static void
+pp_dest_cache_init (PpDestCache *self)
+{
+  g_autoptr(GError) error = NULL;
+
+  g_mutex_init (&self->lock);
+  g_mutex_init (&self->refresh_lock);
+
+  self->bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
+  if (self->bus == NULL)
+    {
+      g_debug ("Destinations won't be refreshed on CUPS notifications: %s", error->message);
+      return;
+    }
+
+  self->subscription_id =
+    g_dbus_connection_signal_subscribe (self->bus,
+                                        NULL,
+                                        CUPS_DBUS_INTERFACE,
+                                        NULL,
+                                        CUPS_DBUS_PATH,
+                                        NULL,
+                                        G_DBUS_SIGNAL_FLAGS_NONE,
+                                        on_cups_notification,
+                                        self,
+                                        NULL);
+}
+
+/*
+ * Returns the cache shared by the whole process. It can be used from any
+ * thread.
+ */
+PpDestCache *
+pp_dest_cache_get_default (void)
+{
+  static PpDestCache *cache = NULL;
+
+  /* Worker threads don't push a thread-default context, so notifications
+   * are dispatched in the main context wherever this is first called */
+  if (g_once_init_enter (&cache))
+    g_once_init_leave (&cache, g_object_new (PP_TYPE_DEST_CACHE, NULL));
+
+  return cache;
+}
+
+static PpDestSnapshot *
+update_snapshot (PpDestCache *self,
+                 gboolean     force)
+{
+  PpDestSnapshot *snapshot = NULL;
+  PpDestSnapshot *new_snapshot;
+  guint           generation;
+
+  g_mutex_lock (&self->refresh_lock);
+
+  g_mutex_lock (&self->lock);
+  if (!force &&
+      self->snapshot != NULL &&
+      g_get_monotonic_time () - self->snapshot->timestamp < CACHE_MAX_AGE * G_USEC_PER_SEC)
+    snapshot = pp_dest_snapshot_ref (self->snapshot);
+  generation = self->generation;
+  g_mutex_unlock (&self->lock);
+
+  /* Another thread refreshed it while we were waiting */
+  if (snapshot != NULL)
+    {
+      g_mutex_unlock (&self->refresh_lock);
+      return snapshot;
+    }
+
+  new_snapshot = pp_dest_snapshot_new ();
+
+  g_mutex_lock (&self->lock);
+  /* Don't keep a list that was invalidated while being fetched */
+  if (self->generation == generation)
+    {
+      g_clear_pointer (&self->snapshot, pp_dest_snapshot_unref);
+      self->snapshot = pp_dest_snapshot_ref (new_snapshot);
+    }
+  g_mutex_unlock (&self->lock);
+
+  g_mutex_unlock (&self->refresh_lock);
+
+  return new_snapshot;
+}
+
+/*
+ * Returns: (transfer full): the current destinations, listing them if
+ * they changed since the last call.
+ */
+PpDestSnapshot *
+pp_dest_cache_dup_snapshot (PpDestCache *self)
+{
+  PpDestSnapshot *snapshot = NULL;
+
+  g_return_val_if_fail (PP_IS_DEST_CACHE (self), NULL);
+
+  g_mutex_lock (&self->lock);
+  if (self->snapshot != NULL &&
+      g_get_monotonic_time () - self->snapshot->timestamp < CACHE_MAX_AGE * G_USEC_PER_SEC)
+    snapshot = pp_dest_snapshot_ref (self->snapshot);
+  g_mutex_unlock (&self->lock);
+
+  if (snapshot != NULL)
+    return snapshot;
+
+  return update_snapshot (self, FALSE);
+}
+
+/*
+ * Returns: (transfer full): the destinations, always listing them again.
+ * The new list is shared with later pp_dest_cache_dup_snapshot() calls.
+ */
+PpDestSnapshot *
+pp_dest_cache_refresh (PpDestCache *self)
+{
+  g_return_val_if_fail (PP_IS_DEST_CACHE (self), NULL);
+
+  return update_snapshot (self, TRUE);
+}
+
+/*
+ * Drops the current destinations, for callers that changed them without
+ * a CUPS notification, e.g. in lpoptions.
+ */
+void
+pp_dest_cache_invalidate (PpDestCache *self)
+{
+  g_return_if_fail (PP_IS_DEST_CACHE (self));
+
+  g_mutex_lock (&self->lock);
+  g_clear_pointer (&self->snapshot, pp_dest_snapshot_unref);
+  self->generation++;
+  g_mutex_unlock (&self->lock);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <cups/cups.h>
+
+G_BEGIN_DECLS
+
+#define PP_TYPE_DEST_CACHE (pp_dest_cache_get_type ())
+G_DECLARE_FINAL_TYPE (PpDestCache, pp_dest_cache, PP, DEST_CACHE, GObject)
+
+typedef struct _PpDestSnapshot PpDestSnapshot;
+
+PpDestCache    *pp_dest_cache_get_default   (void);
+
+PpDestSnapshot *pp_dest_cache_dup_snapshot  (PpDestCache     *cache);
+
+PpDestSnapshot *pp_dest_cache_refresh       (PpDestCache     *cache);
+
+void            pp_dest_cache_invalidate    (PpDestCache     *cache);
+
+PpDestSnapshot *pp_dest_snapshot_ref        (PpDestSnapshot  *snapshot);
+
+void            pp_dest_snapshot_unref      (PpDestSnapshot  *snapshot);
+
+gint            pp_dest_snapshot_get_dests  (PpDestSnapshot  *snapshot,
+                                             cups_dest_t    **dests);
+
+cups_dest_t    *pp_dest_snapshot_lookup     (PpDestSnapshot  *snapshot,
+                                             const gchar     *name);
+
+gint            pp_dest_snapshot_copy_dests (PpDestSnapshot  *snapshot,
+                                             cups_dest_t    **dests);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (PpDestSnapshot, pp_dest_snapshot_unref)
+
+G_END_DECLS
@@ -51,6 +51,8 @@ struct _PpIPPOptionWidget
   GHashTable *ipp_attribute;
 
   GCancellable *cancellable;
+  /* The dialog's, cancels the reads of the attribute */
+  GCancellable *group_cancellable;
 };
 
 G_DEFINE_TYPE (PpIPPOptionWidget, pp_ipp_option_widget, GTK_TYPE_BOX)
@@ -124,6 +126,7 @@ pp_ipp_option_widget_finalize (GObject *object)
   g_clear_pointer (&self->option_default, ipp_attribute_free);
   g_clear_pointer (&self->ipp_attribute, g_hash_table_unref);
   g_clear_object (&self->cancellable);
+  g_clear_object (&self->group_cancellable);
 
   G_OBJECT_CLASS (pp_ipp_option_widget_parent_class)->finalize (object);
 }
@@ -132,7 +135,8 @@ GtkWidget *
 pp_ipp_option_widget_new (IPPAttribute *attr_supported,
                           IPPAttribute *attr_default,
                           const gchar  *option_name,
-                          const gchar  *printer)
+                          const gchar  *printer,
+                          GCancellable *cancellable)
 {
   PpIPPOptionWidget *self = NULL;
 
@@ -144,6 +148,7 @@ pp_ipp_option_widget_new (IPPAttribute *attr_supported,
       self->option_name = g_strdup (option_name);
       self->option_supported = ipp_attribute_copy (attr_supported);
       self->option_default = ipp_attribute_copy (attr_default);
+      self->group_cancellable = cancellable ? g_object_ref (cancellable) : NULL;
 
       if (construct_widget (self))
         {
@@ -517,6 +522,8 @@ update_widget (PpIPPOptionWidget *self)
 
   get_ipp_attributes_async (self->printer_name,
                             attributes_names,
+                            G_PRIORITY_DEFAULT,
+                            self->group_cancellable,
                             get_ipp_attributes_cb,
                             self);
 
@@ -34,6 +34,7 @@ G_DECLARE_FINAL_TYPE (PpIPPOptionWidget, pp_ipp_option_widget, PP, IPP_OPTION_WI
 GtkWidget   *pp_ipp_option_widget_new (IPPAttribute *attr_supported,
                                        IPPAttribute *attr_default,
                                        const gchar  *option_name,
-                                       const gchar  *printer);
+                                       const gchar  *printer,
+                                       GCancellable *cancellable);
 
 G_END_DECLS
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "pp-ipp-pool.h"
+
+/*
+ * Blocking CUPS requests run on a small pool of worker threads instead of
+ * a new thread each. Queued requests are sorted by their priority, using
+ * the G_PRIORITY_* scale, then served in the order they were pushed.
+ *
+ * Requests pushed with the same GCancellable form a group: once it is
+ * cancelled, the requests of the group that didn't start yet are dropped
+ * with their cancelled_notify instead of being run.
+ *
+ * Each worker keeps its HTTP/1.1 connections open between requests, one
+ * per server, so consecutive requests don't pay for a new connection.
+ * http_t isn't thread-safe, hence the connections aren't shared among
+ * workers, which are kept to the pool so that the connections stay with
+ * threads running printer requests. A connection the server closed is
+ * dropped once a request on it fails, and opened again by the next one.
+ */
+
+#define MAX_IPP_WORKERS 4
+
+typedef struct
+{
+  gint            io_priority;
+  guint           sequence;
+  GCancellable   *cancellable;
+  GThreadFunc     func;
+  gpointer        data;
+  GDestroyNotify  cancelled_notify;
+} PpIppRequest;
+
+static GPrivate worker_connections = G_PRIVATE_INIT ((GDestroyNotify) g_hash_table_unref);
+static GPrivate last_connection_key = G_PRIVATE_INIT (g_free);
+
+static void
+pp_ipp_request_free (PpIppRequest *request)
+{
+  g_clear_object (&request->cancellable);
+  g_free (request);
+}
+
+static gint
+pp_ipp_request_compare (gconstpointer a,
+                        gconstpointer b,
+                        gpointer      user_data)
+{
+  const PpIppRequest *request_a = a;
+  const PpIppRequest *request_b = b;
+
+  if (request_a->io_priority != request_b->io_priority)
+    return request_a->io_priority < request_b->io_priority ? -1 : 1;
+
+  if (request_a->sequence != request_b->sequence)
+    return request_a->sequence < request_b->sequence ? -1 : 1;
+
+  return 0;
+}
+
+static void
+pp_ipp_pool_worker (gpointer data,
+                    gpointer user_data)
+{
+  PpIppRequest *request = data;
+
+  if (g_cancellable_is_cancelled (request->cancellable))
+    {
+      if (request->cancelled_notify != NULL)
+        request->cancelled_notify (request->data);
+    }
+  else
+    {
+      g_private_replace (&last_connection_key, NULL);
+
+      request->func (request->data);
+
+      /* cupsLastError() is per thread, so it is about this request */
+      if (cupsLastError () == IPP_SERVICE_UNAVAILABLE)
+        {
+          GHashTable  *connections = g_private_get (&worker_connections);
+          const gchar *key = g_private_get (&last_connection_key);
+
+          if (connections != NULL && key != NULL)
+            {
+              g_debug ("Dropping the connection to %s", key);
+              g_hash_table_remove (connections, key);
+            }
+        }
+    }
+
+  pp_ipp_request_free (request);
+}
+
+static GThreadPool *
+get_pool (void)
+{
+  static GThreadPool *pool = NULL;
+
+  if (g_once_init_enter (&pool))
+    {
+      g_autoptr(GError) error = NULL;
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (pp_ipp_pool_worker,
+                                    NULL,
+                                    MAX_IPP_WORKERS,
+                                    TRUE,
+                                    &error);
+      if (error != NULL)
+        g_warning ("Failed to start all the IPP workers: %s", error->message);
+      g_thread_pool_set_sort_function (new_pool, pp_ipp_request_compare, NULL);
+
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  return pool;
+}
+
+/*
+ * Runs @func with @data on a worker thread. If @cancellable is cancelled
+ * before that, @cancelled_notify is called with @data instead, from the
+ * worker thread too.
+ */
+void
+pp_ipp_pool_push (gint            io_priority,
+                  GCancellable   *cancellable,
+                  GThreadFunc     func,
+                  gpointer        data,
+                  GDestroyNotify  cancelled_notify)
+{
+  static gint     sequence = 0;
+  PpIppRequest   *request;
+
+  g_return_if_fail (func != NULL);
+
+  request = g_new0 (PpIppRequest, 1);
+  request->io_priority = io_priority;
+  request->sequence = (guint) g_atomic_int_add (&sequence, 1);
+  request->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+  request->func = func;
+  request->data = data;
+  request->cancelled_notify = cancelled_notify;
+
+  g_thread_pool_push (get_pool (), request, NULL);
+}
+
+/*
+ * Returns a connection to @host_name, or to the default CUPS server if
+ * %NULL, owned by the calling worker thread and kept alive for its next
+ * requests. Must only be called from a function run by pp_ipp_pool_push().
+ */
+http_t *
+pp_ipp_pool_get_connection (const gchar *host_name,
+                            gint         port)
+{
+  g_autofree gchar *key = NULL;
+  GHashTable       *connections;
+  gboolean          is_default = host_name == NULL;
+  http_t           *http;
+
+  if (is_default)
+    {
+      host_name = cupsServer ();
+      port = ippPort ();
+    }
+
+  connections = g_private_get (&worker_connections);
+  if (connections == NULL)
+    {
+      connections = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) httpClose);
+      g_private_set (&worker_connections, connections);
+    }
+
+  key = g_strdup_printf ("%s:%d", host_name, port);
+  g_private_replace (&last_connection_key, g_strdup (key));
+
+  http = g_hash_table_lookup (connections, key);
+  if (http != NULL)
+    return http;
+
+#ifdef HAVE_CUPS_HTTPCONNECT2
+  http = httpConnect2 (host_name, port, NULL, AF_UNSPEC,
+                       is_default ? cupsEncryption () : HTTP_ENCRYPTION_IF_REQUESTED,
+                       1, 30000, NULL);
+#else
+  if (is_default)
+    http = httpConnectEncrypt (host_name, port, cupsEncryption ());
+  else
+    http = httpConnect (host_name, port);
+#endif
+  if (http == NULL)
+    return NULL;
+
+  g_hash_table_insert (connections, g_steal_pointer (&key), http);
+
+  return http;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <cups/cups.h>
+
+G_BEGIN_DECLS
+
+void    pp_ipp_pool_push           (gint            io_priority,
+                                    GCancellable   *cancellable,
+                                    GThreadFunc     func,
+                                    gpointer        data,
+                                    GDestroyNotify  cancelled_notify);
+
+http_t *pp_ipp_pool_get_connection (const gchar    *host_name,
+                                    gint            port);
+
+G_END_DECLS
@@ -418,6 +418,8 @@ printer_add_real_async_dbus_cb (GObject      *source_object,
   if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     {
       get_named_dest_async (self->name,
+                            G_PRIORITY_LOW,
+                            NULL,
                             printer_add_real_async_cb,
                             self);
     }
@@ -1223,6 +1225,8 @@ printer_configure_async (PpNewPrinter *self)
   printer_get_ppd_async (self->name,
                          NULL,
                          0,
+                         G_PRIORITY_LOW,
+                         NULL,
                          printer_get_ppd_cb,
                          ime_data);
 }
@@ -1280,6 +1284,8 @@ pp_new_printer_add_async (PpNewPrinter        *self,
       printer_get_ppd_async (self->original_name,
                              self->host_name,
                              self->host_port,
+                             G_PRIORITY_LOW,
+                             NULL,
                              printer_add_async_scb4,
                              self);
     }
@@ -59,6 +59,9 @@ struct _PpOptionsDialog {
   GHashTable  *ipp_attributes;
   gboolean     ipp_attributes_set;
 
+  /* Cancels the requests of populate_options () and of the option widgets */
+  GCancellable *cancellable;
+
   gboolean sensitive;
 };
 
@@ -328,7 +331,8 @@ ipp_option_add (IPPAttribute *attr_supported,
                 const gchar  *option_display_name,
                 const gchar  *printer_name,
                 GtkWidget    *grid,
-                gboolean      sensitive)
+                gboolean      sensitive,
+                GCancellable *cancellable)
 {
   GtkWidget       *widget;
   GtkWidget       *label;
@@ -337,7 +341,8 @@ ipp_option_add (IPPAttribute *attr_supported,
   widget = (GtkWidget *) pp_ipp_option_widget_new (attr_supported,
                                                    attr_default,
                                                    option_name,
-                                                   printer_name);
+                                                   printer_name,
+                                                   cancellable);
   if (widget)
     {
       gtk_widget_set_visible (widget, TRUE);
@@ -363,13 +368,14 @@ static GtkWidget *
 ppd_option_add (ppd_option_t  option,
                 const gchar  *printer_name,
                 GtkWidget    *grid,
-                gboolean      sensitive)
+                gboolean      sensitive,
+                GCancellable *cancellable)
 {
   GtkWidget       *widget;
   GtkWidget       *label;
   gint             position;
 
-  widget = (GtkWidget *) pp_ppd_option_widget_new (&option, printer_name);
+  widget = (GtkWidget *) pp_ppd_option_widget_new (&option, printer_name, cancellable);
   if (widget)
     {
       gtk_widget_set_visible (widget, TRUE);
@@ -509,7 +515,8 @@ populate_options_real (PpOptionsDialog *self)
                       _("Pages per side"),
                       self->printer_name,
                       page_setup_tab_grid,
-                      self->sensitive);
+                      self->sensitive,
+                      self->cancellable);
 
       /* Add sides option to Page Setup tab */
       ipp_option_add (g_hash_table_lookup (self->ipp_attributes,
@@ -521,7 +528,8 @@ populate_options_real (PpOptionsDialog *self)
                       _("Two-sided"),
                       self->printer_name,
                       page_setup_tab_grid,
-                      self->sensitive);
+                      self->sensitive,
+                      self->cancellable);
 
       /* Add orientation-requested option to Page Setup tab */
       ipp_option_add (g_hash_table_lookup (self->ipp_attributes,
@@ -533,7 +541,8 @@ populate_options_real (PpOptionsDialog *self)
                       _("Orientation"),
                       self->printer_name,
                       page_setup_tab_grid,
-                      self->sensitive);
+                      self->sensitive,
+                      self->cancellable);
     }
 
   if (self->destination && self->ppd_filename)
@@ -595,7 +604,8 @@ populate_options_real (PpOptionsDialog *self)
                       ppd_option_add (ppd_file->groups[i].options[j],
                                       self->printer_name,
                                       grid,
-                                      self->sensitive);
+                                      self->sensitive,
+                                      self->cancellable);
                     }
                 }
             }
@@ -746,15 +756,21 @@ populate_options (PpOptionsDialog *self)
   printer_get_ppd_async (self->printer_name,
                          NULL,
                          0,
+                         G_PRIORITY_DEFAULT,
+                         self->cancellable,
                          printer_get_ppd_cb,
                          self);
 
   get_named_dest_async (self->printer_name,
+                        G_PRIORITY_DEFAULT,
+                        self->cancellable,
                         get_named_dest_cb,
                         self);
 
   get_ipp_attributes_async (self->printer_name,
                             (gchar **) attributes,
+                            G_PRIORITY_DEFAULT,
+                            self->cancellable,
                             get_ipp_attributes_cb,
                             self);
 }
@@ -873,6 +889,9 @@ pp_options_dialog_dispose (GObject *object)
 {
   PpOptionsDialog *self = PP_OPTIONS_DIALOG (object);
 
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+
   g_free (self->printer_name);
   self->printer_name = NULL;
 
@@ -923,4 +942,6 @@ void
 pp_options_dialog_init (PpOptionsDialog *self)
 {
   gtk_widget_init_template (GTK_WIDGET (self));
+
+  self->cancellable = g_cancellable_new ();
 }
@@ -56,6 +56,8 @@ struct _PpPPDOptionWidget
   gboolean  ppd_filename_set;
 
   GCancellable *cancellable;
+  /* The dialog's, cancels the reads of the destination and PPD */
+  GCancellable *group_cancellable;
 };
 
 G_DEFINE_TYPE (PpPPDOptionWidget, pp_ppd_option_widget, GTK_TYPE_BOX)
@@ -167,6 +169,7 @@ pp_ppd_option_widget_finalize (GObject *object)
     }
   g_clear_pointer (&self->ppd_filename, g_free);
   g_clear_object (&self->cancellable);
+  g_clear_object (&self->group_cancellable);
 
   G_OBJECT_CLASS (pp_ppd_option_widget_parent_class)->finalize (object);
 }
@@ -191,7 +194,8 @@ ppd_choice_translate (ppd_choice_t *choice)
 
 GtkWidget *
 pp_ppd_option_widget_new (ppd_option_t *option,
-                          const gchar  *printer_name)
+                          const gchar  *printer_name,
+                          GCancellable *cancellable)
 {
   PpPPDOptionWidget *self = NULL;
 
@@ -202,6 +206,7 @@ pp_ppd_option_widget_new (ppd_option_t *option,
       self->printer_name = g_strdup (printer_name);
       self->option = cups_option_copy (option);
       self->option_name = g_strdup (option->keyword);
+      self->group_cancellable = cancellable ? g_object_ref (cancellable) : NULL;
 
       if (construct_widget (self))
         {
@@ -521,12 +526,16 @@ update_widget (PpPPDOptionWidget *self)
   self->destination_set = FALSE;
 
   get_named_dest_async (self->printer_name,
+                        G_PRIORITY_DEFAULT,
+                        self->group_cancellable,
                         get_named_dest_cb,
                         self);
 
   printer_get_ppd_async (self->printer_name,
                          NULL,
                          0,
+                         G_PRIORITY_DEFAULT,
+                         self->group_cancellable,
                          printer_get_ppd_cb,
                          self);
 }
@@ -30,6 +30,7 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (PpPPDOptionWidget, pp_ppd_option_widget, PP, PPD_OPTION_WIDGET, GtkBox)
 
 GtkWidget   *pp_ppd_option_widget_new      (ppd_option_t *source,
-                                            const gchar  *printer_name);
+                                            const gchar  *printer_name,
+                                            GCancellable *cancellable);
 
 G_END_DECLS
@@ -27,6 +27,8 @@
 #include <cups/ppd.h>
 
 #include "pp-utils.h"
+#include "pp-dest-cache.h"
+#include "pp-ipp-pool.h"
 
 #define DBUS_TIMEOUT      120000
 #define DBUS_TIMEOUT_LONG 600000
@@ -163,39 +165,32 @@ char *
 get_dest_attr (const char *dest_name,
                const char *attr)
 {
-  cups_dest_t *dests;
-  int          num_dests;
+  g_autoptr(PpDestSnapshot) snapshot = NULL;
   cups_dest_t *dest;
   const char  *value;
-  char        *ret;
 
   if (dest_name == NULL)
           return NULL;
 
-  ret = NULL;
-
-  num_dests = cupsGetDests (&dests);
-  if (num_dests < 1) {
+  snapshot = pp_dest_cache_dup_snapshot (pp_dest_cache_get_default ());
+  if (pp_dest_snapshot_get_dests (snapshot, NULL) < 1) {
           g_debug ("Unable to get printer destinations");
           return NULL;
   }
 
-  dest = cupsGetDest (dest_name, NULL, num_dests, dests);
+  dest = pp_dest_snapshot_lookup (snapshot, dest_name);
   if (dest == NULL) {
           g_debug ("Unable to find a printer named '%s'", dest_name);
-          goto out;
+          return NULL;
   }
 
   value = cupsGetOption (attr, dest->num_options, dest->options);
   if (value == NULL) {
           g_debug ("Unable to get %s for '%s'", attr, dest_name);
-          goto out;
+          return NULL;
   }
-  ret = g_strdup (value);
-out:
-  cupsFreeDests (num_dests, dests);
 
-  return ret;
+  return g_strdup (value);
 }
 
 gchar *
@@ -228,11 +223,15 @@ get_ppd_attribute (const gchar *ppd_file_name,
 void
 set_local_default_printer (const gchar *printer_name)
 {
+  g_autoptr(PpDestSnapshot) snapshot = NULL;
+  PpDestCache *cache = pp_dest_cache_get_default ();
   cups_dest_t *dests = NULL;
   int          num_dests = 0;
   int          i;
 
-  num_dests = cupsGetDests (&dests);
+  /* Snapshots are shared, modify a copy */
+  snapshot = pp_dest_cache_dup_snapshot (cache);
+  num_dests = pp_dest_snapshot_copy_dests (snapshot, &dests);
 
   for (i = 0; i < num_dests; i ++)
     {
@@ -243,6 +242,10 @@ set_local_default_printer (const gchar *printer_name)
     }
 
   cupsSetDests (num_dests, dests);
+  cupsFreeDests (num_dests, dests);
+
+  /* lpoptions changes aren't notified by CUPS */
+  pp_dest_cache_invalidate (cache);
 }
 
 /*
@@ -255,7 +258,9 @@ printer_rename (const gchar *old_name,
 {
   ipp_attribute_t  *attr = NULL;
   cups_ptype_t      printer_type = 0;
-  cups_dest_t      *dests = NULL;
+  g_autoptr(PpDestSnapshot) snapshot = NULL;
+  g_autoptr(PpDestSnapshot) new_snapshot = NULL;
+  PpDestCache      *cache = pp_dest_cache_get_default ();
   cups_dest_t      *dest = NULL;
   cups_job_t       *jobs = NULL;
   g_autoptr(GDBusConnection) bus = NULL;
@@ -284,7 +289,6 @@ printer_rename (const gchar *old_name,
   ipp_t            *request;
   ipp_t            *response;
   gint              i;
-  int               num_dests = 0;
   int               num_jobs = 0;
   static const char * const requested_attrs[] = {
     "printer-error-policy",
@@ -300,28 +304,25 @@ printer_rename (const gchar *old_name,
       g_strcmp0 (old_name, new_name) == 0)
     return FALSE;
 
-  num_dests = cupsGetDests (&dests);
+  /* The strings read from the original printer belong to the snapshot */
+  snapshot = pp_dest_cache_dup_snapshot (cache);
 
-  dest = cupsGetDest (new_name, NULL, num_dests, dests);
+  dest = pp_dest_snapshot_lookup (snapshot, new_name);
   if (dest)
-    {
-      cupsFreeDests (num_dests, dests);
-      return FALSE;
-    }
+    return FALSE;
 
   num_jobs = cupsGetJobs (&jobs, old_name, 0, CUPS_WHICHJOBS_ACTIVE);
   cupsFreeJobs (num_jobs, jobs);
   if (num_jobs > 1)
     {
       g_warning ("There are queued jobs on printer %s!", old_name);
-      cupsFreeDests (num_dests, dests);
       return FALSE;
     }
 
   /*
    * Gather some informations about the original printer
    */
-  dest = cupsGetDest (old_name, NULL, num_dests, dests);
+  dest = pp_dest_snapshot_lookup (snapshot, old_name);
   if (dest)
     {
       for (i = 0; i < dest->num_options; i++)
@@ -347,7 +348,6 @@ printer_rename (const gchar *old_name,
         }
       default_printer = dest->is_default;
     }
-  cupsFreeDests (num_dests, dests);
 
   if (accepting)
     {
@@ -498,8 +498,8 @@ printer_rename (const gchar *old_name,
       g_unlink (ppd_link);
     }
 
-  num_dests = cupsGetDests (&dests);
-  dest = cupsGetDest (new_name, NULL, num_dests, dests);
+  new_snapshot = pp_dest_cache_refresh (cache);
+  dest = pp_dest_snapshot_lookup (new_snapshot, new_name);
   if (dest)
     {
       printer_set_accepting_jobs (new_name, accepting, NULL);
@@ -520,7 +520,6 @@ printer_rename (const gchar *old_name,
   else
     printer_set_accepting_jobs (old_name, accepting, NULL);
 
-  cupsFreeDests (num_dests, dests);
   if (sheets)
     g_strfreev (sheets);
   if (users_allowed)
@@ -1174,19 +1173,22 @@ typedef struct
   gchar        *printer_name;
   gchar       **attributes_names;
   GHashTable   *result;
+  GCancellable *cancellable;
   GIACallback   callback;
   gpointer      user_data;
   GMainContext *context;
 } GIAData;
 
 static GIAData *
-gia_data_new (const gchar *printer_name, gchar **attributes_names, GIACallback callback, gpointer user_data)
+gia_data_new (const gchar *printer_name, gchar **attributes_names, GCancellable *cancellable, GIACallback callback, gpointer user_data)
 {
   GIAData *data;
 
   data = g_new0 (GIAData, 1);
   data->printer_name = g_strdup (printer_name);
   data->attributes_names = g_strdupv (attributes_names);
+  if (cancellable)
+    data->cancellable = g_object_ref (cancellable);
   data->callback = callback;
   data->user_data = user_data;
   data->context = g_main_context_ref_thread_default ();
@@ -1202,6 +1204,7 @@ gia_data_free (GIAData *data)
     g_strfreev (data->attributes_names);
   if (data->result)
     g_hash_table_unref (data->result);
+  g_clear_object (&data->cancellable);
   if (data->context)
     g_main_context_unref (data->context);
   g_free (data);
@@ -1212,6 +1215,9 @@ get_ipp_attributes_idle_cb (gpointer user_data)
 {
   GIAData *data = (GIAData *) user_data;
 
+  if (g_cancellable_is_cancelled (data->cancellable))
+    return FALSE;
+
   data->callback (data->result, data->user_data);
   data->result = NULL;
 
@@ -1246,6 +1252,7 @@ get_ipp_attributes_func (gpointer user_data)
   GIAData          *data = user_data;
   ipp_t            *request;
   ipp_t            *response = NULL;
+  http_t           *http;
   g_autofree gchar *printer_uri = NULL;
   char            **requested_attrs = NULL;
   gint              i, j, length = 0;
@@ -1265,7 +1272,10 @@ get_ipp_attributes_func (gpointer user_data)
                     "printer-uri", NULL, printer_uri);
       ippAddStrings (request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD,
                      "requested-attributes", length, NULL, (const char **) requested_attrs);
-      response = cupsDoRequest (CUPS_HTTP_DEFAULT, request, "/");
+
+      /* CUPS' own connection to the default server is the fallback */
+      http = pp_ipp_pool_get_connection (NULL, 0);
+      response = cupsDoRequest (http != NULL ? http : CUPS_HTTP_DEFAULT, request, "/");
     }
 
   if (response)
@@ -1343,30 +1353,26 @@ get_ipp_attributes_func (gpointer user_data)
   return NULL;
 }
 
+/*
+ * The callback isn't called if @cancellable gets cancelled.
+ */
 void
 get_ipp_attributes_async (const gchar  *printer_name,
                           gchar       **attributes_names,
+                          gint          io_priority,
+                          GCancellable *cancellable,
                           GIACallback   callback,
                           gpointer      user_data)
 {
-  GIAData          *data;
-  g_autoptr(GThread) thread = NULL;
-  g_autoptr(GError) error = NULL;
-
-  data = gia_data_new (printer_name, attributes_names, callback, user_data);
-
-  thread = g_thread_try_new ("get-ipp-attributes",
-                             get_ipp_attributes_func,
-                             data,
-                             &error);
+  GIAData *data;
 
-  if (!thread)
-    {
-      g_warning ("%s", error->message);
-      callback (NULL, user_data);
+  data = gia_data_new (printer_name, attributes_names, cancellable, callback, user_data);
 
-      gia_data_free (data);
-    }
+  pp_ipp_pool_push (io_priority,
+                    cancellable,
+                    get_ipp_attributes_func,
+                    data,
+                    (GDestroyNotify) gia_data_free);
 }
 
 IPPAttribute *
@@ -1698,7 +1704,8 @@ get_ppds_attribute_func (gpointer user_data)
   data->result = g_new0 (gchar *, g_strv_length (data->ppds_names) + 1);
   for (i = 0; data->ppds_names[i]; i++)
     {
-      g_autofree gchar *ppd_filename = g_strdup (cupsGetServerPPD (CUPS_HTTP_DEFAULT, data->ppds_names[i]));
+      http_t           *http = pp_ipp_pool_get_connection (NULL, 0);
+      g_autofree gchar *ppd_filename = g_strdup (cupsGetServerPPD (http, data->ppds_names[i]));
       if (ppd_filename)
         {
           ppd_file = ppdOpenFile (ppd_filename);
@@ -1729,9 +1736,7 @@ get_ppds_attribute_async (gchar       **ppds_names,
                           GPACallback   callback,
                           gpointer      user_data)
 {
-  GPAData          *data;
-  g_autoptr(GThread) thread = NULL;
-  g_autoptr(GError) error = NULL;
+  GPAData *data;
 
   if (!ppds_names || !attribute_name)
     {
@@ -1741,18 +1746,12 @@ get_ppds_attribute_async (gchar       **ppds_names,
 
   data = gpa_data_new (ppds_names, attribute_name, callback, user_data);
 
-  thread = g_thread_try_new ("get-ppds-attribute",
-                             get_ppds_attribute_func,
-                             data,
-                             &error);
-
-  if (!thread)
-    {
-      g_warning ("%s", error->message);
-      callback (NULL, user_data);
-
-      gpa_data_free (data);
-    }
+  /* The callback handles cancellation, it must always be called */
+  pp_ipp_pool_push (G_PRIORITY_DEFAULT,
+                    NULL,
+                    get_ppds_attribute_func,
+                    data,
+                    NULL);
 }
 
 
@@ -2493,6 +2492,222 @@ static const struct {
   { "zebra", "Zebra" },
 };
 
+/*
+ * The PPD catalogue cache stores the PPDList built from the CUPS_GET_PPDS
+ * response, already grouped by normalized manufacturer, as a serialized
+ * GVariant in the user's cache directory. It is only used for a local
+ * cupsd, and only while none of the directories cups-driverd takes PPDs
+ * and driver programs from, nor the package databases that install them,
+ * changed their modification time.
+ */
+
+#define PPD_CACHE_VERSION 1
+#define PPD_CACHE_FORMAT "(usa(sx)a(ssa(ss)))"
+
+static const gchar * const ppd_cache_sources[] = {
+  "/usr/share/cups/model",
+  "/usr/share/cups/drv",
+  "/usr/share/ppd",
+  "/usr/local/share/ppd",
+  "/opt/share/ppd",
+  "/usr/lib/cups/driver",
+  "/usr/libexec/cups/driver",
+  "/var/cache/cups/ppds.dat",
+  "/var/lib/dpkg/status",
+  "/var/lib/rpm",
+  "/usr/lib/sysimage/rpm",
+  "/var/lib/pacman/local",
+};
+
+static gchar *
+get_ppd_cache_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "gnome-control-center",
+                           "ppd-catalogue.cache",
+                           NULL);
+}
+
+static gboolean
+ppd_cache_is_usable (void)
+{
+  const gchar *server = cupsServer ();
+
+  /* The sources can't be checked for a remote server */
+  return server == NULL ||
+         server[0] == '/' ||
+         g_strcmp0 (server, "localhost") == 0 ||
+         g_strcmp0 (server, "127.0.0.1") == 0;
+}
+
+static gchar *
+get_ppd_cache_key (void)
+{
+  return g_strdup_printf ("%s|%s", VERSION, cupsServer ());
+}
+
+static gint64
+get_ppd_cache_source_mtime (const gchar *path)
+{
+  GStatBuf buf;
+
+  if (g_stat (path, &buf) != 0)
+    return -1;
+
+  return (gint64) buf.st_mtime;
+}
+
+static PPDList *
+ppd_cache_load (void)
+{
+  g_autoptr(GMappedFile) mapped_file = NULL;
+  g_autoptr(GVariant)    cache = NULL;
+  g_autoptr(GVariant)    sources = NULL;
+  g_autoptr(GVariant)    manufacturers = NULL;
+  g_autoptr(GBytes)      bytes = NULL;
+  g_autoptr(GError)      error = NULL;
+  g_autofree gchar      *path = NULL;
+  g_autofree gchar      *key = NULL;
+  const gchar           *cached_key;
+  const gchar           *source_path;
+  GVariantIter           iter;
+  PPDList               *result;
+  guint32                version;
+  gint64                 mtime;
+  gint                   i, j;
+
+  path = get_ppd_cache_path ();
+  mapped_file = g_mapped_file_new (path, FALSE, &error);
+  if (mapped_file == NULL)
+    {
+      g_debug ("No PPD catalogue cache: %s", error->message);
+      return NULL;
+    }
+
+  bytes = g_mapped_file_get_bytes (mapped_file);
+  cache = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (PPD_CACHE_FORMAT), bytes, FALSE));
+
+  g_variant_get_child (cache, 0, "u", &version);
+  if (version != PPD_CACHE_VERSION)
+    {
+      g_debug ("Ignoring PPD catalogue cache with version %u", version);
+      return NULL;
+    }
+
+  key = get_ppd_cache_key ();
+  g_variant_get_child (cache, 1, "&s", &cached_key);
+  if (g_strcmp0 (cached_key, key) != 0)
+    {
+      g_debug ("Ignoring PPD catalogue cache for a different server");
+      return NULL;
+    }
+
+  sources = g_variant_get_child_value (cache, 2);
+  g_variant_iter_init (&iter, sources);
+  while (g_variant_iter_next (&iter, "(&sx)", &source_path, &mtime))
+    {
+      if (get_ppd_cache_source_mtime (source_path) != mtime)
+        {
+          g_debug ("Ignoring outdated PPD catalogue cache (%s changed)", source_path);
+          return NULL;
+        }
+    }
+
+  manufacturers = g_variant_get_child_value (cache, 3);
+  if (g_variant_n_children (manufacturers) == 0)
+    return NULL;
+
+  result = g_new0 (PPDList, 1);
+  result->num_of_manufacturers = g_variant_n_children (manufacturers);
+  result->manufacturers = g_new0 (PPDManufacturerItem *, result->num_of_manufacturers);
+
+  for (i = 0; i < result->num_of_manufacturers; i++)
+    {
+      g_autoptr(GVariant) manufacturer = g_variant_get_child_value (manufacturers, i);
+      g_autoptr(GVariant) ppds = NULL;
+      PPDManufacturerItem *item;
+
+      item = g_new0 (PPDManufacturerItem, 1);
+      g_variant_get_child (manufacturer, 0, "s", &item->manufacturer_name);
+      g_variant_get_child (manufacturer, 1, "s", &item->manufacturer_display_name);
+
+      ppds = g_variant_get_child_value (manufacturer, 2);
+      item->num_of_ppds = g_variant_n_children (ppds);
+      item->ppds = g_new0 (PPDName *, item->num_of_ppds);
+
+      for (j = 0; j < item->num_of_ppds; j++)
+        {
+          item->ppds[j] = g_new0 (PPDName, 1);
+          g_variant_get_child (ppds, j, "(ss)",
+                               &item->ppds[j]->ppd_name,
+                               &item->ppds[j]->ppd_display_name);
+          item->ppds[j]->ppd_match_level = -1;
+        }
+
+      result->manufacturers[i] = item;
+    }
+
+  return result;
+}
+
+static void
+ppd_cache_save (PPDList *list)
+{
+  g_autoptr(GVariant) cache = NULL;
+  g_autoptr(GError)   error = NULL;
+  g_autofree gchar   *path = NULL;
+  g_autofree gchar   *dir = NULL;
+  g_autofree gchar   *key = NULL;
+  GVariantBuilder     sources_builder;
+  GVariantBuilder     manufacturers_builder;
+  gint                i, j;
+
+  g_variant_builder_init (&sources_builder, G_VARIANT_TYPE ("a(sx)"));
+  for (i = 0; i < G_N_ELEMENTS (ppd_cache_sources); i++)
+    g_variant_builder_add (&sources_builder, "(sx)",
+                           ppd_cache_sources[i],
+                           get_ppd_cache_source_mtime (ppd_cache_sources[i]));
+
+  g_variant_builder_init (&manufacturers_builder, G_VARIANT_TYPE ("a(ssa(ss))"));
+  for (i = 0; i < list->num_of_manufacturers; i++)
+    {
+      PPDManufacturerItem *item = list->manufacturers[i];
+
+      g_variant_builder_open (&manufacturers_builder, G_VARIANT_TYPE ("(ssa(ss))"));
+      g_variant_builder_add (&manufacturers_builder, "s", item->manufacturer_name);
+      g_variant_builder_add (&manufacturers_builder, "s", item->manufacturer_display_name);
+      g_variant_builder_open (&manufacturers_builder, G_VARIANT_TYPE ("a(ss)"));
+      for (j = 0; j < item->num_of_ppds; j++)
+        g_variant_builder_add (&manufacturers_builder, "(ss)",
+                               item->ppds[j]->ppd_name,
+                               item->ppds[j]->ppd_display_name);
+      g_variant_builder_close (&manufacturers_builder);
+      g_variant_builder_close (&manufacturers_builder);
+    }
+
+  key = get_ppd_cache_key ();
+  cache = g_variant_ref_sink (g_variant_new (PPD_CACHE_FORMAT,
+                                             PPD_CACHE_VERSION,
+                                             key,
+                                             &sources_builder,
+                                             &manufacturers_builder));
+
+  path = get_ppd_cache_path ();
+  dir = g_path_get_dirname (path);
+
+  if (g_mkdir_with_parents (dir, 0755) != 0)
+    {
+      g_debug ("Failed to create %s, not saving the PPD catalogue cache", dir);
+      return;
+    }
+
+  if (!g_file_set_contents (path,
+                            g_variant_get_data (cache),
+                            g_variant_get_size (cache),
+                            &error))
+    g_debug ("Failed to save the PPD catalogue cache: %s", error->message);
+}
+
 static gpointer
 get_all_ppds_func (gpointer user_data)
 {
@@ -2505,8 +2720,20 @@ get_all_ppds_func (gpointer user_data)
   ipp_t           *response;
   GList           *list;
   gchar           *manufacturer_display_name;
+  gboolean         use_cache;
   gint             i, j;
 
+  use_cache = ppd_cache_is_usable ();
+  if (use_cache)
+    {
+      data->result = ppd_cache_load ();
+      if (data->result != NULL)
+        {
+          get_all_ppds_cb (data);
+          return NULL;
+        }
+    }
+
   request = ippNewRequest (CUPS_GET_PPDS);
   response = cupsDoRequest (CUPS_HTTP_DEFAULT, request, "/");
 
@@ -2705,6 +2932,9 @@ get_all_ppds_func (gpointer user_data)
       g_list_free_full (sort_list, g_free);
       g_hash_table_destroy (ppds_hash);
       g_hash_table_destroy (manufacturers_hash);
+
+      if (use_cache && data->result->num_of_manufacturers > 0)
+        ppd_cache_save (data->result);
     }
 
   get_all_ppds_cb (data);
@@ -2838,13 +3068,14 @@ typedef struct
   gchar        *host_name;
   gint          port;
   gchar        *result;
+  GCancellable *cancellable;
   PGPCallback   callback;
   gpointer      user_data;
   GMainContext *context;
 } PGPData;
 
 static PGPData *
-pgp_data_new (const gchar *printer_name, const gchar *host_name, gint port, PGPCallback callback, gpointer user_data)
+pgp_data_new (const gchar *printer_name, const gchar *host_name, gint port, GCancellable *cancellable, PGPCallback callback, gpointer user_data)
 {
   PGPData *data;
 
@@ -2852,6 +3083,8 @@ pgp_data_new (const gchar *printer_name, const gchar *host_name, gint port, PGPC
   data->printer_name = g_strdup (printer_name);
   data->host_name = g_strdup (host_name);
   data->port = port;
+  if (cancellable)
+    data->cancellable = g_object_ref (cancellable);
   data->callback = callback;
   data->user_data = user_data;
   data->context = g_main_context_ref_thread_default ();
@@ -2865,6 +3098,7 @@ pgp_data_free (PGPData *data)
   g_free (data->printer_name);
   g_free (data->host_name);
   g_free (data->result);
+  g_clear_object (&data->cancellable);
   if (data->context)
     g_main_context_unref (data->context);
   g_free (data);
@@ -2875,6 +3109,14 @@ printer_get_ppd_idle_cb (gpointer user_data)
 {
   PGPData *data = user_data;
 
+  /* The caller would have removed the downloaded PPD */
+  if (g_cancellable_is_cancelled (data->cancellable))
+    {
+      if (data->result != NULL)
+        g_unlink (data->result);
+      return FALSE;
+    }
+
   data->callback (data->result, data->user_data);
 
   return FALSE;
@@ -2898,24 +3140,14 @@ static gpointer
 printer_get_ppd_func (gpointer user_data)
 {
   PGPData *data = user_data;
+  http_t  *http;
 
-  if (data->host_name)
+  http = pp_ipp_pool_get_connection (data->host_name, data->port);
+  if (http)
     {
-      http_t *http;
-
-#ifdef HAVE_CUPS_HTTPCONNECT2
-      http = httpConnect2 (data->host_name, data->port, NULL, AF_UNSPEC,
-                           HTTP_ENCRYPTION_IF_REQUESTED, 1, 30000, NULL);
-#else
-      http = httpConnect (data->host_name, data->port);
-#endif
-      if (http)
-        {
-          data->result = g_strdup (cupsGetPPD2 (http, data->printer_name));
-          httpClose (http);
-        }
+      data->result = g_strdup (cupsGetPPD2 (http, data->printer_name));
     }
-  else
+  else if (!data->host_name)
     {
       data->result = g_strdup (cupsGetPPD (data->printer_name));
     }
@@ -2925,49 +3157,48 @@ printer_get_ppd_func (gpointer user_data)
   return NULL;
 }
 
+/*
+ * The callback isn't called if @cancellable gets cancelled.
+ */
 void
-printer_get_ppd_async (const gchar *printer_name,
-                       const gchar *host_name,
-                       gint         port,
-                       PGPCallback  callback,
-                       gpointer     user_data)
+printer_get_ppd_async (const gchar  *printer_name,
+                       const gchar  *host_name,
+                       gint          port,
+                       gint          io_priority,
+                       GCancellable *cancellable,
+                       PGPCallback   callback,
+                       gpointer      user_data)
 {
-  PGPData          *data;
-  g_autoptr(GThread) thread = NULL;
-  g_autoptr(GError) error = NULL;
-
-  data = pgp_data_new (printer_name, host_name, port, callback, user_data);
+  PGPData *data;
 
-  thread = g_thread_try_new ("printer-get-ppd",
-                             printer_get_ppd_func,
-                             data,
-                             &error);
+  data = pgp_data_new (printer_name, host_name, port, cancellable, callback, user_data);
 
-  if (!thread)
-    {
-      g_warning ("%s", error->message);
-      callback (NULL, user_data);
-
-      pgp_data_free (data);
-    }
+  pp_ipp_pool_push (io_priority,
+                    cancellable,
+                    printer_get_ppd_func,
+                    data,
+                    (GDestroyNotify) pgp_data_free);
 }
 
 typedef struct
 {
   gchar        *printer_name;
   cups_dest_t  *result;
+  GCancellable *cancellable;
   GNDCallback   callback;
   gpointer      user_data;
   GMainContext *context;
 } GNDData;
 
 static GNDData *
-gnd_data_new (const gchar *printer_name, GNDCallback callback, gpointer user_data)
+gnd_data_new (const gchar *printer_name, GCancellable *cancellable, GNDCallback callback, gpointer user_data)
 {
   GNDData *data;
 
   data = g_new0 (GNDData, 1);
   data->printer_name = g_strdup (printer_name);
+  if (cancellable)
+    data->cancellable = g_object_ref (cancellable);
   data->callback = callback;
   data->user_data = user_data;
   data->context = g_main_context_ref_thread_default ();
@@ -2979,6 +3210,7 @@ static void
 gnd_data_free (GNDData *data)
 {
   g_free (data->printer_name);
+  g_clear_object (&data->cancellable);
   if (data->context)
     g_main_context_unref (data->context);
   g_free (data);
@@ -2989,6 +3221,14 @@ get_named_dest_idle_cb (gpointer user_data)
 {
   GNDData *data = user_data;
 
+  /* The destination is passed with ownership */
+  if (g_cancellable_is_cancelled (data->cancellable))
+    {
+      if (data->result != NULL)
+        cupsFreeDests (1, data->result);
+      return FALSE;
+    }
+
   data->callback (data->result, data->user_data);
 
   return FALSE;
@@ -3013,36 +3253,32 @@ get_named_dest_func (gpointer user_data)
 {
   GNDData *data = user_data;
 
-  data->result = cupsGetNamedDest (CUPS_HTTP_DEFAULT, data->printer_name, NULL);
+  data->result = cupsGetNamedDest (pp_ipp_pool_get_connection (NULL, 0), data->printer_name, NULL);
 
   get_named_dest_cb (data);
 
   return NULL;
 }
 
+/*
+ * The callback isn't called if @cancellable gets cancelled.
+ */
 void
-get_named_dest_async (const gchar *printer_name,
-                      GNDCallback  callback,
-                      gpointer     user_data)
+get_named_dest_async (const gchar  *printer_name,
+                      gint          io_priority,
+                      GCancellable *cancellable,
+                      GNDCallback   callback,
+                      gpointer      user_data)
 {
-  GNDData          *data;
-  g_autoptr(GThread) thread = NULL;
-  g_autoptr(GError) error = NULL;
-
-  data = gnd_data_new (printer_name, callback, user_data);
-
-  thread = g_thread_try_new ("get-named-dest",
-                             get_named_dest_func,
-                             data,
-                             &error);
+  GNDData *data;
 
-  if (!thread)
-    {
-      g_warning ("%s", error->message);
-      callback (NULL, user_data);
+  data = gnd_data_new (printer_name, cancellable, callback, user_data);
 
-      gnd_data_free (data);
-    }
+  pp_ipp_pool_push (io_priority,
+                    cancellable,
+                    get_named_dest_func,
+                    data,
+                    (GDestroyNotify) gnd_data_free);
 }
 
 typedef struct
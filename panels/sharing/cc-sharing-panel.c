@@ -684,21 +684,55 @@ cc_sharing_panel_new (void)
   return g_object_new (CC_TYPE_SHARING_PANEL, NULL);
 }
 
-void
-cc_sharing_panel_static_init_func (void)
+static void
+check_sharing_available_in_thread_cb (GTask        *task,
+                                      gpointer      source_object,
+                                      gpointer      task_data,
+                                      GCancellable *cancellable)
 {
-  CcApplication *application;
   gboolean visible;
 
-  CC_TRACE_MSG ("Updating Sharing panel visibility");
-
+  /* Looking up the schema and searching PATH for rygel hit the disk */
   visible = cc_sharing_panel_check_schema_available (FILE_SHARING_SCHEMA_ID) ||
             cc_sharing_panel_check_media_sharing_available ();
 
+  g_task_return_boolean (task, visible);
+}
+
+static void
+sharing_available_cb (GObject      *source_object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+  g_autoptr(GTask) task = G_TASK (user_data);
+  CcApplication *application;
+  gboolean visible;
+
+  visible = g_task_propagate_boolean (G_TASK (result), NULL);
+
   application = CC_APPLICATION (g_application_get_default ());
   cc_shell_model_set_panel_visibility (cc_application_get_model (application),
                                        "sharing",
                                        visible ? CC_PANEL_VISIBLE : CC_PANEL_HIDDEN);
   g_debug ("Sharing panel visible: %s", visible ? "yes" : "no");
+
+  g_task_return_boolean (task, TRUE);
+}
+
+void
+cc_sharing_panel_static_init_func (GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+  g_autoptr(GTask) check_task = NULL;
+  g_autoptr(GTask) task = NULL;
+
+  CC_TRACE_MSG ("Updating Sharing panel visibility");
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_sharing_panel_static_init_func);
+
+  check_task = g_task_new (NULL, cancellable, sharing_available_cb, g_steal_pointer (&task));
+  g_task_run_in_thread (check_task, check_sharing_available_in_thread_cb);
 }
 
@@ -29,6 +29,8 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (CcSharingPanel, cc_sharing_panel, CC, SHARING_PANEL, CcPanel)
 
 CcSharingPanel *cc_sharing_panel_new (void);
-void            cc_sharing_panel_static_init_func (void);
+void            cc_sharing_panel_static_init_func (GCancellable        *cancellable,
+                                                   GAsyncReadyCallback  callback,
+                                                   gpointer             user_data);
 
 G_END_DECLS
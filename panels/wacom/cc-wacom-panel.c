@@ -116,17 +116,38 @@ update_visibility (GsdDeviceManager *manager,
 	g_debug ("Wacom panel visible: %s", i > 0 ? "yes" : "no");
 }
 
-void
-cc_wacom_panel_static_init_func (void)
+static gboolean
+monitor_tablets_cb (gpointer user_data)
 {
+	g_autoptr(GTask) task = G_TASK (user_data);
 	GsdDeviceManager *manager;
 
+	/* The device manager enumerates devices when created, and can only
+	 * be used from the main thread, so defer it until the main loop is
+	 * idle instead of holding back the sidebar. */
 	manager = gsd_device_manager_get ();
 	g_signal_connect (G_OBJECT (manager), "device-added",
 			  G_CALLBACK (update_visibility), NULL);
 	g_signal_connect (G_OBJECT (manager), "device-removed",
 			  G_CALLBACK (update_visibility), NULL);
 	update_visibility (manager, NULL, NULL);
+
+	g_task_return_boolean (task, TRUE);
+
+	return G_SOURCE_REMOVE;
+}
+
+void
+cc_wacom_panel_static_init_func (GCancellable        *cancellable,
+				 GAsyncReadyCallback  callback,
+				 gpointer             user_data)
+{
+	GTask *task;
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+	g_task_set_source_tag (task, cc_wacom_panel_static_init_func);
+
+	g_idle_add (monitor_tablets_cb, task);
 }
 
 static CcWacomDevice *
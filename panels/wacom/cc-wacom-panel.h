@@ -29,7 +29,9 @@ G_BEGIN_DECLS
 #define CC_TYPE_WACOM_PANEL (cc_wacom_panel_get_type ())
 G_DECLARE_FINAL_TYPE (CcWacomPanel, cc_wacom_panel, CC, WACOM_PANEL, CcPanel)
 
-void cc_wacom_panel_static_init_func (void);
+void cc_wacom_panel_static_init_func (GCancellable        *cancellable,
+				      GAsyncReadyCallback  callback,
+				      gpointer             user_data);
 
 void  cc_wacom_panel_switch_to_panel (CcWacomPanel *self,
 				      const char   *panel);
@@ -68,6 +68,9 @@ struct _CcWwanPanel
   GListStore   *data_devices_name_list;
   GCancellable *cancellable;
 
+  /* NMClient and MMManager still being created */
+  guint         n_pending_clients;
+
   CmdlineOperation  arg_operation;
   char             *arg_device;
 };
@@ -322,10 +325,21 @@ cc_wwan_panel_get_cached_dbus_property (GDBusProxy  *proxy,
 static void
 cc_wwan_panel_update_view (CcWwanPanel *self)
 {
-  gboolean has_airplane, is_airplane = FALSE, enabled = FALSE;
+  gboolean has_airplane = FALSE, is_airplane = FALSE, enabled = FALSE;
 
-  has_airplane = cc_wwan_panel_get_cached_dbus_property (self->rfkill_proxy, "HasAirplaneMode");
-  has_airplane &= cc_wwan_panel_get_cached_dbus_property (self->rfkill_proxy, "ShouldShowAirplaneMode");
+  if (self->n_pending_clients > 0)
+    {
+      gtk_stack_set_visible_child_name (self->main_stack, "loading");
+      gtk_widget_set_sensitive (GTK_WIDGET (self->enable_switch), FALSE);
+      return;
+    }
+
+  /* The clients may be ready before the Rfkill proxy */
+  if (self->rfkill_proxy)
+    {
+      has_airplane = cc_wwan_panel_get_cached_dbus_property (self->rfkill_proxy, "HasAirplaneMode");
+      has_airplane &= cc_wwan_panel_get_cached_dbus_property (self->rfkill_proxy, "ShouldShowAirplaneMode");
+    }
 
   if (has_airplane)
     {
@@ -676,22 +690,11 @@ cc_wwan_panel_class_init (CcWwanPanelClass *klass)
   gtk_widget_class_bind_template_callback (widget_class, cc_wwan_data_item_activate_cb);
 }
 
+/* Called once both the NMClient and the MMManager are ready, the
+ * devices need the former */
 static void
-cc_wwan_panel_init (CcWwanPanel *self)
+wwan_panel_setup_clients (CcWwanPanel *self)
 {
-  g_autoptr(GError) error = NULL;
-
-  g_resources_register (cc_wwan_get_resource ());
-
-  gtk_widget_init_template (GTK_WIDGET (self));
-
-  self->cancellable = g_cancellable_new ();
-  self->devices = g_list_store_new (CC_TYPE_WWAN_DEVICE);
-  self->data_devices = g_list_store_new (CC_TYPE_WWAN_DEVICE);
-  self->data_devices_name_list = g_list_store_new (GTK_TYPE_STRING_OBJECT);
-  adw_combo_row_set_model (ADW_COMBO_ROW (self->data_list_row),
-                           G_LIST_MODEL (self->data_devices_name_list));
-
   if (cc_object_storage_has_object (CC_OBJECT_NMCLIENT))
     {
       self->nm_client = cc_object_storage_get_object (CC_OBJECT_NMCLIENT);
@@ -700,14 +703,6 @@ cc_wwan_panel_init (CcWwanPanel *self)
                                G_CALLBACK (cc_wwan_panel_update_view),
                                self, G_CONNECT_SWAPPED);
 
-    }
-  else
-    {
-      g_warn_if_reached ();
-    }
-
-  if (self->nm_client)
-    {
       g_object_bind_property (self->nm_client, "wwan-enabled",
                               self->enable_switch, "active",
                               G_BINDING_BIDIRECTIONAL | G_BINDING_SYNC_CREATE);
@@ -726,11 +721,128 @@ cc_wwan_panel_init (CcWwanPanel *self)
 
       cc_wwan_panel_update_devices (self);
     }
-  else
+
+  cc_wwan_panel_update_view (self);
+}
+
+static void
+wwan_panel_client_done (CcWwanPanel *self)
+{
+  g_assert (self->n_pending_clients > 0);
+
+  if (--self->n_pending_clients == 0)
+    wwan_panel_setup_clients (self);
+}
+
+static void
+wwan_panel_nm_client_ready_cb (GObject      *source_object,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  g_autoptr(NMClient) client = NULL;
+  g_autoptr(GError) error = NULL;
+  CcWwanPanel *self;
+
+  client = nm_client_new_finish (result, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = CC_WWAN_PANEL (user_data);
+
+  /* Another panel may have stored one in the meantime */
+  if (!client)
+    g_warning ("Error connecting to NetworkManager: %s", error->message);
+  else if (!cc_object_storage_has_object (CC_OBJECT_NMCLIENT))
+    cc_object_storage_add_object (CC_OBJECT_NMCLIENT, client);
+
+  wwan_panel_client_done (self);
+}
+
+static void
+wwan_panel_mm_manager_ready_cb (GObject      *source_object,
+                                GAsyncResult *result,
+                                gpointer      user_data)
+{
+  g_autoptr(MMManager) mm_manager = NULL;
+  g_autoptr(GError) error = NULL;
+  CcWwanPanel *self;
+
+  mm_manager = mm_manager_new_finish (result, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = CC_WWAN_PANEL (user_data);
+
+  /* The static init function may have stored one in the meantime */
+  if (!mm_manager)
+    g_warning ("Error connecting to ModemManager: %s", error->message);
+  else if (!cc_object_storage_has_object (CC_OBJECT_MMMANAGER))
+    cc_object_storage_add_object (CC_OBJECT_MMMANAGER, mm_manager);
+
+  wwan_panel_client_done (self);
+}
+
+static void
+wwan_panel_system_bus_ready_cb (GObject      *source_object,
+                                GAsyncResult *result,
+                                gpointer      user_data)
+{
+  g_autoptr(GDBusConnection) system_bus = NULL;
+  g_autoptr(GError) error = NULL;
+  CcWwanPanel *self;
+
+  system_bus = g_bus_get_finish (result, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = CC_WWAN_PANEL (user_data);
+
+  if (!system_bus)
+    {
+      g_warning ("Error connecting to system D-Bus: %s", error->message);
+      wwan_panel_client_done (self);
+      return;
+    }
+
+  mm_manager_new (system_bus,
+                  G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+                  self->cancellable,
+                  wwan_panel_mm_manager_ready_cb,
+                  self);
+}
+
+static void
+cc_wwan_panel_init (CcWwanPanel *self)
+{
+  g_autoptr(GError) error = NULL;
+
+  g_resources_register (cc_wwan_get_resource ());
+
+  gtk_widget_init_template (GTK_WIDGET (self));
+
+  self->cancellable = g_cancellable_new ();
+  self->devices = g_list_store_new (CC_TYPE_WWAN_DEVICE);
+  self->data_devices = g_list_store_new (CC_TYPE_WWAN_DEVICE);
+  self->data_devices_name_list = g_list_store_new (GTK_TYPE_STRING_OBJECT);
+  adw_combo_row_set_model (ADW_COMBO_ROW (self->data_list_row),
+                           G_LIST_MODEL (self->data_devices_name_list));
+
+  /* The static init function may not have created the clients yet */
+  if (!cc_object_storage_has_object (CC_OBJECT_NMCLIENT))
     {
-      g_warn_if_reached ();
+      self->n_pending_clients++;
+      nm_client_new_async (self->cancellable, wwan_panel_nm_client_ready_cb, self);
     }
 
+  if (!cc_object_storage_has_object (CC_OBJECT_MMMANAGER))
+    {
+      self->n_pending_clients++;
+      g_bus_get (G_BUS_TYPE_SYSTEM, self->cancellable, wwan_panel_system_bus_ready_cb, self);
+    }
+
+  if (self->n_pending_clients == 0)
+    wwan_panel_setup_clients (self);
+
   /* Acquire Airplane Mode proxy */
   self->rfkill_proxy = cc_object_storage_create_dbus_proxy_sync (G_BUS_TYPE_SESSION,
                                                                  G_DBUS_PROXY_FLAGS_NONE,
@@ -790,26 +902,16 @@ wwan_update_panel_visibility (MMManager *mm_manager)
   g_list_free_full (devices, (GDestroyNotify)g_object_unref);
 }
 
-void
-cc_wwan_panel_static_init_func (void)
+static void
+mm_manager_ready_cb (GObject      *source_object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
 {
-  g_autoptr(GDBusConnection) system_bus = NULL;
+  g_autoptr(GTask) task = G_TASK (user_data);
   g_autoptr(MMManager) mm_manager = NULL;
   g_autoptr(GError) error = NULL;
 
-  /*
-   * There could be other modems that are only handled by rfkill,
-   * and not available via ModemManager.  But as this panel
-   * makes use of ModemManager APIs, we only care devices
-   * supported by ModemManager.
-   */
-  system_bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
-  if (system_bus == NULL)
-    g_warning ("Error connecting to system D-Bus: %s", error->message);
-  else
-    mm_manager = mm_manager_new_sync (system_bus,
-                                      G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
-                                      NULL, &error);
+  mm_manager = mm_manager_new_finish (result, &error);
 
   if (mm_manager == NULL)
     {
@@ -820,8 +922,16 @@ cc_wwan_panel_static_init_func (void)
       application = CC_APPLICATION (g_application_get_default ());
       cc_shell_model_set_panel_visibility (cc_application_get_model (application),
                                            "wwan", FALSE);
+      g_task_return_error (task, g_steal_pointer (&error));
       return;
     }
+
+  /* The panel may have created its own manager in the meantime */
+  if (cc_object_storage_has_object (CC_OBJECT_MMMANAGER))
+    {
+      g_clear_object (&mm_manager);
+      mm_manager = cc_object_storage_get_object (CC_OBJECT_MMMANAGER);
+    }
   else
     {
       cc_object_storage_add_object (CC_OBJECT_MMMANAGER, mm_manager);
@@ -833,4 +943,59 @@ cc_wwan_panel_static_init_func (void)
   g_signal_connect (mm_manager, "object-removed", G_CALLBACK (wwan_update_panel_visibility), NULL);
 
   wwan_update_panel_visibility (mm_manager);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+system_bus_ready_cb (GObject      *source_object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  g_autoptr(GTask) task = G_TASK (user_data);
+  g_autoptr(GDBusConnection) system_bus = NULL;
+  g_autoptr(GError) error = NULL;
+
+  system_bus = g_bus_get_finish (result, &error);
+
+  if (system_bus == NULL)
+    {
+      CcApplication *application;
+
+      g_warning ("Error connecting to system D-Bus: %s", error->message);
+
+      application = CC_APPLICATION (g_application_get_default ());
+      cc_shell_model_set_panel_visibility (cc_application_get_model (application),
+                                           "wwan", FALSE);
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  mm_manager_new (system_bus,
+                  G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+                  g_task_get_cancellable (task),
+                  mm_manager_ready_cb,
+                  g_object_ref (task));
+}
+
+void
+cc_wwan_panel_static_init_func (GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_wwan_panel_static_init_func);
+
+  /*
+   * There could be other modems that are only handled by rfkill,
+   * and not available via ModemManager.  But as this panel
+   * makes use of ModemManager APIs, we only care devices
+   * supported by ModemManager.
+   */
+  g_bus_get (G_BUS_TYPE_SYSTEM,
+             cancellable,
+             system_bus_ready_cb,
+             g_steal_pointer (&task));
 }
@@ -25,9 +25,7 @@
 #include <gtk/gtk.h>
 #include <string.h>
 
-#include <shell/cc-panel.h>
-#include <shell/cc-shell-model.h>
-#include <shell/cc-panel-loader.h>
+#include <shell/cc-panel-index.h>
 
 #include "cc-util.h"
 
@@ -40,14 +38,12 @@ struct _CcSearchProvider
 
   CcShellSearchProvider2 *skeleton;
 
-  GHashTable *iter_table; /* COL_ID -> GtkTreeIter */
+  GHashTable *result_cache; /* casefolded terms -> GStrv */
 };
 
-typedef enum {
-  MATCH_NONE,
-  MATCH_PREFIX,
-  MATCH_SUBSTRING
-} PanelSearchMatch;
+/* GNOME Shell sends a query per keystroke, so a few dozen entries are
+ * enough to cover typing and deleting back */
+#define MAX_CACHED_RESULTS 64
 
 G_DEFINE_TYPE (CcSearchProvider, cc_search_provider, G_TYPE_OBJECT)
 
@@ -67,63 +63,47 @@ get_casefolded_terms (char **terms)
   return casefolded_terms;
 }
 
-static gboolean
-matches_all_terms (GtkTreeModel  *model,
-                   GtkTreeIter   *iter,
-                   char         **terms)
-{
-  int i;
-
-  for (i = 0; terms[i]; i++)
-    {
-      if (!cc_shell_model_iter_matches_search (CC_SHELL_MODEL (model),
-                                               iter,
-                                               terms[i]))
-        return FALSE;
-    }
-
-  return TRUE;
-}
-
-static GtkTreeModel *
-get_model (void)
+static CcPanelIndex *
+get_index (void)
 {
   CcSearchProviderApp *app;
 
   app = cc_search_provider_app_get ();
-  return GTK_TREE_MODEL (cc_search_provider_app_get_model (app));
+  return cc_search_provider_app_get_index (app);
 }
 
 static gchar **
-get_results (gchar **terms)
+get_results (CcSearchProvider  *self,
+             gchar            **terms,
+             gchar            **previous_results)
 {
   g_auto(GStrv) casefolded_terms = NULL;
-  GtkTreeModel *model = get_model ();
-  GtkTreeIter iter;
-  GPtrArray *results;
-  gboolean ok;
+  g_autofree gchar *cache_key = NULL;
+  GStrv cached_results;
+  gchar **results;
 
   casefolded_terms = get_casefolded_terms (terms);
-  results = g_ptr_array_new ();
+  cache_key = g_strjoinv ("\n", casefolded_terms);
 
-  cc_shell_model_set_sort_terms (CC_SHELL_MODEL (model), casefolded_terms);
+  if (!self->result_cache)
+    self->result_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_strfreev);
 
-  ok = gtk_tree_model_get_iter_first (model, &iter);
-  while (ok)
-    {
-      if (matches_all_terms (model, &iter, casefolded_terms))
-        {
-          gchar *id;
-          gtk_tree_model_get (model, &iter, COL_ID, &id, -1);
-          g_ptr_array_add (results, id);
-        }
-
-      ok = gtk_tree_model_iter_next (model, &iter);
-    }
+  cached_results = g_hash_table_lookup (self->result_cache, cache_key);
+  if (cached_results)
+    return g_strdupv (cached_results);
+
+  /* Terms only get longer in a subsearch, so only the previous
+   * results can still match */
+  results = cc_panel_index_search (get_index (), casefolded_terms, previous_results);
+
+  if (g_hash_table_size (self->result_cache) >= MAX_CACHED_RESULTS)
+    g_hash_table_remove_all (self->result_cache);
 
-  g_ptr_array_add (results, NULL);
+  g_hash_table_insert (self->result_cache,
+                       g_steal_pointer (&cache_key),
+                       g_strdupv (results));
 
-  return (char**) g_ptr_array_free (results, FALSE);
+  return results;
 }
 
 static gboolean
@@ -131,7 +111,7 @@ handle_get_initial_result_set (CcSearchProvider        *self,
                                GDBusMethodInvocation   *invocation,
                                char                   **terms)
 {
-  g_auto(GStrv) results = get_results (terms);
+  g_auto(GStrv) results = get_results (self, terms, NULL);
   cc_shell_search_provider2_complete_get_initial_result_set (self->skeleton,
                                                              invocation,
                                                              (const char* const*) results);
@@ -144,96 +124,30 @@ handle_get_subsearch_result_set (CcSearchProvider        *self,
                                  char                   **previous_results,
                                  char                   **terms)
 {
-  /* We ignore the previous results here since the model re-sorts for
-   * the new terms. This means that we're not really doing a subsearch
-   * but, on the other hand, the results are consistent with the
-   * control center's own search. In any case, the number of elements
-   * in the model is always small enough that we don't need to worry
-   * about this taking too long.
-   */
-  g_auto(GStrv) results = get_results (terms);
+  g_auto(GStrv) results = get_results (self, terms, previous_results);
   cc_shell_search_provider2_complete_get_subsearch_result_set (self->skeleton,
                                                                invocation,
                                                                (const char* const*) results);
   return TRUE;
 }
 
-static GtkTreeIter *
-get_iter_for_result (CcSearchProvider *self,
-                     const gchar      *result)
-{
-  GtkTreeModel *model;
-  GtkTreeIter iter;
-  gboolean ok;
-  gchar *id;
-
-  /* Caching GtkTreeIters in this way is only OK because the model is
-   * a GtkListStore which guarantees that while a row exists, the iter
-   * is persistent.
-   */
-  if (self->iter_table)
-    goto lookup;
-
-  self->iter_table = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                            g_free, (GDestroyNotify) gtk_tree_iter_free);
-
-  model = get_model ();
-  ok = gtk_tree_model_get_iter_first (model, &iter);
-  while (ok)
-    {
-      gtk_tree_model_get (model, &iter, COL_ID, &id, -1);
-
-      g_hash_table_replace (self->iter_table, id, gtk_tree_iter_copy (&iter));
-
-      ok = gtk_tree_model_iter_next (model, &iter);
-    }
-
- lookup:
-  return g_hash_table_lookup (self->iter_table, result);
-}
-
 static gboolean
 handle_get_result_metas (CcSearchProvider        *self,
                          GDBusMethodInvocation   *invocation,
                          char                   **results)
 {
-  GtkTreeModel *model = get_model ();
-  GtkTreeIter *iter;
-  int i;
+  CcPanelIndex *index = get_index ();
   GVariantBuilder builder;
-  const char *id;
+  int i;
 
   g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
 
   for (i = 0; results[i]; i++)
     {
-      g_autofree gchar *description = NULL;
-      g_autofree gchar *name = NULL;
-      g_autoptr(GAppInfo) app = NULL;
-      g_autoptr(GIcon) icon = NULL;
-
-      iter = get_iter_for_result (self, results[i]);
-      if (!iter)
-        continue;
-
-      gtk_tree_model_get (model, iter,
-                          COL_APP, &app,
-                          COL_NAME, &name,
-                          COL_GICON, &icon,
-                          COL_DESCRIPTION, &description,
-                          -1);
-      id = g_app_info_get_id (app);
-
-      g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{sv}"));
-      g_variant_builder_add (&builder, "{sv}",
-                             "id", g_variant_new_string (id));
-      g_variant_builder_add (&builder, "{sv}",
-                             "name", g_variant_new_string (name));
-      g_variant_builder_add (&builder, "{sv}",
-                             "icon", g_icon_serialize (icon));
-      g_variant_builder_add (&builder, "{sv}",
-                             "description", g_variant_new_string (description));
-      g_variant_builder_close (&builder);
+      GVariant *meta = cc_panel_index_get_result_meta (index, results[i]);
+
+      if (meta)
+        g_variant_builder_add_value (&builder, meta);
     }
 
   cc_shell_search_provider2_complete_get_result_metas (self->skeleton,
@@ -242,6 +156,29 @@ handle_get_result_metas (CcSearchProvider        *self,
   return TRUE;
 }
 
+/* Launching needs a display connection, to get an activation token on
+ * Wayland or a startup notification id on X11, so GTK is only
+ * initialized the first time a result is activated rather than for
+ * every query */
+static GAppLaunchContext *
+create_launch_context (guint timestamp)
+{
+  GdkAppLaunchContext *launch_context;
+  GdkDisplay *display;
+
+  if (!gtk_init_check ())
+    {
+      g_debug ("No display to launch from, startup notification won't work");
+      return g_app_launch_context_new ();
+    }
+
+  display = gdk_display_get_default ();
+  launch_context = gdk_display_get_app_launch_context (display);
+  gdk_app_launch_context_set_timestamp (launch_context, timestamp);
+
+  return G_APP_LAUNCH_CONTEXT (launch_context);
+}
+
 static gboolean
 handle_activate_result (CcSearchProvider        *self,
                         GDBusMethodInvocation   *invocation,
@@ -249,16 +186,24 @@ handle_activate_result (CcSearchProvider        *self,
                         char                   **results,
                         guint                    timestamp)
 {
-  GdkAppLaunchContext *launch_context;
+  g_autoptr(GAppLaunchContext) launch_context = NULL;
+  g_autoptr(GDesktopAppInfo) app = NULL;
   g_autoptr(GError) error = NULL;
-  GAppInfo *app;
 
-  launch_context = gdk_display_get_app_launch_context (gdk_display_get_default ());
-  gdk_app_launch_context_set_timestamp (launch_context, timestamp);
+  launch_context = create_launch_context (timestamp);
 
-  app = G_APP_INFO (g_desktop_app_info_new (identifier));
+  app = g_desktop_app_info_new (identifier);
+  if (!app)
+    {
+      g_dbus_method_invocation_return_error (invocation,
+                                             G_IO_ERROR,
+                                             G_IO_ERROR_NOT_FOUND,
+                                             "No such panel: %s",
+                                             identifier);
+      return TRUE;
+    }
 
-  if (!g_app_info_launch (app, NULL, G_APP_LAUNCH_CONTEXT (launch_context), &error))
+  if (!g_app_info_launch (G_APP_INFO (app), NULL, launch_context, &error))
     g_dbus_method_invocation_return_gerror (invocation, error);
   else
     cc_shell_search_provider2_complete_activate_result (self->skeleton, invocation);
@@ -272,13 +217,12 @@ handle_launch_search (CcSearchProvider        *self,
                       char                   **terms,
                       guint                    timestamp)
 {
-  GdkAppLaunchContext *launch_context;
+  g_autoptr(GAppLaunchContext) launch_context = NULL;
   g_autoptr(GError) error = NULL;
   char *joined_terms, *command_line;
   GAppInfo *app;
 
-  launch_context = gdk_display_get_app_launch_context (gdk_display_get_default ());
-  gdk_app_launch_context_set_timestamp (launch_context, timestamp);
+  launch_context = create_launch_context (timestamp);
 
   joined_terms = g_strjoinv (" ", terms);
   command_line = g_strdup_printf ("gnome-control-center -s '%s'", joined_terms);
@@ -292,7 +236,7 @@ handle_launch_search (CcSearchProvider        *self,
       return TRUE;
     }
 
-  if (!g_app_info_launch (app, NULL, G_APP_LAUNCH_CONTEXT (launch_context), &error))
+  if (!g_app_info_launch (app, NULL, launch_context, &error))
     g_dbus_method_invocation_return_gerror (invocation, error);
   else
     cc_shell_search_provider2_complete_launch_search (self->skeleton, invocation);
@@ -351,7 +295,7 @@ cc_search_provider_dispose (GObject *object)
   self = CC_SEARCH_PROVIDER (object);
 
   g_clear_object (&self->skeleton);
-  g_clear_pointer (&self->iter_table, g_hash_table_destroy);
+  g_clear_pointer (&self->result_cache, g_hash_table_destroy);
 
   G_OBJECT_CLASS (cc_search_provider_parent_class)->dispose (object);
 }
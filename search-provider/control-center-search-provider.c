@@ -25,11 +25,10 @@
 #include <gio/gio.h>
 
 #include <shell/cc-panel-loader.h>
-#include <shell/cc-shell-model.h>
 #include "cc-search-provider.h"
 #include "control-center-search-provider.h"
 
-G_DEFINE_TYPE (CcSearchProviderApp, cc_search_provider_app, GTK_TYPE_APPLICATION);
+G_DEFINE_TYPE (CcSearchProviderApp, cc_search_provider_app, G_TYPE_APPLICATION);
 
 #define INACTIVITY_TIMEOUT 60 * 1000 /* One minute, in milliseconds */
 
@@ -76,7 +75,7 @@ cc_search_provider_app_dispose (GObject *object)
 
   self = CC_SEARCH_PROVIDER_APP (object);
 
-  g_clear_object (&self->model);
+  g_clear_object (&self->index);
   g_clear_object (&self->search_provider);
 
   G_OBJECT_CLASS (cc_search_provider_app_parent_class)->dispose (object);
@@ -103,8 +102,10 @@ cc_search_provider_app_startup (GApplication *application)
 
   G_APPLICATION_CLASS (cc_search_provider_app_parent_class)->startup (application);
 
-  self->model = cc_shell_model_new ();
-  cc_panel_loader_fill_model (self->model);
+  /* Answering queries only needs the panel metadata, which is read from
+   * the metadata cache: no panel is loaded, and GTK is only initialized
+   * when a result is activated, see create_launch_context() */
+  self->index = cc_panel_loader_load_index ();
 }
 
 static void
@@ -120,10 +121,10 @@ cc_search_provider_app_class_init (CcSearchProviderAppClass *klass)
   app_class->startup = cc_search_provider_app_startup;
 }
 
-CcShellModel *
-cc_search_provider_app_get_model (CcSearchProviderApp *application)
+CcPanelIndex *
+cc_search_provider_app_get_index (CcSearchProviderApp *application)
 {
-  return application->model;
+  return application->index;
 }
 
 CcSearchProviderApp *
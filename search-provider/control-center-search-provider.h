@@ -19,22 +19,22 @@
 
 #pragma once
 
-#include <gtk/gtk.h>
+#include <gio/gio.h>
 
-#include <shell/cc-shell-model.h>
+#include <shell/cc-panel-index.h>
 #include "cc-search-provider.h"
 
 G_BEGIN_DECLS
 
 typedef struct {
-  GtkApplication parent;
+  GApplication parent;
 
-  CcShellModel     *model;
+  CcPanelIndex     *index;
   CcSearchProvider *search_provider;
 } CcSearchProviderApp;
 
 typedef struct {
-  GtkApplicationClass parent_class;
+  GApplicationClass parent_class;
 } CcSearchProviderAppClass;
 
 #define CC_TYPE_SEARCH_PROVIDER_APP cc_search_provider_app_get_type ()
@@ -47,6 +47,6 @@ GType cc_search_provider_app_get_type (void) G_GNUC_CONST;
 
 CcSearchProviderApp *cc_search_provider_app_get (void);
 
-CcShellModel *cc_search_provider_app_get_model (CcSearchProviderApp *application);
+CcPanelIndex *cc_search_provider_app_get_index (CcSearchProviderApp *application);
 
 G_END_DECLS
@@ -30,6 +30,7 @@
 #include "cc-log.h"
 #include "cc-object-storage.h"
 #include "cc-panel-loader.h"
+#include "cc-profiler.h"
 #include "cc-window.h"
 
 struct _CcApplication
@@ -69,6 +70,7 @@ const GOptionEntry all_options[] = {
   { "verbose", 'v', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, cmd_verbose_cb, N_("Enable verbose mode. Specify multiple times to increase verbosity"), NULL },
   { "search", 's', 0, G_OPTION_ARG_STRING, NULL, N_("Search for the string"), "SEARCH" },
   { "list", 'l', 0, G_OPTION_ARG_NONE, NULL, N_("List possible panel names and exit"), NULL },
+  { "trace-file", 0, 0, G_OPTION_ARG_FILENAME, NULL, N_("Write startup and panel timings to FILE"), N_("FILE") },
   { G_OPTION_REMAINING, '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, NULL, N_("Panel to display"), N_("[PANEL] [ARGUMENT…]") },
   { NULL, 0, 0, 0, NULL, NULL, NULL } /* end the list */
 };
@@ -188,6 +190,8 @@ static gint
 cc_application_handle_local_options (GApplication *application,
                                      GVariantDict *options)
 {
+  g_autofree gchar *trace_file = NULL;
+
   if (g_variant_dict_contains (options, "version"))
     {
       g_print ("Local options %s %s\n", PACKAGE, VERSION);
@@ -206,6 +210,15 @@ cc_application_handle_local_options (GApplication *application,
       return 0;
     }
 
+  /* Start tracing before registering, so that startup is traced too */
+  if (g_variant_dict_lookup (options, "trace-file", "^ay", &trace_file))
+    {
+      g_autoptr(GError) error = NULL;
+
+      if (!cc_profiler_start_trace_file (trace_file, &error))
+        g_warning ("Failed to start tracing: %s", error->message);
+    }
+
   return -1;
 }
 
@@ -294,6 +307,7 @@ cc_application_startup (GApplication *application)
   CcApplication *self = CC_APPLICATION (application);
   const gchar *help_accels[] = { "F1", NULL };
   g_autoptr(GtkCssProvider) provider = NULL;
+  gint64 begin_time = CC_PROFILER_CURRENT_TIME;
 
   g_action_map_add_action_entries (G_ACTION_MAP (self),
                                    cc_app_actions,
@@ -315,6 +329,8 @@ cc_application_startup (GApplication *application)
   gtk_style_context_add_provider_for_display (gdk_display_get_default (),
                                               GTK_STYLE_PROVIDER (provider),
                                               GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+
+  cc_profiler_end_mark (begin_time, "Application startup", "%s", VERSION);
 }
 
 static void
@@ -323,6 +339,8 @@ cc_application_finalize (GObject *object)
   /* Destroy the object storage cache when finalizing */
   cc_object_storage_destroy ();
 
+  cc_profiler_stop ();
+
   G_OBJECT_CLASS (cc_application_parent_class)->finalize (object);
 }
 
@@ -19,12 +19,14 @@
 #define G_LOG_DOMAIN "cc-object-storage"
 
 #include "cc-object-storage.h"
+#include "cc-profiler.h"
 
 struct _CcObjectStorage
 {
   GObject     parent_instance;
 
   GHashTable *id_to_object;
+  GHashTable *pending_proxies; /* key → GPtrArray of GTask */
 };
 
 G_DEFINE_TYPE (CcObjectStorage, cc_object_storage, G_TYPE_OBJECT)
@@ -32,70 +34,137 @@ G_DEFINE_TYPE (CcObjectStorage, cc_object_storage, G_TYPE_OBJECT)
 /* Singleton instance */
 static CcObjectStorage *_instance = NULL;
 
-/* GTask API to create a new D-Bus proxy */
+/* A D-Bus proxy being created, shared by all the identical requests
+ * made until it is ready */
 typedef struct
 {
-  GBusType         bus_type;
-  GDBusProxyFlags  flags;
-  gchar           *name;
-  gchar           *path;
-  gchar           *interface;
-  gboolean         cached;
-} TaskData;
-
-static TaskData*
-task_data_new (GBusType         bus_type,
-               GDBusProxyFlags  flags,
-               const gchar     *name,
-               const gchar     *path,
-               const gchar     *interface)
+  CcObjectStorage *self;
+  gchar           *key;
+  gint64           begin_time;
+} ProxyRequest;
+
+/* A request in a batch started by cc_object_storage_create_dbus_proxies() */
+typedef struct
+{
+  GTask *task;
+  guint  index;
+} BatchRequest;
+
+typedef struct
+{
+  GPtrArray *proxies;
+  GError    *error;
+  guint      n_pending;
+} BatchData;
+
+static gchar *
+get_dbus_proxy_key (const gchar *name,
+                    const gchar *path,
+                    const gchar *interface)
+{
+  return g_strdup_printf ("CcObjectStorage::dbus-proxy(%s,%s,%s)", name, path, interface);
+}
+
+/* Proxies of a batch are NULL until they are ready */
+static void
+unref_proxy (gpointer proxy)
 {
-  TaskData *data = g_slice_new (TaskData);
-  data->bus_type = bus_type;
-  data->flags =flags;
-  data->name = g_strdup (name);
-  data->path = g_strdup (path);
-  data->interface = g_strdup (interface);
-  data->cached = FALSE;
-
-  return data;
+  if (proxy)
+    g_object_unref (proxy);
 }
 
 static void
-task_data_free (TaskData *data)
+batch_data_free (BatchData *data)
 {
-  g_free (data->name);
-  g_free (data->path);
-  g_free (data->interface);
-  g_slice_free (TaskData, data);
+  g_clear_pointer (&data->proxies, g_ptr_array_unref);
+  g_clear_error (&data->error);
+  g_free (data);
 }
 
 static void
-create_dbus_proxy_in_thread_cb (GTask        *task,
-                                gpointer      source_object,
-                                gpointer      task_data,
-                                GCancellable *cancellable)
+dbus_proxy_ready_cb (GObject      *source_object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
 {
+  g_autoptr(GPtrArray) waiters = NULL;
   g_autoptr(GDBusProxy) proxy = NULL;
-  g_autoptr(GError) local_error = NULL;
-  TaskData *data = task_data;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *pending_key = NULL;
+  ProxyRequest *request = user_data;
+  CcObjectStorage *self = request->self;
+  guint i;
 
-  proxy = g_dbus_proxy_new_for_bus_sync (data->bus_type,
-                                         data->flags,
-                                         NULL,
-                                         data->name,
-                                         data->path,
-                                         data->interface,
-                                         cancellable,
-                                         &local_error);
+  proxy = g_dbus_proxy_new_for_bus_finish (result, &error);
 
-  if (local_error)
+  cc_profiler_end_mark (request->begin_time, "Create D-Bus proxy", "%s", request->key);
+
+  g_hash_table_steal_extended (self->pending_proxies,
+                               request->key,
+                               (gpointer *) &pending_key,
+                               (gpointer *) &waiters);
+
+  if (proxy)
     {
-      g_task_return_error (task, g_steal_pointer (&local_error));
-      return;
+      /* The same proxy may have been created synchronously in the meantime */
+      if (g_hash_table_contains (self->id_to_object, request->key))
+        {
+          g_clear_object (&proxy);
+          proxy = g_object_ref (g_hash_table_lookup (self->id_to_object, request->key));
+        }
+      else
+        {
+          g_hash_table_insert (self->id_to_object, g_strdup (request->key), g_object_ref (proxy));
+        }
+    }
+
+  g_debug ("Finished creating D-Bus proxy for %s (%u requests)",
+           request->key,
+           waiters ? waiters->len : 0);
+
+  for (i = 0; waiters && i < waiters->len; i++)
+    {
+      GTask *task = g_ptr_array_index (waiters, i);
+
+      if (g_task_return_error_if_cancelled (task))
+        continue;
+
+      if (error)
+        g_task_return_error (task, g_error_copy (error));
+      else
+        g_task_return_pointer (task, g_object_ref (proxy), g_object_unref);
     }
 
-  g_task_return_pointer (task, g_object_ref (g_steal_pointer (&proxy)), g_object_unref);
+  g_free (request->key);
+  g_object_unref (request->self);
+  g_free (request);
+}
+
+static void
+batch_proxy_ready_cb (GObject      *source_object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+  g_autofree BatchRequest *request = user_data;
+  g_autoptr(GTask) task = request->task;
+  g_autoptr(GError) error = NULL;
+  BatchData *data;
+  gpointer proxy;
+
+  data = g_task_get_task_data (task);
+  proxy = cc_object_storage_create_dbus_proxy_finish (result, &error);
+
+  if (proxy)
+    g_ptr_array_index (data->proxies, request->index) = proxy;
+  else if (!data->error)
+    data->error = g_steal_pointer (&error);
+
+  if (--data->n_pending > 0)
+    return;
+
+  if (data->error)
+    g_task_return_error (task, g_steal_pointer (&data->error));
+  else
+    g_task_return_pointer (task, g_steal_pointer (&data->proxies), (GDestroyNotify) g_ptr_array_unref);
 }
 
 static void
@@ -106,6 +175,7 @@ cc_object_storage_finalize (GObject *object)
   g_debug ("Destroying cached objects");
 
   g_clear_pointer (&self->id_to_object, g_hash_table_destroy);
+  g_clear_pointer (&self->pending_proxies, g_hash_table_destroy);
 
   G_OBJECT_CLASS (cc_object_storage_parent_class)->finalize (object);
 }
@@ -122,6 +192,7 @@ static void
 cc_object_storage_init (CcObjectStorage *self)
 {
   self->id_to_object = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  self->pending_proxies = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
 }
 
 /**
@@ -230,6 +301,7 @@ cc_object_storage_create_dbus_proxy_sync (GBusType          bus_type,
   g_autoptr(GDBusProxy) proxy = NULL;
   g_autoptr(GError) local_error = NULL;
   g_autofree gchar *key = NULL;
+  gint64 begin_time;
 
   g_assert (CC_IS_OBJECT_STORAGE (_instance));
   g_assert (name && *name);
@@ -237,7 +309,7 @@ cc_object_storage_create_dbus_proxy_sync (GBusType          bus_type,
   g_assert (interface && *interface);
   g_assert (!error || !*error);
 
-  key = g_strdup_printf ("CcObjectStorage::dbus-proxy(%s,%s,%s)", name, path, interface);
+  key = get_dbus_proxy_key (name, path, interface);
 
   g_debug ("Creating D-Bus proxy for %s", key);
 
@@ -247,6 +319,8 @@ cc_object_storage_create_dbus_proxy_sync (GBusType          bus_type,
   if (g_hash_table_contains (_instance->id_to_object, key))
     return cc_object_storage_get_object (key);
 
+  begin_time = CC_PROFILER_CURRENT_TIME;
+
   proxy = g_dbus_proxy_new_for_bus_sync (bus_type,
                                          flags,
                                          NULL,
@@ -256,6 +330,8 @@ cc_object_storage_create_dbus_proxy_sync (GBusType          bus_type,
                                          cancellable,
                                          &local_error);
 
+  cc_profiler_end_mark (begin_time, "Create D-Bus proxy", "%s %s %s (sync)", name, path, interface);
+
   if (local_error)
     {
       g_propagate_error (error, g_steal_pointer (&local_error));
@@ -282,11 +358,8 @@ cc_object_storage_create_dbus_proxy_sync (GBusType          bus_type,
  * Asynchronously create a #GDBusProxy with @name, @path and @interface.
  *
  * If a proxy with that signature is already created, it will be used instead of
- * creating a new one.
- *
- * It is a programming error to create the an identical proxy while asynchronously
- * creating one. Not cancelling this operation will result in an assertion failure
- * when calling cc_object_storage_create_dbus_proxy_finish().
+ * creating a new one. If it is being created, this request waits for it to be
+ * ready instead of creating another one.
  */
 void
 cc_object_storage_create_dbus_proxy (GBusType             bus_type,
@@ -300,7 +373,8 @@ cc_object_storage_create_dbus_proxy (GBusType             bus_type,
 {
   g_autoptr(GTask) task = NULL;
   g_autofree gchar *key = NULL;
-  TaskData *data = NULL;
+  ProxyRequest *request;
+  GPtrArray *waiters;
 
   g_assert (CC_IS_OBJECT_STORAGE (_instance));
   g_assert (name && *name);
@@ -308,31 +382,53 @@ cc_object_storage_create_dbus_proxy (GBusType             bus_type,
   g_assert (interface && *interface);
   g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
 
-  data = task_data_new (bus_type, flags, name, path, interface);
+  key = get_dbus_proxy_key (name, path, interface);
 
   task = g_task_new (_instance, cancellable, callback, user_data);
   g_task_set_source_tag (task, cc_object_storage_create_dbus_proxy);
-  g_task_set_task_data (task, data, (GDestroyNotify) task_data_free);
-
-  /* Check if the D-Bus proxy is already created */
-  key = g_strdup_printf ("CcObjectStorage::dbus-proxy(%s,%s,%s)", name, path, interface);
+  g_task_set_task_data (task, g_strdup (key), g_free);
 
   g_debug ("Asynchronously creating D-Bus proxy for %s", key);
 
+  /* Check if the D-Bus proxy is already created */
   if (g_hash_table_contains (_instance->id_to_object, key))
     {
-      /* Mark this GTask as already cached, so we can call the right assertions
-       * on the callback
-       * */
-      data->cached = TRUE;
-
       g_debug ("Found in cache the D-Bus proxy %s", key);
 
       g_task_return_pointer (task, cc_object_storage_get_object (key), g_object_unref);
       return;
     }
 
-  g_task_run_in_thread (task, create_dbus_proxy_in_thread_cb);
+  /* Or if it is being created */
+  waiters = g_hash_table_lookup (_instance->pending_proxies, key);
+  if (waiters)
+    {
+      g_debug ("Waiting for the D-Bus proxy %s being created", key);
+
+      g_ptr_array_add (waiters, g_steal_pointer (&task));
+      return;
+    }
+
+  waiters = g_ptr_array_new_with_free_func (g_object_unref);
+  g_ptr_array_add (waiters, g_steal_pointer (&task));
+  g_hash_table_insert (_instance->pending_proxies, g_strdup (key), waiters);
+
+  request = g_new0 (ProxyRequest, 1);
+  request->self = g_object_ref (_instance);
+  request->key = g_steal_pointer (&key);
+  request->begin_time = CC_PROFILER_CURRENT_TIME;
+
+  /* The proxy is shared by all the requests, so cancelling one of them
+   * must not cancel its creation */
+  g_dbus_proxy_new_for_bus (bus_type,
+                            flags,
+                            NULL,
+                            name,
+                            path,
+                            interface,
+                            NULL,
+                            dbus_proxy_ready_cb,
+                            request);
 }
 
 /**
@@ -342,22 +438,12 @@ cc_object_storage_create_dbus_proxy (GBusType             bus_type,
  *
  * Finishes a D-Bus proxy creation started by cc_object_storage_create_dbus_proxy().
  *
- * Synchronously create a #GDBusProxy with @name, @path and @interface,
- * stores it in the cache, and returns the newly created proxy.
- *
- * If a proxy with that signature is already created, it will be used
- * instead of creating a new one.
- *
  * Returns: (transfer full)(nullable): the new #GDBusProxy.
  */
 gpointer
 cc_object_storage_create_dbus_proxy_finish (GAsyncResult  *result,
                                             GError       **error)
 {
-  g_autoptr(GDBusProxy) proxy = NULL;
-  g_autoptr(GError) local_error = NULL;
-  g_autofree gchar *key = NULL;
-  TaskData *task_data;
   GTask *task;
 
   task = G_TASK (result);
@@ -365,46 +451,92 @@ cc_object_storage_create_dbus_proxy_finish (GAsyncResult  *result,
   g_assert (task && G_TASK (result));
   g_assert (!error || !*error);
 
-  task_data = g_task_get_task_data (task);
-  g_assert (task_data != NULL);
+  g_debug ("Finished creating D-Bus proxy for %s", (gchar *) g_task_get_task_data (task));
 
-  key = g_strdup_printf ("CcObjectStorage::dbus-proxy(%s,%s,%s)",
-                         task_data->name,
-                         task_data->path,
-                         task_data->interface);
+  return g_task_propagate_pointer (task, error);
+}
 
-  g_debug ("Finished creating D-Bus proxy for %s", key);
+/**
+ * cc_object_storage_create_dbus_proxies:
+ * @bus_type: the bus of all the proxies
+ * @flags: the D-Bus proxy flags
+ * @proxies: (array length=n_proxies): the proxies to create
+ * @n_proxies: the number of proxies
+ * @cancellable: (nullable): #GCancellable to cancel the operation
+ * @callback: callback for when the async operation is finished
+ * @user_data: user data for @callback
+ *
+ * Asynchronously creates all of @proxies, like cc_object_storage_create_dbus_proxy()
+ * does for each of them.
+ *
+ * All the proxies are requested at once, so their properties are fetched
+ * in parallel instead of waiting for one proxy to be ready before asking
+ * for the next one.
+ */
+void
+cc_object_storage_create_dbus_proxies (GBusType               bus_type,
+                                       GDBusProxyFlags        flags,
+                                       const CcDBusProxyInfo *proxies,
+                                       guint                  n_proxies,
+                                       GCancellable          *cancellable,
+                                       GAsyncReadyCallback    callback,
+                                       gpointer               user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  BatchData *data;
+  guint i;
 
-  /* Retrieve the newly created proxy */
-  proxy = g_task_propagate_pointer (task, &local_error);
+  g_assert (CC_IS_OBJECT_STORAGE (_instance));
+  g_assert (proxies != NULL && n_proxies > 0);
+  g_assert (!cancellable || G_IS_CANCELLABLE (cancellable));
 
-  /* If the proxy is not cached, do the normal caching routine */
-  if (local_error)
-    {
-      g_propagate_error (error, g_steal_pointer (&local_error));
-      return NULL;
-    }
+  data = g_new0 (BatchData, 1);
+  data->proxies = g_ptr_array_new_full (n_proxies, unref_proxy);
+  data->n_pending = n_proxies;
+  g_ptr_array_set_size (data->proxies, n_proxies);
 
-  /* Either we have the object stored right when trying to create it - in which case,
-   * task_data->cached == TRUE and cc_object_storage_has_object (key) == TRUE - or we
-   * didn't have a cached proxy before, and we shouldn't have it now.
-   *
-   * This is to force consumers of this code to *never* try to create the same D-Bus
-   * proxy asynchronously multiple times. Trying to do so is considered a programming
-   * error.
-   */
-  g_assert (task_data->cached == cc_object_storage_has_object (key));
+  task = g_task_new (_instance, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_object_storage_create_dbus_proxies);
+  g_task_set_task_data (task, data, (GDestroyNotify) batch_data_free);
 
-  /* If the proxy is already cached, destroy the newly created and used the cached proxy
-   * instead.
-   */
-  if (cc_object_storage_has_object (key))
-    return cc_object_storage_get_object (key);
+  for (i = 0; i < n_proxies; i++)
+    {
+      BatchRequest *request = g_new0 (BatchRequest, 1);
+
+      request->task = g_object_ref (task);
+      request->index = i;
+
+      cc_object_storage_create_dbus_proxy (bus_type,
+                                           flags,
+                                           proxies[i].name,
+                                           proxies[i].path,
+                                           proxies[i].interface,
+                                           cancellable,
+                                           batch_proxy_ready_cb,
+                                           request);
+    }
+}
 
-  /* Store the newly created D-Bus proxy */
-  cc_object_storage_add_object (key, proxy);
+/**
+ * cc_object_storage_create_dbus_proxies_finish:
+ * @result:
+ * @error: (nullable): return location for a #GError
+ *
+ * Finishes a batch started by cc_object_storage_create_dbus_proxies().
+ * If creating any of the proxies failed, @error is set to the first
+ * failure.
+ *
+ * Returns: (transfer container)(element-type GDBusProxy)(nullable): the
+ *   proxies, in the order they were requested.
+ */
+GPtrArray *
+cc_object_storage_create_dbus_proxies_finish (GAsyncResult  *result,
+                                              GError       **error)
+{
+  g_assert (G_IS_TASK (result));
+  g_assert (!error || !*error);
 
-  return g_steal_pointer (&proxy);
+  return g_task_propagate_pointer (G_TASK (result), error);
 }
 
 /**
@@ -29,6 +29,14 @@ G_BEGIN_DECLS
 #define CC_OBJECT_MMMANAGER    "CcObjectStorage::mm-manager"
 #define CC_OBJECT_PWQ_SETTINGS "CcObjectStorage::pw-quality-settings"
 
+/* A D-Bus proxy to create with cc_object_storage_create_dbus_proxies() */
+typedef struct
+{
+  const gchar *name;
+  const gchar *path;
+  const gchar *interface;
+} CcDBusProxyInfo;
+
 #define CC_TYPE_OBJECT_STORAGE (cc_object_storage_get_type())
 
 G_DECLARE_FINAL_TYPE (CcObjectStorage, cc_object_storage, CC, OBJECT_STORAGE, GObject)
@@ -60,6 +68,17 @@ void     cc_object_storage_create_dbus_proxy      (GBusType              bus_typ
 gpointer cc_object_storage_create_dbus_proxy_finish (GAsyncResult       *result,
                                                      GError            **error);
 
+void     cc_object_storage_create_dbus_proxies      (GBusType               bus_type,
+                                                     GDBusProxyFlags        flags,
+                                                     const CcDBusProxyInfo *proxies,
+                                                     guint                  n_proxies,
+                                                     GCancellable          *cancellable,
+                                                     GAsyncReadyCallback    callback,
+                                                     gpointer               user_data);
+
+GPtrArray *cc_object_storage_create_dbus_proxies_finish (GAsyncResult     *result,
+                                                         GError          **error);
+
 void     cc_object_storage_initialize               (void);
 
 void     cc_object_storage_destroy                  (void);
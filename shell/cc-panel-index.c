@@ -0,0 +1,330 @@
+/* cc-panel-index.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "cc-panel-index"
+
+#include <config.h>
+
+#include <string.h>
+
+#include "cc-panel-index.h"
+#include "cc-panel-metadata-cache.h"
+#include "cc-search-rank.h"
+
+/*
+ * A read-only view of the panel metadata, as serialized in the panel
+ * metadata cache, that can be searched without a CcShellModel. The search
+ * provider uses it so that answering queries needs neither GTK nor any of
+ * the panel types: the strings are read straight from the (usually mapped)
+ * cache.
+ *
+ * Results are ranked with CcSearchRank.
+ */
+
+typedef struct
+{
+  const gchar  *id;
+  const gchar  *name;
+  const gchar  *casefolded_name;
+  const gchar  *description;
+  const gchar  *casefolded_description;
+  const gchar  *icon;
+  const gchar **keywords;
+  GVariant     *meta; /* a{sv}, created on demand */
+} PanelEntry;
+
+struct _CcPanelIndex
+{
+  GObject     parent_instance;
+
+  GVariant   *entries;
+  PanelEntry *panels;
+  guint       n_panels;
+  GHashTable *positions; /* id -> position + 1 */
+};
+
+G_DEFINE_TYPE (CcPanelIndex, cc_panel_index, G_TYPE_OBJECT)
+
+static gboolean
+entry_matches_term (PanelEntry  *entry,
+                    const gchar *term)
+{
+  guint i;
+
+  if (strstr (entry->casefolded_name, term) != NULL)
+    return TRUE;
+
+  if (strstr (entry->casefolded_description, term) != NULL)
+    return TRUE;
+
+  for (i = 0; entry->keywords[i]; i++)
+    {
+      if (g_str_has_prefix (entry->keywords[i], term))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+entry_matches (PanelEntry  *entry,
+               gchar      **terms)
+{
+  guint i;
+
+  for (i = 0; terms[i]; i++)
+    {
+      if (!entry_matches_term (entry, terms[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static GVariant *
+create_result_meta (PanelEntry *entry)
+{
+  g_autofree gchar *id = NULL;
+  GVariantBuilder builder;
+
+  /* The desktop file id can always be derived from the panel id */
+  id = g_strconcat ("gnome-", entry->id, "-panel.desktop", NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+  g_variant_builder_add (&builder, "{sv}",
+                         "id", g_variant_new_string (id));
+  g_variant_builder_add (&builder, "{sv}",
+                         "name", g_variant_new_string (entry->name));
+
+  if (*entry->icon != '\0')
+    {
+      g_autoptr(GIcon) icon = g_icon_new_for_string (entry->icon, NULL);
+
+      if (icon)
+        g_variant_builder_add (&builder, "{sv}", "icon", g_icon_serialize (icon));
+    }
+
+  g_variant_builder_add (&builder, "{sv}",
+                         "description", g_variant_new_string (entry->description));
+
+  return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static void
+cc_panel_index_finalize (GObject *object)
+{
+  CcPanelIndex *self = (CcPanelIndex *)object;
+  guint i;
+
+  for (i = 0; i < self->n_panels; i++)
+    {
+      g_free (self->panels[i].keywords);
+      g_clear_pointer (&self->panels[i].meta, g_variant_unref);
+    }
+
+  g_clear_pointer (&self->panels, g_free);
+  g_clear_pointer (&self->positions, g_hash_table_destroy);
+  g_clear_pointer (&self->entries, g_variant_unref);
+
+  G_OBJECT_CLASS (cc_panel_index_parent_class)->finalize (object);
+}
+
+static void
+cc_panel_index_class_init (CcPanelIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = cc_panel_index_finalize;
+}
+
+static void
+cc_panel_index_init (CcPanelIndex *self)
+{
+  self->positions = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+/**
+ * cc_panel_index_new:
+ * @entries: panel entries, of type %CC_PANEL_METADATA_ENTRIES_FORMAT
+ *
+ * Creates an index of the panels in @entries that can be searched. The
+ * strings are not copied, and @entries is kept alive as long as the index.
+ *
+ * Returns: (transfer full): a new #CcPanelIndex
+ */
+CcPanelIndex *
+cc_panel_index_new (GVariant *entries)
+{
+  CcPanelIndex *self;
+  gsize n_entries;
+  gsize i;
+
+  g_return_val_if_fail (entries != NULL, NULL);
+  g_return_val_if_fail (g_variant_is_of_type (entries, G_VARIANT_TYPE (CC_PANEL_METADATA_ENTRIES_FORMAT)), NULL);
+
+  self = g_object_new (CC_TYPE_PANEL_INDEX, NULL);
+  self->entries = g_variant_ref_sink (entries);
+
+  n_entries = g_variant_n_children (entries);
+  self->panels = g_new0 (PanelEntry, n_entries);
+
+  for (i = 0; i < n_entries; i++)
+    {
+      g_autoptr(GVariant) child = g_variant_get_child_value (entries, i);
+      PanelEntry *entry = &self->panels[i];
+
+      /* The children are serialized inside @entries, which outlives
+       * them, so the strings stay valid after @child is unreffed */
+      g_variant_get (child, "(&suu&s&s&s&s&s^a&s)",
+                     &entry->id,
+                     NULL,
+                     NULL,
+                     &entry->name,
+                     &entry->casefolded_name,
+                     &entry->description,
+                     &entry->casefolded_description,
+                     &entry->icon,
+                     &entry->keywords);
+
+      g_hash_table_insert (self->positions,
+                           (gpointer) entry->id,
+                           GUINT_TO_POINTER (i + 1));
+    }
+
+  self->n_panels = n_entries;
+
+  return self;
+}
+
+/**
+ * cc_panel_index_get_n_panels:
+ * @self: a #CcPanelIndex
+ *
+ * Returns: the number of panels that can be found in @self.
+ */
+guint
+cc_panel_index_get_n_panels (CcPanelIndex *self)
+{
+  g_return_val_if_fail (CC_IS_PANEL_INDEX (self), 0);
+
+  return self->n_panels;
+}
+
+/**
+ * cc_panel_index_search:
+ * @self: a #CcPanelIndex
+ * @casefolded_terms: the search terms, normalized with
+ *   cc_util_normalize_casefold_and_unaccent()
+ * @candidates: (nullable): ids of the panels to consider, or %NULL for all
+ *
+ * Finds the panels that match all of @casefolded_terms, best matches
+ * first.
+ *
+ * Returns: (transfer full): the ids of the matching panels
+ */
+gchar **
+cc_panel_index_search (CcPanelIndex  *self,
+                       gchar        **casefolded_terms,
+                       gchar        **candidates)
+{
+  g_autoptr(GArray) ranks = NULL;
+  GPtrArray *results;
+  guint i;
+
+  g_return_val_if_fail (CC_IS_PANEL_INDEX (self), NULL);
+  g_return_val_if_fail (casefolded_terms != NULL, NULL);
+
+  ranks = g_array_new (FALSE, TRUE, sizeof (CcSearchRank));
+  g_array_set_clear_func (ranks, (GDestroyNotify) cc_search_rank_clear);
+
+  for (i = 0; candidates ? candidates[i] != NULL : i < self->n_panels; i++)
+    {
+      CcSearchRank rank = { 0, };
+      PanelEntry *entry;
+      guint position;
+
+      if (candidates)
+        {
+          position = GPOINTER_TO_UINT (g_hash_table_lookup (self->positions, candidates[i]));
+          if (position == 0)
+            continue;
+          position--;
+        }
+      else
+        {
+          position = i;
+        }
+
+      entry = &self->panels[position];
+      if (!entry_matches (entry, casefolded_terms))
+        continue;
+
+      cc_search_rank_init (&rank,
+                           position,
+                           entry->casefolded_name,
+                           *entry->description != '\0' ? entry->description : NULL,
+                           entry->keywords,
+                           casefolded_terms);
+      g_array_append_val (ranks, rank);
+    }
+
+  g_array_sort (ranks, cc_search_rank_compare);
+
+  results = g_ptr_array_new_full (ranks->len + 1, NULL);
+  for (i = 0; i < ranks->len; i++)
+    {
+      CcSearchRank *rank = &g_array_index (ranks, CcSearchRank, i);
+
+      g_ptr_array_add (results, g_strdup (self->panels[rank->position].id));
+    }
+  g_ptr_array_add (results, NULL);
+
+  return (gchar **) g_ptr_array_free (results, FALSE);
+}
+
+/**
+ * cc_panel_index_get_result_meta:
+ * @self: a #CcPanelIndex
+ * @id: the id of a panel
+ *
+ * Gets the description of the panel @id, in the format of the
+ * GetResultMetas() method of org.gnome.Shell.SearchProvider2.
+ *
+ * Returns: (transfer none) (nullable): a #GVariant of type a{sv}, or %NULL
+ *   if @id isn't in @self.
+ */
+GVariant *
+cc_panel_index_get_result_meta (CcPanelIndex *self,
+                                const gchar  *id)
+{
+  PanelEntry *entry;
+  guint position;
+
+  g_return_val_if_fail (CC_IS_PANEL_INDEX (self), NULL);
+  g_return_val_if_fail (id != NULL, NULL);
+
+  position = GPOINTER_TO_UINT (g_hash_table_lookup (self->positions, id));
+  if (position == 0)
+    return NULL;
+
+  entry = &self->panels[position - 1];
+  if (!entry->meta)
+    entry->meta = create_result_meta (entry);
+
+  return entry->meta;
+}
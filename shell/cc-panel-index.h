@@ -0,0 +1,40 @@
+/* cc-panel-index.h
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define CC_TYPE_PANEL_INDEX (cc_panel_index_get_type())
+
+G_DECLARE_FINAL_TYPE (CcPanelIndex, cc_panel_index, CC, PANEL_INDEX, GObject)
+
+CcPanelIndex *cc_panel_index_new             (GVariant      *entries);
+
+guint         cc_panel_index_get_n_panels    (CcPanelIndex  *self);
+
+gchar       **cc_panel_index_search          (CcPanelIndex  *self,
+                                              gchar        **casefolded_terms,
+                                              gchar        **candidates);
+
+GVariant     *cc_panel_index_get_result_meta (CcPanelIndex  *self,
+                                              const gchar   *id);
+
+G_END_DECLS
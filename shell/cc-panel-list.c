@@ -24,7 +24,7 @@
 
 #include "cc-log.h"
 #include "cc-panel-list.h"
-#include "cc-util.h"
+#include "cc-search-index.h"
 
 typedef struct
 {
@@ -36,6 +36,7 @@ typedef struct
   gchar              *description;
   gchar             **keywords;
   CcPanelVisibility   visibility;
+  guint               search_entry;
 } RowData;
 
 struct _CcPanelList
@@ -53,7 +54,7 @@ struct _CcPanelList
 
   gchar              *current_panel_id;
   gchar              *search_query;
-  gchar             **search_words;
+  CcSearchIndex      *search_index;
 
   CcPanelListView     previous_view;
   CcPanelListView     view;
@@ -313,49 +314,21 @@ filter_func (GtkListBoxRow *row,
 {
   CcPanelList *self;
   RowData *data;
-  g_autofree gchar *panel_text = NULL;
-  g_autofree gchar *panel_description = NULL;
-  gboolean retval = TRUE;
-  gint i, j;
 
   self = CC_PANEL_LIST (user_data);
   data = g_object_get_data (G_OBJECT (row), "data");
 
-  if (!self->search_words)
+  if (!self->search_query)
     return TRUE;
 
-  panel_text = cc_util_normalize_casefold_and_unaccent (data->name);
-  panel_description = cc_util_normalize_casefold_and_unaccent (data->description);
-
-  g_strstrip (panel_text);
-  g_strstrip (panel_description);
-
   /*
    * The description label is only visible when the search is
    * happening.
    */
   gtk_widget_set_visible (data->description_label, self->view == CC_PANEL_LIST_SEARCH);
 
-  for (j = 0; retval && self->search_words[j] != NULL; j++) {
-    const gchar *search_word = self->search_words[j];
-    gboolean match = FALSE;
-
-    if (search_word[0] == '\0')
-      continue;
-
-    // Compare keywords
-    for (i = 0; !match && data->keywords[i] != NULL; i++)
-      match = (strstr (data->keywords[i], search_word) == data->keywords[i]);
-
-    // Compare panel title and description
-    match = match || (g_strstr_len (panel_text, -1, search_word) != NULL ||
-                      g_strstr_len (panel_description, -1, search_word) != NULL);
-
-    // All search words must match
-    retval = retval && match;
-  }
-
-  return retval;
+  /* All search words must match; this was computed once per query */
+  return cc_search_index_entry_matches (self->search_index, data->search_entry);
 }
 
 static const gchar * const panel_order[] = {
@@ -427,8 +400,6 @@ sort_function (GtkListBoxRow *a,
 }
 
 
-/* FIXME: This is now different from the "match all words" search.
-          Maybe add a search score based on number of matches in filter_func()? */
 static gint
 search_sort_function (GtkListBoxRow *a,
                       GtkListBoxRow *b,
@@ -436,44 +407,14 @@ search_sort_function (GtkListBoxRow *a,
 {
   CcPanelList *self;
   RowData *a_data, *b_data;
-  g_autofree gchar *a_name = NULL;
-  g_autofree gchar *b_name = NULL;
-  g_autofree gchar *search = NULL;
-  gchar *a_strstr, *b_strstr;
-  gint a_distance, b_distance;
 
   self = CC_PANEL_LIST (user_data);
-  search = NULL;
   a_data = g_object_get_data (G_OBJECT (a), "data");
   b_data = g_object_get_data (G_OBJECT (b), "data");
 
-  a_distance = b_distance = G_MAXINT;
-
-  a_name = cc_util_normalize_casefold_and_unaccent (a_data->name);
-  b_name = cc_util_normalize_casefold_and_unaccent (b_data->name);
-  g_strstrip (a_name);
-  g_strstrip (b_name);
-
-  if (self->search_query)
-    {
-      search = cc_util_normalize_casefold_and_unaccent (self->search_query);
-      g_strstrip (search);
-    }
-
-  /* Default result for empty search */
-  if (!search || g_utf8_strlen (search, -1) == 0)
-    return g_strcmp0 (a_name, b_name);
-
-  a_strstr = g_strstr_len (a_name, -1, search);
-  b_strstr = g_strstr_len (b_name, -1, search);
-
-  if (a_strstr)
-    a_distance = g_strstr_len (a_name, -1, search) - a_name;
-
-  if (b_strstr)
-    b_distance = g_strstr_len (b_name, -1, search) - b_name;
-
-  return a_distance - b_distance;
+  return cc_search_index_compare_entries (self->search_index,
+                                          a_data->search_entry,
+                                          b_data->search_entry);
 }
 
 static void
@@ -592,8 +533,8 @@ cc_panel_list_finalize (GObject *object)
   CcPanelList *self = (CcPanelList *)object;
 
   g_clear_pointer (&self->search_query, g_free);
-  g_clear_pointer (&self->search_words, g_strfreev);
   g_clear_pointer (&self->current_panel_id, g_free);
+  g_clear_object (&self->search_index);
   g_clear_pointer (&self->id_to_data, g_hash_table_destroy);
   g_clear_pointer (&self->id_to_search_data, g_hash_table_destroy);
 
@@ -755,6 +696,7 @@ cc_panel_list_init (CcPanelList *self)
 
   self->id_to_data = g_hash_table_new (g_str_hash, g_str_equal);
   self->id_to_search_data = g_hash_table_new (g_str_hash, g_str_equal);
+  self->search_index = cc_search_index_new ();
   self->view = CC_PANEL_LIST_MAIN;
 
   gtk_list_box_set_sort_func (GTK_LIST_BOX (self->main_listbox),
@@ -844,16 +786,13 @@ cc_panel_list_set_search_query (CcPanelList *self,
 
   if (g_strcmp0 (self->search_query, search) != 0)
     {
-      g_autofree gchar *search_query_normalized;
-
       g_clear_pointer (&self->search_query, g_free);
-      g_clear_pointer (&self->search_words, g_strfreev);
 
       self->search_query = g_strdup (search);
 
-      /* Split on spaces */
-      search_query_normalized = cc_util_normalize_casefold_and_unaccent (search);
-      self->search_words = g_strsplit (g_strstrip (search_query_normalized), " ", 0);
+      /* Match every row against the new query once, instead of in each
+       * filter and sort function call */
+      cc_search_index_set_query (self->search_index, search);
 
       update_search (self);
 
@@ -908,6 +847,10 @@ cc_panel_list_add_panel (CcPanelList        *self,
 
   /* And add to the search listbox too */
   search_data = row_data_new (category, id, title, description, keywords, icon, visibility);
+  search_data->search_entry = cc_search_index_add (self->search_index,
+                                                   title,
+                                                   description,
+                                                   (const gchar * const *) keywords);
   gtk_widget_set_visible (search_data->row, visibility != CC_PANEL_HIDDEN);
 
   gtk_list_box_append (GTK_LIST_BOX (self->search_listbox), search_data->row);
@@ -27,6 +27,8 @@
 
 #include "cc-panel.h"
 #include "cc-panel-loader.h"
+#include "cc-panel-metadata-cache.h"
+#include "cc-profiler.h"
 
 #ifndef CC_PANEL_LOADER_NO_GTYPES
 
@@ -65,14 +67,22 @@ extern GType cc_wwan_panel_get_type (void);
 
 /* Static init functions */
 #ifdef BUILD_NETWORK
-extern void cc_wifi_panel_static_init_func (void);
+extern void cc_wifi_panel_static_init_func (GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data);
 #endif /* BUILD_NETWORK */
-extern void cc_sharing_panel_static_init_func (void);
+extern void cc_sharing_panel_static_init_func (GCancellable        *cancellable,
+                                               GAsyncReadyCallback  callback,
+                                               gpointer             user_data);
 #ifdef BUILD_WACOM
-extern void cc_wacom_panel_static_init_func (void);
+extern void cc_wacom_panel_static_init_func (GCancellable        *cancellable,
+                                             GAsyncReadyCallback  callback,
+                                             gpointer             user_data);
 #endif /* BUILD_WACOM */
 #ifdef BUILD_WWAN
-extern void cc_wwan_panel_static_init_func (void);
+extern void cc_wwan_panel_static_init_func (GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data);
 #endif /* BUILD_WWAN */
 
 #define PANEL_TYPE(name, get_type, init_func) { name, get_type, init_func }
@@ -227,19 +237,82 @@ cc_panel_loader_load_by_name (CcShell     *shell,
                        NULL);
 }
 
-#endif /* CC_PANEL_LOADER_NO_GTYPES */
-
 /**
- * cc_panel_loader_fill_model:
- * @model: a #CcShellModel
+ * cc_panel_loader_get_cacheable:
+ * @name: name of the panel
  *
- * Fills @model with information from the available panels. It
- * iterates over the panel vtable, gathering the panel names,
- * build the desktop filename from it, and retrieves additional
- * information from it.
+ * Like cc_panel_get_cacheable(), without creating an instance of the panel.
  */
-void
-cc_panel_loader_fill_model (CcShellModel *model)
+gboolean
+cc_panel_loader_get_cacheable (const gchar *name)
+{
+  GType (*get_type) (void);
+  CcPanelClass *panel_class;
+  gboolean cacheable;
+
+  ensure_panel_types ();
+
+  get_type = g_hash_table_lookup (panel_types, name);
+  if (get_type == NULL)
+    return FALSE;
+
+  panel_class = g_type_class_ref (get_type ());
+  cacheable = !panel_class->no_instance_cache;
+  g_type_class_unref (panel_class);
+
+  return cacheable;
+}
+
+typedef struct
+{
+  const gchar *name;
+  gint64       begin_time;
+} StaticInitData;
+
+static guint n_static_inits = 0;
+static guint n_pending_static_inits = 0;
+static gint64 static_inits_begin_time = 0;
+
+static void
+static_init_finished_cb (GObject      *source_object,
+                         GAsyncResult *result,
+                         gpointer      user_data)
+{
+  g_autofree StaticInitData *data = user_data;
+  g_autoptr(GError) error = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    g_debug ("Static init of panel %s failed: %s", data->name, error ? error->message : "unknown error");
+
+  cc_profiler_end_mark (data->begin_time, "Static init", "%s", data->name);
+
+  g_assert (n_pending_static_inits > 0);
+
+  if (--n_pending_static_inits == 0)
+    cc_profiler_end_mark (static_inits_begin_time, "All static inits", "%u panels", n_static_inits);
+}
+
+#endif /* CC_PANEL_LOADER_NO_GTYPES */
+
+/* Identifies the set of panels in the metadata cache */
+static gchar *
+get_metadata_cache_key (void)
+{
+  g_autoptr(GString) key = g_string_new (NULL);
+  guint i;
+
+  for (i = 0; i < panels_vtable_len; i++)
+    g_string_append_printf (key, "%s;", panels_vtable[i].name);
+
+  for (i = 0; i < supages_vtable_len; i++)
+    g_string_append_printf (key, "%s:%d;", subpages_vtable[i].name, subpages_vtable[i].category);
+
+  return g_string_free (g_steal_pointer (&key), FALSE);
+}
+
+static void
+fill_model_from_desktop_files (CcShellModel *model,
+                               GPtrArray    *sources)
 {
   guint i;
 
@@ -258,6 +331,8 @@ cc_panel_loader_fill_model (CcShellModel *model)
           continue;
         }
 
+      g_ptr_array_add (sources, g_strdup (g_desktop_app_info_get_filename (app)));
+
       category = parse_categories (app);
       if (G_UNLIKELY (category < 0))
         continue;
@@ -279,19 +354,72 @@ cc_panel_loader_fill_model (CcShellModel *model)
           continue;
         }
 
+      g_ptr_array_add (sources, g_strdup (g_desktop_app_info_get_filename (app)));
+
       cc_shell_model_add_item (model, subpages_vtable[i].category, G_APP_INFO (app), subpages_vtable[i].name);
       cc_shell_model_set_panel_visibility (model, subpages_vtable[i].name, CC_PANEL_VISIBLE_IN_SEARCH);
     }
+}
+
+/**
+ * cc_panel_loader_fill_model:
+ * @model: a #CcShellModel
+ *
+ * Fills @model with information from the available panels. It
+ * iterates over the panel vtable, gathering the panel names,
+ * build the desktop filename from it, and retrieves additional
+ * information from it.
+ *
+ * The gathered information is kept in an on-disk cache, which is
+ * used instead of the desktop files until any of them changes.
+ */
+void
+cc_panel_loader_fill_model (CcShellModel *model)
+{
+  g_autofree gchar *cache_key = NULL;
+  gint64 begin_time = CC_PROFILER_CURRENT_TIME;
+  gboolean from_cache;
+#ifndef CC_PANEL_LOADER_NO_GTYPES
+  guint i;
+#endif
+
+  cache_key = get_metadata_cache_key ();
+
+  from_cache = cc_panel_metadata_cache_load (model, cache_key);
+  if (!from_cache)
+    {
+      g_autoptr(GPtrArray) sources = g_ptr_array_new_with_free_func (g_free);
+
+      fill_model_from_desktop_files (model, sources);
+      cc_panel_metadata_cache_save (model, cache_key, sources);
+    }
 
-  /* If there's an static init function, execute it after adding all panels to
+  cc_profiler_end_mark (begin_time, "Fill model", "%s",
+                        from_cache ? "metadata cache" : "desktop files");
+
+  /* If there's an static init function, start it after adding all panels to
    * the model. This will allow the panels to show or hide themselves without
-   * having an instance running.
+   * having an instance running. They all run concurrently, and don't hold
+   * back showing the model.
    */
 #ifndef CC_PANEL_LOADER_NO_GTYPES
+  static_inits_begin_time = CC_PROFILER_CURRENT_TIME;
+
   for (i = 0; i < panels_vtable_len; i++)
     {
-      if (panels_vtable[i].static_init_func)
-        panels_vtable[i].static_init_func ();
+      StaticInitData *data;
+
+      if (!panels_vtable[i].static_init_func)
+        continue;
+
+      data = g_new0 (StaticInitData, 1);
+      data->name = panels_vtable[i].name;
+      data->begin_time = CC_PROFILER_CURRENT_TIME;
+
+      n_static_inits++;
+      n_pending_static_inits++;
+
+      panels_vtable[i].static_init_func (NULL, static_init_finished_cb, data);
     }
 #endif
 }
@@ -337,3 +465,43 @@ cc_panel_loader_override_vtable (CcPanelLoaderVtable *override_vtable,
   panels_vtable = override_vtable;
   panels_vtable_len = n_elements;
 }
+
+/**
+ * cc_panel_loader_load_index:
+ *
+ * Loads the metadata of the available panels into a #CcPanelIndex, for
+ * processes that only need to search panels. The metadata is read from
+ * the on-disk cache, so neither GTK nor the panel types are needed,
+ * unless the cache is missing or outdated.
+ *
+ * Returns: (transfer full): a #CcPanelIndex
+ */
+CcPanelIndex *
+cc_panel_loader_load_index (void)
+{
+  g_autoptr(GVariant) entries = NULL;
+  g_autofree gchar *cache_key = NULL;
+  gint64 begin_time = CC_PROFILER_CURRENT_TIME;
+  gboolean from_cache;
+
+  cache_key = get_metadata_cache_key ();
+
+  entries = cc_panel_metadata_cache_load_entries (cache_key);
+  from_cache = entries != NULL;
+
+  if (!from_cache)
+    {
+      g_autoptr(GPtrArray) sources = g_ptr_array_new_with_free_func (g_free);
+      g_autoptr(CcShellModel) model = cc_shell_model_new ();
+
+      fill_model_from_desktop_files (model, sources);
+      cc_panel_metadata_cache_save (model, cache_key, sources);
+
+      entries = cc_panel_metadata_cache_serialize (model);
+    }
+
+  cc_profiler_end_mark (begin_time, "Load index", "%s",
+                        from_cache ? "metadata cache" : "desktop files");
+
+  return cc_panel_index_new (entries);
+}
@@ -25,6 +25,7 @@
 #include <glib.h>
 #include <glib-object.h>
 #include <shell/cc-panel.h>
+#include <shell/cc-panel-index.h>
 #include <shell/cc-shell-model.h>
 
 G_BEGIN_DECLS
@@ -39,15 +40,17 @@ typedef struct
 #endif
 } CcPanelLoaderVtable;
 
-void     cc_panel_loader_fill_model     (CcShellModel  *model);
-void     cc_panel_loader_list_panels    (void);
-CcPanel *cc_panel_loader_load_by_name   (CcShell       *shell,
-                                         const char    *name,
-                                         const gchar   *title,
-                                         GVariant      *parameters);
-
-void    cc_panel_loader_override_vtable (CcPanelLoaderVtable *override_vtable,
-                                         gsize                n_elements);
+void          cc_panel_loader_fill_model      (CcShellModel        *model);
+CcPanelIndex *cc_panel_loader_load_index      (void);
+void          cc_panel_loader_list_panels     (void);
+CcPanel      *cc_panel_loader_load_by_name    (CcShell             *shell,
+                                               const char          *name,
+                                               const gchar         *title,
+                                               GVariant            *parameters);
+gboolean      cc_panel_loader_get_cacheable   (const gchar         *name);
+
+void          cc_panel_loader_override_vtable (CcPanelLoaderVtable *override_vtable,
+                                               gsize                n_elements);
 
 G_END_DECLS
 
@@ -0,0 +1,391 @@
+/* cc-panel-metadata-cache.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "cc-panel-metadata-cache"
+
+#include <config.h>
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include "cc-panel-metadata-cache.h"
+
+/*
+ * The panel metadata cache stores everything cc_panel_loader_fill_model()
+ * gathers from the panel desktop files, already normalized, as a single
+ * serialized GVariant. Loading it maps the file and reads the rows directly
+ * from the mapping, without opening or parsing any desktop file.
+ *
+ * The cache is only used when:
+ *
+ *  - its version matches CACHE_VERSION;
+ *  - its key matches, i.e. the same languages, the same data directories
+ *    and the same set of panels;
+ *  - none of the desktop files it was built from, nor the applications
+ *    directories they were looked up in, changed their modification time.
+ *
+ * Otherwise the caller fills the model from the desktop files and saves a
+ * new cache.
+ */
+
+#define CACHE_VERSION 1
+#define CACHE_FORMAT "(usa(sx)" CC_PANEL_METADATA_ENTRIES_FORMAT ")"
+
+static gchar *
+get_cache_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "gnome-control-center",
+                           "panel-metadata.cache",
+                           NULL);
+}
+
+static gchar *
+get_full_key (const gchar *key)
+{
+  g_autofree gchar *languages = NULL;
+  g_autofree gchar *system_dirs = NULL;
+
+  languages = g_strjoinv (":", (gchar **) g_get_language_names ());
+  system_dirs = g_strjoinv (":", (gchar **) g_get_system_data_dirs ());
+
+  return g_strdup_printf ("%s|%s|%s:%s|%s",
+                          VERSION,
+                          languages,
+                          g_get_user_data_dir (),
+                          system_dirs,
+                          key);
+}
+
+static gint64
+get_mtime (const gchar *path)
+{
+  GStatBuf buf;
+
+  if (g_stat (path, &buf) != 0)
+    return -1;
+
+  return (gint64) buf.st_mtime;
+}
+
+static void
+add_source (GVariantBuilder *builder,
+            const gchar     *path)
+{
+  g_variant_builder_add (builder, "(sx)", path, get_mtime (path));
+}
+
+static void
+add_applications_dirs (GVariantBuilder *builder)
+{
+  const gchar * const *system_dirs;
+  g_autofree gchar *user_dir = NULL;
+  gint i;
+
+  /* Adding, removing or overriding a desktop file changes the
+   * modification time of the directory that contains it */
+  user_dir = g_build_filename (g_get_user_data_dir (), "applications", NULL);
+  add_source (builder, user_dir);
+
+  system_dirs = g_get_system_data_dirs ();
+  for (i = 0; system_dirs[i] != NULL; i++)
+    {
+      g_autofree gchar *dir = g_build_filename (system_dirs[i], "applications", NULL);
+
+      add_source (builder, dir);
+    }
+}
+
+static const gchar *
+nullify_empty (const gchar *str)
+{
+  return str && *str != '\0' ? str : NULL;
+}
+
+/**
+ * cc_panel_metadata_cache_load_entries:
+ * @key: a string identifying the set of panels
+ *
+ * Loads the entries of the on-disk panel metadata cache, if it is valid
+ * for @key and none of the desktop files it was built from changed. The
+ * entries are read directly from the mapped file.
+ *
+ * Returns: (transfer full)(nullable): the entries of the cache, of type
+ *   %CC_PANEL_METADATA_ENTRIES_FORMAT, or %NULL.
+ */
+GVariant *
+cc_panel_metadata_cache_load_entries (const gchar *key)
+{
+  g_autoptr(GMappedFile) mapped_file = NULL;
+  g_autoptr(GVariant) cache = NULL;
+  g_autoptr(GVariant) sources = NULL;
+  g_autoptr(GVariant) entries = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *full_key = NULL;
+  g_autofree gchar *path = NULL;
+  const gchar *cached_key;
+  const gchar *source_path;
+  GVariantIter iter;
+  gint64 mtime;
+  guint32 version;
+
+  g_return_val_if_fail (key != NULL, NULL);
+
+  path = get_cache_path ();
+  mapped_file = g_mapped_file_new (path, FALSE, &error);
+  if (!mapped_file)
+    {
+      g_debug ("No panel metadata cache: %s", error->message);
+      return NULL;
+    }
+
+  bytes = g_mapped_file_get_bytes (mapped_file);
+  cache = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_FORMAT), bytes, FALSE));
+
+  g_variant_get_child (cache, 0, "u", &version);
+  if (version != CACHE_VERSION)
+    {
+      g_debug ("Ignoring panel metadata cache with version %u", version);
+      return NULL;
+    }
+
+  full_key = get_full_key (key);
+  g_variant_get_child (cache, 1, "&s", &cached_key);
+  if (g_strcmp0 (cached_key, full_key) != 0)
+    {
+      g_debug ("Ignoring panel metadata cache for a different locale or panel set");
+      return NULL;
+    }
+
+  sources = g_variant_get_child_value (cache, 2);
+  g_variant_iter_init (&iter, sources);
+  while (g_variant_iter_next (&iter, "(&sx)", &source_path, &mtime))
+    {
+      if (get_mtime (source_path) != mtime)
+        {
+          g_debug ("Ignoring outdated panel metadata cache (%s changed)", source_path);
+          return NULL;
+        }
+    }
+
+  entries = g_variant_get_child_value (cache, 3);
+  if (g_variant_n_children (entries) == 0)
+    return NULL;
+
+  return g_steal_pointer (&entries);
+}
+
+/**
+ * cc_panel_metadata_cache_load:
+ * @model: a #CcShellModel
+ * @key: a string identifying the set of panels
+ *
+ * Fills @model from the on-disk panel metadata cache, if it is valid for
+ * @key and none of the desktop files it was built from changed.
+ *
+ * Returns: %TRUE if @model was filled, %FALSE otherwise.
+ */
+gboolean
+cc_panel_metadata_cache_load (CcShellModel *model,
+                              const gchar  *key)
+{
+  g_autoptr(GVariant) entries = NULL;
+  const gchar *icon_string;
+  const gchar *casefolded_description;
+  const gchar *casefolded_name;
+  const gchar *description;
+  const gchar *name;
+  const gchar *id;
+  const gchar **keywords;
+  GVariantIter iter;
+  guint32 visibility;
+  guint32 category;
+
+  g_return_val_if_fail (CC_IS_SHELL_MODEL (model), FALSE);
+  g_return_val_if_fail (key != NULL, FALSE);
+
+  entries = cc_panel_metadata_cache_load_entries (key);
+  if (!entries)
+    return FALSE;
+
+  g_variant_iter_init (&iter, entries);
+  while (g_variant_iter_loop (&iter, "(&suu&s&s&s&s&s^a&s)",
+                              &id,
+                              &category,
+                              &visibility,
+                              &name,
+                              &casefolded_name,
+                              &description,
+                              &casefolded_description,
+                              &icon_string,
+                              &keywords))
+    {
+      g_autoptr(GIcon) icon = NULL;
+
+      if (*icon_string != '\0')
+        icon = g_icon_new_for_string (icon_string, NULL);
+
+      cc_shell_model_add_item_full (model,
+                                    category,
+                                    id,
+                                    name,
+                                    casefolded_name,
+                                    nullify_empty (description),
+                                    nullify_empty (casefolded_description),
+                                    icon,
+                                    keywords,
+                                    visibility);
+    }
+
+  g_debug ("Loaded %" G_GSIZE_FORMAT " panels from the metadata cache",
+           g_variant_n_children (entries));
+
+  return TRUE;
+}
+
+/**
+ * cc_panel_metadata_cache_serialize:
+ * @model: a #CcShellModel
+ *
+ * Serializes the rows of @model the way they are stored in the cache.
+ * Empty strings stand for missing descriptions and icons.
+ *
+ * Returns: (transfer full): the entries for @model, of type
+ *   %CC_PANEL_METADATA_ENTRIES_FORMAT.
+ */
+GVariant *
+cc_panel_metadata_cache_serialize (CcShellModel *model)
+{
+  GVariantBuilder entries_builder;
+  GtkTreeIter iter;
+  gboolean valid;
+
+  g_return_val_if_fail (CC_IS_SHELL_MODEL (model), NULL);
+
+  g_variant_builder_init (&entries_builder, G_VARIANT_TYPE (CC_PANEL_METADATA_ENTRIES_FORMAT));
+
+  valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (model), &iter);
+  while (valid)
+    {
+      g_autofree gchar *casefolded_description = NULL;
+      g_autofree gchar *casefolded_name = NULL;
+      g_autofree gchar *icon_string = NULL;
+      g_autofree gchar *description = NULL;
+      g_autofree gchar *name = NULL;
+      g_autofree gchar *id = NULL;
+      g_auto(GStrv) keywords = NULL;
+      g_autoptr(GIcon) icon = NULL;
+      const gchar *no_keywords[] = { NULL };
+      guint visibility;
+      guint category;
+
+      gtk_tree_model_get (GTK_TREE_MODEL (model), &iter,
+                          COL_ID, &id,
+                          COL_CATEGORY, &category,
+                          COL_VISIBILITY, &visibility,
+                          COL_NAME, &name,
+                          COL_CASEFOLDED_NAME, &casefolded_name,
+                          COL_DESCRIPTION, &description,
+                          COL_CASEFOLDED_DESCRIPTION, &casefolded_description,
+                          COL_GICON, &icon,
+                          COL_KEYWORDS, &keywords,
+                          -1);
+
+      if (icon)
+        icon_string = g_icon_to_string (icon);
+
+      g_variant_builder_add (&entries_builder, "(suusssss@as)",
+                             id,
+                             category,
+                             visibility,
+                             name ? name : "",
+                             casefolded_name ? casefolded_name : "",
+                             description ? description : "",
+                             casefolded_description ? casefolded_description : "",
+                             icon_string ? icon_string : "",
+                             g_variant_new_strv (keywords ? (const gchar * const *) keywords : no_keywords, -1));
+
+      valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter);
+    }
+
+  return g_variant_ref_sink (g_variant_builder_end (&entries_builder));
+}
+
+/**
+ * cc_panel_metadata_cache_save:
+ * @model: a #CcShellModel filled from desktop files
+ * @key: a string identifying the set of panels
+ * @sources: (element-type utf8): paths of the desktop files @model was filled from
+ *
+ * Saves the contents of @model to the on-disk panel metadata cache, so
+ * that the next cc_panel_metadata_cache_load() with the same @key can
+ * skip parsing the desktop files in @sources.
+ */
+void
+cc_panel_metadata_cache_save (CcShellModel *model,
+                              const gchar  *key,
+                              GPtrArray    *sources)
+{
+  g_autoptr(GVariant) entries = NULL;
+  g_autoptr(GVariant) cache = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *full_key = NULL;
+  g_autofree gchar *path = NULL;
+  g_autofree gchar *dir = NULL;
+  GVariantBuilder sources_builder;
+  guint i;
+
+  g_return_if_fail (CC_IS_SHELL_MODEL (model));
+  g_return_if_fail (key != NULL);
+  g_return_if_fail (sources != NULL);
+
+  g_variant_builder_init (&sources_builder, G_VARIANT_TYPE ("a(sx)"));
+  for (i = 0; i < sources->len; i++)
+    add_source (&sources_builder, g_ptr_array_index (sources, i));
+  add_applications_dirs (&sources_builder);
+
+  entries = cc_panel_metadata_cache_serialize (model);
+
+  full_key = get_full_key (key);
+  cache = g_variant_ref_sink (g_variant_new ("(usa(sx)@" CC_PANEL_METADATA_ENTRIES_FORMAT ")",
+                                             CACHE_VERSION,
+                                             full_key,
+                                             &sources_builder,
+                                             entries));
+
+  path = get_cache_path ();
+  dir = g_path_get_dirname (path);
+
+  if (g_mkdir_with_parents (dir, 0755) != 0)
+    {
+      g_debug ("Failed to create %s, not saving the panel metadata cache", dir);
+      return;
+    }
+
+  if (!g_file_set_contents (path,
+                            g_variant_get_data (cache),
+                            g_variant_get_size (cache),
+                            &error))
+    {
+      g_debug ("Failed to save the panel metadata cache: %s", error->message);
+      return;
+    }
+
+  g_debug ("Saved the panel metadata cache to %s", path);
+}
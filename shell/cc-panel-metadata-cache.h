@@ -0,0 +1,40 @@
+/* cc-panel-metadata-cache.h
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <shell/cc-shell-model.h>
+
+G_BEGIN_DECLS
+
+/* Type of the entries of the cache, one per panel */
+#define CC_PANEL_METADATA_ENTRIES_FORMAT "a(suusssssas)"
+
+GVariant *cc_panel_metadata_cache_load_entries (const gchar  *key);
+
+gboolean  cc_panel_metadata_cache_load         (CcShellModel *model,
+                                                const gchar  *key);
+
+GVariant *cc_panel_metadata_cache_serialize    (CcShellModel *model);
+
+void      cc_panel_metadata_cache_save         (CcShellModel *model,
+                                                const gchar  *key,
+                                                GPtrArray    *sources);
+
+G_END_DECLS
@@ -315,6 +315,63 @@ cc_panel_deactivate (CcPanel *panel)
   g_cancellable_cancel (priv->cancellable);
 }
 
+/**
+ * cc_panel_suspend:
+ * @panel: A #CcPanel
+ *
+ * Tells @panel that the shell keeps it around, hidden, while another
+ * panel is shown. It stops anything that shouldn't keep running in the
+ * background until cc_panel_resume() is called.
+ */
+void
+cc_panel_suspend (CcPanel *panel)
+{
+  CcPanelClass *class = CC_PANEL_GET_CLASS (panel);
+
+  g_return_if_fail (CC_IS_PANEL (panel));
+
+  if (class->suspend)
+    class->suspend (panel);
+}
+
+/**
+ * cc_panel_resume:
+ * @panel: A #CcPanel
+ *
+ * Tells @panel, previously suspended with cc_panel_suspend(), that it
+ * is about to be shown again.
+ */
+void
+cc_panel_resume (CcPanel *panel)
+{
+  CcPanelClass *class = CC_PANEL_GET_CLASS (panel);
+
+  g_return_if_fail (CC_IS_PANEL (panel));
+
+  if (class->resume)
+    class->resume (panel);
+}
+
+/**
+ * cc_panel_get_cacheable:
+ * @panel: A #CcPanel
+ *
+ * Whether the shell may keep @panel around after switching to another
+ * panel, and show the same instance again instead of constructing a new
+ * one. Cached panels are suspended, see cc_panel_suspend(). Panels that
+ * can't stop their background work opt out by setting
+ * #CcPanelClass.no_instance_cache.
+ *
+ * Returns: %TRUE if @panel can be reused
+ */
+gboolean
+cc_panel_get_cacheable (CcPanel *panel)
+{
+  g_return_val_if_fail (CC_IS_PANEL (panel), FALSE);
+
+  return !CC_PANEL_GET_CLASS (panel)->no_instance_cache;
+}
+
 void
 cc_panel_add_subpage (CcPanel     *panel,
                       const gchar *page_tag,
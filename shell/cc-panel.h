@@ -41,8 +41,16 @@
  * e.g. the Wi-Fi panel, these panels can use this function to
  * show or hide themselves without needing to have an instance
  * created and running.
+ *
+ * Static init functions of all panels run concurrently while the
+ * sidebar is already shown, so they must not block: any slow probe
+ * runs asynchronously or in a thread, and updates the panel
+ * visibility when it finishes. Completion is reported by returning
+ * a boolean from a #GTask created with @callback and @user_data.
  */
-typedef void (*CcPanelStaticInitFunc) (void);
+typedef void (*CcPanelStaticInitFunc) (GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data);
 
 
 #define CC_TYPE_PANEL (cc_panel_get_type())
@@ -78,6 +86,16 @@ struct _CcPanelClass
   AdwNavigationPageClass parent_class;
 
   const gchar* (*get_help_uri)       (CcPanel *panel);
+
+  /* Called when the shell keeps the panel around while another one is
+   * shown, and before showing it again. Panels stop and restart their
+   * streams, monitors and timers there */
+  void          (*suspend)           (CcPanel *panel);
+  void          (*resume)            (CcPanel *panel);
+
+  /* Set to %TRUE by panels that must be reconstructed every time they
+   * are shown, instead of being kept around by the shell for reuse */
+  gboolean      no_instance_cache;
 };
 
 CcShell*      cc_panel_get_shell          (CcPanel     *panel);
@@ -90,6 +108,12 @@ GCancellable *cc_panel_get_cancellable    (CcPanel     *panel);
 
 void          cc_panel_deactivate         (CcPanel     *panel);
 
+void          cc_panel_suspend            (CcPanel     *panel);
+
+void          cc_panel_resume             (CcPanel     *panel);
+
+gboolean      cc_panel_get_cacheable      (CcPanel     *panel);
+
 void          cc_panel_add_subpage        (CcPanel     *panel,
                                            const gchar *page_tag,
                                            AdwNavigationPage *subpage);
@@ -0,0 +1,249 @@
+/* cc-profiler.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "cc-profiler"
+
+#include <config.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#ifdef HAVE_SYSPROF
+#include <sysprof-capture.h>
+#endif
+
+#include "cc-profiler.h"
+
+/*
+ * Marks are sent to Sysprof, when running under it, and written to the
+ * trace file passed to cc_profiler_start_trace_file(), if any.
+ *
+ * The trace file uses the Trace Event Format understood by Perfetto and
+ * chrome://tracing: a JSON array with one complete ("X") event per mark.
+ * Every event is flushed as soon as it is written, and the array is left
+ * open until cc_profiler_stop(), which both tools accept, so the trace
+ * is still usable if the process doesn't exit cleanly.
+ */
+
+#define TRACE_CATEGORY "gnome-control-center"
+
+static GMutex trace_lock;
+static FILE *trace_file = NULL;
+static gboolean trace_has_events = FALSE;
+
+static void
+append_escaped (GString     *str,
+                const gchar *text)
+{
+  const gchar *p;
+
+  for (p = text; *p != '\0'; p++)
+    {
+      switch (*p)
+        {
+        case '"':
+          g_string_append (str, "\\\"");
+          break;
+
+        case '\\':
+          g_string_append (str, "\\\\");
+          break;
+
+        case '\n':
+          g_string_append (str, "\\n");
+          break;
+
+        case '\t':
+          g_string_append (str, "\\t");
+          break;
+
+        default:
+          if ((guchar) *p < 0x20)
+            g_string_append_printf (str, "\\u%04x", (guchar) *p);
+          else
+            g_string_append_c (str, *p);
+        }
+    }
+}
+
+static void
+write_trace_event (gint64       begin_time,
+                   gint64       duration,
+                   const gchar *name,
+                   const gchar *message)
+{
+  g_autoptr(GString) event = g_string_new (NULL);
+
+  g_string_append (event, "{\"name\":\"");
+  append_escaped (event, name);
+  g_string_append_printf (event,
+                          "\",\"cat\":\"" TRACE_CATEGORY "\",\"ph\":\"X\","
+                          "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%" G_GUINTPTR_FORMAT,
+                          begin_time / 1000.0,
+                          duration / 1000.0,
+                          (gint) getpid (),
+                          (guintptr) g_thread_self ());
+
+  if (message && *message != '\0')
+    {
+      g_string_append (event, ",\"args\":{\"message\":\"");
+      append_escaped (event, message);
+      g_string_append (event, "\"}");
+    }
+
+  g_string_append_c (event, '}');
+
+  g_mutex_lock (&trace_lock);
+
+  if (trace_file)
+    {
+      fprintf (trace_file, "%s\n%s", trace_has_events ? "," : "", event->str);
+      fflush (trace_file);
+      trace_has_events = TRUE;
+    }
+
+  g_mutex_unlock (&trace_lock);
+}
+
+/**
+ * cc_profiler_start_trace_file:
+ * @path: the file to write the trace to
+ * @error: return location for a #GError
+ *
+ * Starts writing every mark to @path, replacing its contents, until
+ * cc_profiler_stop() is called.
+ *
+ * Returns: %TRUE if @path could be opened, %FALSE otherwise.
+ */
+gboolean
+cc_profiler_start_trace_file (const gchar  *path,
+                              GError      **error)
+{
+  FILE *file;
+
+  g_return_val_if_fail (path != NULL, FALSE);
+  g_return_val_if_fail (!error || !*error, FALSE);
+
+  file = g_fopen (path, "we");
+  if (!file)
+    {
+      int saved_errno = errno;
+
+      g_set_error (error,
+                   G_IO_ERROR,
+                   g_io_error_from_errno (saved_errno),
+                   "Failed to open %s: %s",
+                   path,
+                   g_strerror (saved_errno));
+      return FALSE;
+    }
+
+  fputs ("[", file);
+
+  g_mutex_lock (&trace_lock);
+
+  if (trace_file)
+    fclose (trace_file);
+
+  g_atomic_pointer_set (&trace_file, file);
+  trace_has_events = FALSE;
+
+  g_mutex_unlock (&trace_lock);
+
+  g_debug ("Writing trace to %s", path);
+
+  return TRUE;
+}
+
+/**
+ * cc_profiler_stop:
+ *
+ * Terminates and closes the trace file, if any.
+ */
+void
+cc_profiler_stop (void)
+{
+  g_mutex_lock (&trace_lock);
+
+  if (trace_file)
+    {
+      fputs ("\n]\n", trace_file);
+      fclose (trace_file);
+      g_atomic_pointer_set (&trace_file, NULL);
+    }
+
+  g_mutex_unlock (&trace_lock);
+}
+
+/**
+ * cc_profiler_is_running:
+ *
+ * Returns: %TRUE if marks are recorded anywhere. Callers can use it to
+ *   avoid formatting messages that would be discarded.
+ */
+gboolean
+cc_profiler_is_running (void)
+{
+#ifdef HAVE_SYSPROF
+  if (sysprof_collector_is_active ())
+    return TRUE;
+#endif
+
+  return g_atomic_pointer_get (&trace_file) != NULL;
+}
+
+/**
+ * cc_profiler_add_mark:
+ * @begin_time: when the phase started, from %CC_PROFILER_CURRENT_TIME
+ * @duration: the duration of the phase, in nanoseconds
+ * @name: the name of the phase
+ * @message_format: printf()-style format of a message describing the mark
+ * @...: the parameters to insert into @message_format
+ *
+ * Records a mark for a phase of @duration nanoseconds. Marks can be added
+ * from any thread.
+ */
+void
+cc_profiler_add_mark (gint64       begin_time,
+                      gint64       duration,
+                      const gchar *name,
+                      const gchar *message_format,
+                      ...)
+{
+  g_autofree gchar *message = NULL;
+  va_list args;
+
+  g_return_if_fail (name != NULL);
+  g_return_if_fail (message_format != NULL);
+
+  if (!cc_profiler_is_running ())
+    return;
+
+  va_start (args, message_format);
+  message = g_strdup_vprintf (message_format, args);
+  va_end (args);
+
+#ifdef HAVE_SYSPROF
+  sysprof_collector_mark (begin_time, duration, TRACE_CATEGORY, name, message);
+#endif
+
+  write_trace_event (begin_time, duration, name, message);
+}
@@ -0,0 +1,51 @@
+/* cc-profiler.h
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Monotonic time in nanoseconds, the unit used by all marks */
+#define CC_PROFILER_CURRENT_TIME (g_get_monotonic_time () * 1000)
+
+gboolean cc_profiler_start_trace_file (const gchar  *path,
+                                       GError      **error);
+
+void     cc_profiler_stop             (void);
+
+gboolean cc_profiler_is_running       (void);
+
+void     cc_profiler_add_mark         (gint64        begin_time,
+                                       gint64        duration,
+                                       const gchar  *name,
+                                       const gchar  *message_format,
+                                       ...) G_GNUC_PRINTF (4, 5);
+
+/* Adds a mark that started at @begin_time and ends now */
+#define cc_profiler_end_mark(begin_time, name, ...)                             \
+  G_STMT_START {                                                                \
+    if (cc_profiler_is_running ())                                              \
+      cc_profiler_add_mark ((begin_time),                                       \
+                            CC_PROFILER_CURRENT_TIME - (begin_time),            \
+                            (name),                                             \
+                            __VA_ARGS__);                                       \
+  } G_STMT_END
+
+G_END_DECLS
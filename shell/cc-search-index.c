@@ -0,0 +1,489 @@
+/* cc-search-index.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define G_LOG_DOMAIN "cc-search-index"
+
+#include <string.h>
+
+#include "cc-search-index.h"
+#include "cc-util.h"
+
+/*
+ * CcSearchIndex keeps the normalized (casefolded and unaccented) name,
+ * description and keywords of every entry, and a byte-wise prefix trie
+ * built from them:
+ *
+ *  - every suffix of every word of the name and description is inserted,
+ *    so walking the trie with a search term answers "is a substring of";
+ *  - every keyword is inserted as a whole, so walking the trie answers
+ *    "is a prefix of".
+ *
+ * Each trie node holds the sorted list of entries whose strings pass
+ * through it. Setting a query walks the trie once per search term and
+ * intersects the posting lists into a bitset, so checking whether an
+ * entry matches is a single bit test.
+ */
+
+typedef struct _TrieNode TrieNode;
+
+struct _TrieNode
+{
+  TrieNode *children;
+  TrieNode *next;
+  GArray   *postings; /* guint, sorted and unique */
+  guchar    byte;
+};
+
+typedef struct
+{
+  gchar  *name;
+  gchar  *description;
+  gint    score;
+} Entry;
+
+struct _CcSearchIndex
+{
+  GObject   parent_instance;
+
+  TrieNode *root;
+  GArray   *entries;
+
+  gchar    *query;
+  guint     n_terms;
+  guint32  *match_bits;
+};
+
+G_DEFINE_TYPE (CcSearchIndex, cc_search_index, G_TYPE_OBJECT)
+
+/*
+ * Trie
+ */
+static TrieNode *
+trie_node_new (guchar byte)
+{
+  TrieNode *node = g_new0 (TrieNode, 1);
+
+  node->byte = byte;
+
+  return node;
+}
+
+static void
+trie_node_free (TrieNode *node)
+{
+  while (node)
+    {
+      TrieNode *next = node->next;
+
+      trie_node_free (node->children);
+      g_clear_pointer (&node->postings, g_array_unref);
+      g_free (node);
+
+      node = next;
+    }
+}
+
+static TrieNode *
+trie_node_get_child (TrieNode *node,
+                     guchar    byte,
+                     gboolean  create)
+{
+  TrieNode *child;
+
+  for (child = node->children; child != NULL; child = child->next)
+    {
+      if (child->byte == byte)
+        return child;
+    }
+
+  if (!create)
+    return NULL;
+
+  child = trie_node_new (byte);
+  child->next = node->children;
+  node->children = child;
+
+  return child;
+}
+
+static void
+trie_node_add_posting (TrieNode *node,
+                       guint     entry)
+{
+  if (!node->postings)
+    node->postings = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  /* Entries are always added in increasing order, so checking the
+   * last posting is enough to keep the list unique */
+  if (node->postings->len > 0 &&
+      g_array_index (node->postings, guint, node->postings->len - 1) == entry)
+    return;
+
+  g_array_append_val (node->postings, entry);
+}
+
+static void
+trie_insert (TrieNode    *root,
+             const gchar *str,
+             gsize        len,
+             guint        entry)
+{
+  TrieNode *node = root;
+  gsize i;
+
+  for (i = 0; i < len; i++)
+    {
+      node = trie_node_get_child (node, (guchar) str[i], TRUE);
+      trie_node_add_posting (node, entry);
+    }
+}
+
+static GArray *
+trie_lookup (TrieNode    *root,
+             const gchar *str)
+{
+  TrieNode *node = root;
+
+  for (; *str != '\0' && node != NULL; str++)
+    node = trie_node_get_child (node, (guchar) *str, FALSE);
+
+  return node ? node->postings : NULL;
+}
+
+/* Inserts every suffix of every space-separated word of @str */
+static void
+trie_insert_substrings (TrieNode    *root,
+                        const gchar *str,
+                        guint        entry)
+{
+  const gchar *word_start;
+
+  if (!str)
+    return;
+
+  word_start = str;
+
+  while (*word_start != '\0')
+    {
+      const gchar *word_end;
+      const gchar *p;
+
+      while (*word_start == ' ')
+        word_start++;
+
+      word_end = word_start;
+      while (*word_end != '\0' && *word_end != ' ')
+        word_end++;
+
+      for (p = word_start; p < word_end; p = g_utf8_next_char (p))
+        trie_insert (root, p, word_end - p, entry);
+
+      word_start = word_end;
+    }
+}
+
+/*
+ * Auxiliary methods
+ */
+static gchar *
+normalize (const gchar *str)
+{
+  gchar *normalized;
+
+  normalized = cc_util_normalize_casefold_and_unaccent (str);
+  if (normalized)
+    g_strstrip (normalized);
+
+  return normalized;
+}
+
+static void
+entry_clear (Entry *entry)
+{
+  g_clear_pointer (&entry->name, g_free);
+  g_clear_pointer (&entry->description, g_free);
+}
+
+static inline Entry *
+get_entry (CcSearchIndex *self,
+           guint          entry)
+{
+  g_assert (entry < self->entries->len);
+
+  return &g_array_index (self->entries, Entry, entry);
+}
+
+static void
+update_scores (CcSearchIndex *self)
+{
+  guint i;
+
+  for (i = 0; i < self->entries->len; i++)
+    {
+      Entry *entry = get_entry (self, i);
+      const gchar *match = NULL;
+
+      if (self->query && *self->query != '\0' && entry->name)
+        match = strstr (entry->name, self->query);
+
+      entry->score = match ? (gint) (match - entry->name) : G_MAXINT;
+    }
+}
+
+static void
+update_matches (CcSearchIndex *self)
+{
+  g_auto(GStrv) terms = NULL;
+  g_autofree guint *counts = NULL;
+  guint n_entries;
+  guint i;
+
+  n_entries = self->entries->len;
+
+  g_clear_pointer (&self->match_bits, g_free);
+  self->match_bits = g_new0 (guint32, (n_entries + 31) / 32);
+  self->n_terms = 0;
+
+  terms = g_strsplit (self->query ? self->query : "", " ", 0);
+  counts = g_new0 (guint, n_entries);
+
+  for (i = 0; terms[i] != NULL; i++)
+    {
+      GArray *postings;
+      guint j;
+
+      if (terms[i][0] == '\0')
+        continue;
+
+      self->n_terms++;
+
+      postings = trie_lookup (self->root, terms[i]);
+      if (!postings)
+        return;
+
+      for (j = 0; j < postings->len; j++)
+        counts[g_array_index (postings, guint, j)]++;
+    }
+
+  /* All terms must match */
+  for (i = 0; i < n_entries; i++)
+    {
+      if (counts[i] == self->n_terms)
+        self->match_bits[i / 32] |= 1u << (i % 32);
+    }
+}
+
+/*
+ * GObject overrides
+ */
+static void
+cc_search_index_finalize (GObject *object)
+{
+  CcSearchIndex *self = (CcSearchIndex *)object;
+
+  g_clear_pointer (&self->root, trie_node_free);
+  g_clear_pointer (&self->entries, g_array_unref);
+  g_clear_pointer (&self->query, g_free);
+  g_clear_pointer (&self->match_bits, g_free);
+
+  G_OBJECT_CLASS (cc_search_index_parent_class)->finalize (object);
+}
+
+static void
+cc_search_index_class_init (CcSearchIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = cc_search_index_finalize;
+}
+
+static void
+cc_search_index_init (CcSearchIndex *self)
+{
+  self->root = trie_node_new (0);
+  self->entries = g_array_new (FALSE, TRUE, sizeof (Entry));
+  g_array_set_clear_func (self->entries, (GDestroyNotify) entry_clear);
+}
+
+CcSearchIndex *
+cc_search_index_new (void)
+{
+  return g_object_new (CC_TYPE_SEARCH_INDEX, NULL);
+}
+
+/**
+ * cc_search_index_add:
+ * @self: a #CcSearchIndex
+ * @name: the name of the entry
+ * @description: (nullable): the description of the entry
+ * @keywords: (nullable): the keywords of the entry
+ *
+ * Normalizes @name, @description and @keywords and adds them to the
+ * index. Search terms are matched as substrings of the name and
+ * description, and as prefixes of the keywords.
+ *
+ * Returns: the position of the new entry in @self.
+ */
+guint
+cc_search_index_add (CcSearchIndex       *self,
+                     const gchar         *name,
+                     const gchar         *description,
+                     const gchar * const *keywords)
+{
+  Entry entry = { NULL, };
+  guint position;
+  gint i;
+
+  g_return_val_if_fail (CC_IS_SEARCH_INDEX (self), 0);
+
+  position = self->entries->len;
+
+  entry.name = normalize (name);
+  entry.description = normalize (description);
+  entry.score = G_MAXINT;
+
+  trie_insert_substrings (self->root, entry.name, position);
+  trie_insert_substrings (self->root, entry.description, position);
+
+  for (i = 0; keywords && keywords[i] != NULL; i++)
+    {
+      g_autofree gchar *keyword = normalize (keywords[i]);
+
+      trie_insert (self->root, keyword, strlen (keyword), position);
+    }
+
+  g_array_append_val (self->entries, entry);
+
+  /* Keep the new entry consistent with the current query */
+  if (self->query)
+    {
+      update_matches (self);
+      update_scores (self);
+    }
+
+  return position;
+}
+
+guint
+cc_search_index_get_n_entries (CcSearchIndex *self)
+{
+  g_return_val_if_fail (CC_IS_SEARCH_INDEX (self), 0);
+
+  return self->entries->len;
+}
+
+/**
+ * cc_search_index_set_query:
+ * @self: a #CcSearchIndex
+ * @query: (nullable): the search query
+ *
+ * Sets the current search query. @query is normalized and split on
+ * spaces, and an entry matches when all of the resulting terms match.
+ */
+void
+cc_search_index_set_query (CcSearchIndex *self,
+                           const gchar   *query)
+{
+  g_return_if_fail (CC_IS_SEARCH_INDEX (self));
+
+  g_clear_pointer (&self->query, g_free);
+  self->query = query ? normalize (query) : NULL;
+
+  update_matches (self);
+  update_scores (self);
+}
+
+/**
+ * cc_search_index_has_query:
+ * @self: a #CcSearchIndex
+ *
+ * Returns: %TRUE if the current query has at least one non-empty term.
+ */
+gboolean
+cc_search_index_has_query (CcSearchIndex *self)
+{
+  g_return_val_if_fail (CC_IS_SEARCH_INDEX (self), FALSE);
+
+  return self->n_terms > 0;
+}
+
+gboolean
+cc_search_index_entry_matches (CcSearchIndex *self,
+                               guint          entry)
+{
+  g_return_val_if_fail (CC_IS_SEARCH_INDEX (self), FALSE);
+  g_return_val_if_fail (entry < self->entries->len, FALSE);
+
+  if (!self->match_bits)
+    return TRUE;
+
+  return (self->match_bits[entry / 32] & (1u << (entry % 32))) != 0;
+}
+
+/**
+ * cc_search_index_entry_get_score:
+ * @self: a #CcSearchIndex
+ * @entry: the position of the entry
+ *
+ * Returns: the offset of the whole query inside the normalized name of
+ *   @entry, or %G_MAXINT if the name doesn't contain it. Lower is better.
+ */
+gint
+cc_search_index_entry_get_score (CcSearchIndex *self,
+                                 guint          entry)
+{
+  g_return_val_if_fail (CC_IS_SEARCH_INDEX (self), G_MAXINT);
+
+  return get_entry (self, entry)->score;
+}
+
+/**
+ * cc_search_index_compare_entries:
+ * @self: a #CcSearchIndex
+ * @a: the position of the first entry
+ * @b: the position of the second entry
+ *
+ * Compares two entries by their score for the current query, or by
+ * their normalized names when there is no query.
+ *
+ * Returns: a negative value if @a sorts before @b, a positive value if
+ *   @a sorts after @b, and zero otherwise.
+ */
+gint
+cc_search_index_compare_entries (CcSearchIndex *self,
+                                 guint          a,
+                                 guint          b)
+{
+  Entry *a_entry, *b_entry;
+
+  g_return_val_if_fail (CC_IS_SEARCH_INDEX (self), 0);
+
+  a_entry = get_entry (self, a);
+  b_entry = get_entry (self, b);
+
+  /* Default result for empty search */
+  if (!self->query || *self->query == '\0')
+    return g_strcmp0 (a_entry->name, b_entry->name);
+
+  if (a_entry->score < b_entry->score)
+    return -1;
+  else if (a_entry->score > b_entry->score)
+    return 1;
+
+  return 0;
+}
@@ -0,0 +1,53 @@
+/* cc-search-index.h
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define CC_TYPE_SEARCH_INDEX (cc_search_index_get_type())
+
+G_DECLARE_FINAL_TYPE (CcSearchIndex, cc_search_index, CC, SEARCH_INDEX, GObject)
+
+CcSearchIndex *cc_search_index_new               (void);
+
+guint          cc_search_index_add               (CcSearchIndex       *self,
+                                                  const gchar         *name,
+                                                  const gchar         *description,
+                                                  const gchar * const *keywords);
+
+guint          cc_search_index_get_n_entries     (CcSearchIndex       *self);
+
+void           cc_search_index_set_query         (CcSearchIndex       *self,
+                                                  const gchar         *query);
+
+gboolean       cc_search_index_has_query         (CcSearchIndex       *self);
+
+gboolean       cc_search_index_entry_matches     (CcSearchIndex       *self,
+                                                  guint                entry);
+
+gint           cc_search_index_entry_get_score   (CcSearchIndex       *self,
+                                                  guint                entry);
+
+gint           cc_search_index_compare_entries   (CcSearchIndex       *self,
+                                                  guint                a,
+                                                  guint                b);
+
+G_END_DECLS
@@ -0,0 +1,128 @@
+/* cc-search-rank.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "cc-search-rank.h"
+
+/* Maximum number of terms taken into account when ranking names */
+#define MAX_NAME_TERMS 64
+
+static gint
+count_matches (const gchar * const *keywords,
+               gchar              **terms)
+{
+  gint i, j, c;
+
+  if (!keywords || !terms)
+    return 0;
+
+  c = 0;
+
+  for (i = 0; terms[i]; ++i)
+    for (j = 0; keywords[j]; ++j)
+      if (strstr (keywords[j], terms[i]))
+        c += 1;
+
+  return c;
+}
+
+/**
+ * cc_search_rank_init:
+ * @rank: the #CcSearchRank to initialize
+ * @position: the position of the panel, returned as is
+ * @casefolded_name: the casefolded name of the panel
+ * @description: (nullable): the description of the panel
+ * @casefolded_keywords: (nullable): the casefolded keywords of the panel
+ * @terms: the casefolded search terms
+ *
+ * Computes the rank of a panel for @terms. @rank must be cleared with
+ * cc_search_rank_clear() afterwards.
+ */
+void
+cc_search_rank_init (CcSearchRank        *rank,
+                     gint                 position,
+                     const gchar         *casefolded_name,
+                     const gchar         *description,
+                     const gchar * const *casefolded_keywords,
+                     gchar              **terms)
+{
+  gint i;
+
+  rank->position = position;
+  rank->name = g_strdup (casefolded_name ? casefolded_name : "");
+
+  rank->name_matches = 0;
+  for (i = 0; terms[i] && i < MAX_NAME_TERMS; i++)
+    {
+      if (strstr (rank->name, terms[i]) != NULL)
+        rank->name_matches |= G_GUINT64_CONSTANT (1) << (MAX_NAME_TERMS - 1 - i);
+    }
+
+  rank->keyword_matches = count_matches (casefolded_keywords, terms);
+
+  rank->has_description = description != NULL;
+  rank->description_matches = 0;
+  if (description)
+    {
+      g_auto(GStrv) description_split = g_strsplit (description, " ", -1);
+
+      rank->description_matches = count_matches ((const gchar * const *) description_split, terms);
+    }
+}
+
+void
+cc_search_rank_clear (CcSearchRank *rank)
+{
+  g_clear_pointer (&rank->name, g_free);
+}
+
+/**
+ * cc_search_rank_compare:
+ * @a: a #CcSearchRank
+ * @b: a #CcSearchRank
+ *
+ * Compares two ranks, for sorting panels from the best match to the worst.
+ *
+ * Returns: a negative value if @a is a better match than @b, a positive
+ *   value if it is a worse one, and zero otherwise.
+ */
+gint
+cc_search_rank_compare (gconstpointer a,
+                        gconstpointer b)
+{
+  const CcSearchRank *a_rank = a;
+  const CcSearchRank *b_rank = b;
+
+  /* Panels matching the earliest terms in their names come first */
+  if (a_rank->name_matches != b_rank->name_matches)
+    return a_rank->name_matches > b_rank->name_matches ? -1 : 1;
+
+  /* Then panels matching more keywords */
+  if (a_rank->keyword_matches != b_rank->keyword_matches)
+    return a_rank->keyword_matches > b_rank->keyword_matches ? -1 : 1;
+
+  /* Then panels with a description, matching more description words */
+  if (a_rank->has_description != b_rank->has_description)
+    return a_rank->has_description ? -1 : 1;
+
+  if (a_rank->description_matches != b_rank->description_matches)
+    return a_rank->description_matches > b_rank->description_matches ? -1 : 1;
+
+  return g_strcmp0 (a_rank->name, b_rank->name);
+}
@@ -0,0 +1,52 @@
+/* cc-search-rank.h
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Everything needed to rank a panel for a set of search terms, computed
+ * once per panel. Sorting compares these instead of looking at the panel
+ * strings in each comparison.
+ */
+typedef struct
+{
+  gint      position;
+  gchar    *name;
+  guint64   name_matches;        /* one bit per term, first term is the MSB */
+  gint      keyword_matches;
+  gboolean  has_description;
+  gint      description_matches;
+} CcSearchRank;
+
+void cc_search_rank_init    (CcSearchRank        *rank,
+                             gint                 position,
+                             const gchar         *casefolded_name,
+                             const gchar         *description,
+                             const gchar * const *casefolded_keywords,
+                             gchar              **terms);
+
+void cc_search_rank_clear   (CcSearchRank        *rank);
+
+gint cc_search_rank_compare (gconstpointer        a,
+                             gconstpointer        b);
+
+G_END_DECLS
@@ -22,15 +22,11 @@
 #include "cc-shell-model.h"
 #include "cc-util.h"
 
-#include <string.h>
-
 #include <gio/gdesktopappinfo.h>
 
 struct _CcShellModel
 {
   GtkListStore parent;
-
-  GStrv        sort_terms;
 };
 
 G_DEFINE_TYPE (CcShellModel, cc_shell_model, GTK_TYPE_LIST_STORE)
@@ -49,166 +45,18 @@ sort_by_name (GtkTreeModel *model,
   return g_strcmp0 (a_name, b_name);
 }
 
-static gint
-sort_by_name_with_terms (GtkTreeModel  *model,
-                         GtkTreeIter   *a,
-                         GtkTreeIter   *b,
-                         gchar        **terms)
-{
-  gboolean a_match, b_match;
-  g_autofree gchar *a_name = NULL;
-  g_autofree gchar *b_name = NULL;
-  gint i;
-
-  gtk_tree_model_get (model, a, COL_CASEFOLDED_NAME, &a_name, -1);
-  gtk_tree_model_get (model, b, COL_CASEFOLDED_NAME, &b_name, -1);
-
-  for (i = 0; terms[i]; ++i)
-    {
-      a_match = strstr (a_name, terms[i]) != NULL;
-      b_match = strstr (b_name, terms[i]) != NULL;
-
-      if (a_match && !b_match)
-        return -1;
-      else if (!a_match && b_match)
-        return 1;
-    }
-
-  return 0;
-}
-
-static gint
-count_matches (gchar **keywords,
-               gchar **terms)
-{
-  gint i, j, c;
-
-  if (!keywords || !terms)
-    return 0;
-
-  c = 0;
-
-  for (i = 0; terms[i]; ++i)
-    for (j = 0; keywords[j]; ++j)
-      if (strstr (keywords[j], terms[i]))
-        c += 1;
-
-  return c;
-}
-
-static gint
-sort_by_keywords_with_terms (GtkTreeModel  *model,
-                             GtkTreeIter   *a,
-                             GtkTreeIter   *b,
-                             gchar        **terms)
-{
-  gint a_matches, b_matches;
-  g_auto(GStrv) a_keywords = NULL;
-  g_auto(GStrv) b_keywords = NULL;
-
-  gtk_tree_model_get (model, a, COL_KEYWORDS, &a_keywords, -1);
-  gtk_tree_model_get (model, b, COL_KEYWORDS, &b_keywords, -1);
-
-  a_matches = count_matches (a_keywords, terms);
-  b_matches = count_matches (b_keywords, terms);
-
-  if (a_matches > b_matches)
-    return -1;
-  else if (a_matches < b_matches)
-    return 1;
-
-  return 0;
-}
-
-static gint
-sort_by_description_with_terms (GtkTreeModel  *model,
-                                GtkTreeIter   *a,
-                                GtkTreeIter   *b,
-                                gchar        **terms)
-{
-  gint a_matches, b_matches;
-  g_autofree gchar *a_description = NULL;
-  g_autofree gchar *b_description = NULL;
-  g_auto(GStrv) a_description_split = NULL;
-  g_auto(GStrv) b_description_split = NULL;
-
-  gtk_tree_model_get (model, a, COL_DESCRIPTION, &a_description, -1);
-  gtk_tree_model_get (model, b, COL_DESCRIPTION, &b_description, -1);
-
-  if (a_description && !b_description)
-    return -1;
-  else if (!a_description && b_description)
-    return 1;
-  else if (!a_description && !b_description)
-    return 0;
-
-  a_description_split = g_strsplit (a_description, " ", -1);
-  b_description_split = g_strsplit (b_description, " ", -1);
-
-  a_matches = count_matches (a_description_split, terms);
-  b_matches = count_matches (b_description_split, terms);
-
-  if (a_matches > b_matches)
-    return -1;
-  else if (a_matches < b_matches)
-    return 1;
-
-  return 0;
-}
-
-static gint
-sort_with_terms (GtkTreeModel  *model,
-                 GtkTreeIter   *a,
-                 GtkTreeIter   *b,
-                 gchar        **terms)
-{
-  gint rval;
-
-  rval = sort_by_name_with_terms (model, a, b, terms);
-  if (rval)
-    return rval;
-
-  rval = sort_by_keywords_with_terms (model, a, b, terms);
-  if (rval)
-    return rval;
-
-  rval = sort_by_description_with_terms (model, a, b, terms);
-  if (rval)
-    return rval;
-
-  return sort_by_name (model, a, b);
-}
-
 static gint
 cc_shell_model_sort_func (GtkTreeModel *model,
                           GtkTreeIter  *a,
                           GtkTreeIter  *b,
                           gpointer      data)
 {
-  CcShellModel *self = data;
-
-  if (!self->sort_terms || !self->sort_terms[0])
-    return sort_by_name (model, a, b);
-  else
-    return sort_with_terms (model, a, b, self->sort_terms);
-}
-
-static void
-cc_shell_model_finalize (GObject *object)
-{
-  CcShellModel *self = CC_SHELL_MODEL (object);
-
-  g_clear_pointer (&self->sort_terms, g_strfreev);
-
-  G_OBJECT_CLASS (cc_shell_model_parent_class)->finalize (object);
+  return sort_by_name (model, a, b);
 }
 
 static void
 cc_shell_model_class_init (CcShellModelClass *klass)
 {
-  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
-
-  gobject_class->finalize = cc_shell_model_finalize;
 }
 
 static void
@@ -302,6 +150,50 @@ cc_shell_model_add_item (CcShellModel    *model,
                                      -1);
 }
 
+/**
+ * cc_shell_model_add_item_full:
+ * @model: a #CcShellModel
+ * @category: the category of the panel
+ * @id: the id of the panel
+ * @name: the display name of the panel
+ * @casefolded_name: @name, normalized with cc_util_normalize_casefold_and_unaccent()
+ * @description: (nullable): the description of the panel
+ * @casefolded_description: (nullable): @description, normalized
+ * @icon: (nullable): the (symbolic) icon of the panel
+ * @casefolded_keywords: (nullable): the normalized keywords of the panel
+ * @visibility: the initial visibility of the panel
+ *
+ * Adds a panel whose metadata was already gathered and normalized, e.g.
+ * from the panel metadata cache. Unlike cc_shell_model_add_item(), the
+ * %COL_APP column is left unset.
+ */
+void
+cc_shell_model_add_item_full (CcShellModel        *model,
+                              CcPanelCategory      category,
+                              const char          *id,
+                              const char          *name,
+                              const char          *casefolded_name,
+                              const char          *description,
+                              const char          *casefolded_description,
+                              GIcon               *icon,
+                              const char * const  *casefolded_keywords,
+                              CcPanelVisibility    visibility)
+{
+  g_return_if_fail (CC_IS_SHELL_MODEL (model));
+
+  gtk_list_store_insert_with_values (GTK_LIST_STORE (model), NULL, 0,
+                                     COL_NAME, name,
+                                     COL_CASEFOLDED_NAME, casefolded_name,
+                                     COL_ID, id,
+                                     COL_CATEGORY, category,
+                                     COL_DESCRIPTION, description,
+                                     COL_CASEFOLDED_DESCRIPTION, casefolded_description,
+                                     COL_GICON, icon,
+                                     COL_KEYWORDS, casefolded_keywords,
+                                     COL_VISIBILITY, visibility,
+                                     -1);
+}
+
 gboolean
 cc_shell_model_has_panel (CcShellModel *model,
                           const char   *id)
@@ -326,54 +218,6 @@ cc_shell_model_has_panel (CcShellModel *model,
   return FALSE;
 }
 
-gboolean
-cc_shell_model_iter_matches_search (CcShellModel *model,
-                                    GtkTreeIter  *iter,
-                                    const char   *term)
-{
-  g_autofree gchar *name = NULL;
-  g_autofree gchar *description = NULL;
-  gboolean result;
-  g_auto(GStrv) keywords = NULL;
-
-  gtk_tree_model_get (GTK_TREE_MODEL (model), iter,
-                      COL_CASEFOLDED_NAME, &name,
-                      COL_CASEFOLDED_DESCRIPTION, &description,
-                      COL_KEYWORDS, &keywords,
-                      -1);
-
-  result = (strstr (name, term) != NULL);
-
-  if (!result && description)
-    result = (strstr (description, term) != NULL);
-
-  if (!result && keywords)
-    {
-      gint i;
-
-      for (i = 0; !result && keywords[i]; i++)
-        result = (strstr (keywords[i], term) == keywords[i]);
-    }
-
-  return result;
-}
-
-void
-cc_shell_model_set_sort_terms (CcShellModel  *self,
-                               gchar        **terms)
-{
-  g_return_if_fail (CC_IS_SHELL_MODEL (self));
-
-  g_clear_pointer (&self->sort_terms, g_strfreev);
-  self->sort_terms = g_strdupv (terms);
-
-  /* trigger a re-sort */
-  gtk_tree_sortable_set_default_sort_func (GTK_TREE_SORTABLE (self),
-                                           cc_shell_model_sort_func,
-                                           self,
-                                           NULL);
-}
-
 void
 cc_shell_model_set_panel_visibility (CcShellModel      *self,
                                      const gchar       *id,
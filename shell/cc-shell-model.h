@@ -67,16 +67,20 @@ void          cc_shell_model_add_item            (CcShellModel       *model,
                                                   GAppInfo           *appinfo,
                                                   const char         *id);
 
+void          cc_shell_model_add_item_full       (CcShellModel        *model,
+                                                  CcPanelCategory      category,
+                                                  const char          *id,
+                                                  const char          *name,
+                                                  const char          *casefolded_name,
+                                                  const char          *description,
+                                                  const char          *casefolded_description,
+                                                  GIcon               *icon,
+                                                  const char * const  *casefolded_keywords,
+                                                  CcPanelVisibility    visibility);
+
 gboolean      cc_shell_model_has_panel           (CcShellModel       *model,
                                                   const char         *id);
 
-gboolean      cc_shell_model_iter_matches_search (CcShellModel       *model,
-                                                  GtkTreeIter        *iter,
-                                                  const char         *term);
-
-void          cc_shell_model_set_sort_terms       (CcShellModel      *model,
-                                                   GStrv              terms);
-
 void          cc_shell_model_set_panel_visibility (CcShellModel      *self,
                                                    const gchar       *id,
                                                    CcPanelVisibility  visible);
@@ -40,12 +40,26 @@
 #include "cc-shell-model.h"
 #include "cc-panel-list.h"
 #include "cc-panel-loader.h"
+#include "cc-profiler.h"
 #include "cc-util.h"
 
 #define MOUSE_BACK_BUTTON 8
 
 #define DEFAULT_WINDOW_ICON_NAME "gnome-control-center"
 
+/* Maximum number of panels constructed ahead of time after startup */
+#define N_PREWARM_PANELS 2
+
+/* Seconds before changes to the panel history are written */
+#define PANEL_HISTORY_SAVE_DELAY 10
+
+/* A suspended panel kept around to be shown again */
+typedef struct
+{
+  gchar   *id;
+  CcPanel *panel;
+} CachedPanel;
+
 struct _CcWindow
 {
   AdwApplicationWindow parent;
@@ -56,11 +70,22 @@ struct _CcWindow
   GtkSearchBar      *search_bar;
   GtkSearchEntry    *search_entry;
 
-  GtkWidget  *old_panel;
   GtkWidget  *current_panel;
   char       *current_panel_id;
   GQueue     *previous_panels;
 
+  GQueue     *panel_cache; /* CachedPanel, most recently used first */
+
+  GQueue     *prewarm_queue; /* panel ids, in the order they are constructed */
+  guint       prewarm_id;
+  gboolean    prewarm_scheduled;
+
+  GVariant   *panel_history; /* not written to the settings yet */
+  guint       panel_history_save_id;
+
+  char       *first_frame_panel_id; /* activated panel not drawn yet, when tracing */
+  gint64      first_frame_begin_time;
+
   GtkWidget  *custom_titlebar;
 
   CcShellModel *store;
@@ -111,6 +136,184 @@ in_flatpak_sandbox (void)
   return g_strcmp0 (PROFILE, "development") == 0;
 }
 
+static void
+cached_panel_free (CachedPanel *cached)
+{
+  cc_panel_deactivate (cached->panel);
+
+  g_clear_pointer (&cached->id, g_free);
+  g_clear_object (&cached->panel);
+  g_free (cached);
+}
+
+static void
+trim_panel_cache (CcWindow *self)
+{
+  guint max_panels;
+
+  max_panels = g_settings_get_uint (self->settings, "panel-cache-size");
+
+  /* Evict the least recently used panels first */
+  while (g_queue_get_length (self->panel_cache) > max_panels)
+    {
+      CachedPanel *cached = g_queue_pop_tail (self->panel_cache);
+
+      g_debug ("Evicting panel '%s' from the panel cache", cached->id);
+
+      cached_panel_free (cached);
+    }
+}
+
+static void
+stash_or_deactivate_panel (CcWindow   *self,
+                           const char *id,
+                           CcPanel    *panel)
+{
+  CachedPanel *cached;
+
+  if (!id || !cc_panel_get_cacheable (panel))
+    {
+      cc_panel_deactivate (panel);
+      return;
+    }
+
+  /* The panel isn't deactivated while cached, so that it can be shown
+   * again as it was, but it stops its streams, monitors and timers */
+  cc_panel_suspend (panel);
+
+  cached = g_new0 (CachedPanel, 1);
+  cached->id = g_strdup (id);
+  cached->panel = g_object_ref (panel);
+
+  g_queue_push_head (self->panel_cache, cached);
+
+  g_debug ("Cached panel '%s'", id);
+
+  trim_panel_cache (self);
+}
+
+static CcPanel *
+take_cached_panel (CcWindow   *self,
+                   const char *id)
+{
+  GList *l;
+
+  for (l = self->panel_cache->head; l != NULL; l = l->next)
+    {
+      CachedPanel *cached = l->data;
+      CcPanel *panel;
+
+      if (g_strcmp0 (cached->id, id) != 0)
+        continue;
+
+      g_queue_delete_link (self->panel_cache, l);
+
+      panel = g_steal_pointer (&cached->panel);
+      g_free (cached->id);
+      g_free (cached);
+
+      cc_panel_resume (panel);
+
+      return panel;
+    }
+
+  return NULL;
+}
+
+static GVariant *
+get_panel_history (CcWindow *self)
+{
+  if (self->panel_history)
+    return g_variant_ref (self->panel_history);
+
+  return g_settings_get_value (self->settings, "panel-history");
+}
+
+static void
+save_panel_history (CcWindow *self)
+{
+  g_clear_handle_id (&self->panel_history_save_id, g_source_remove);
+
+  if (!self->panel_history)
+    return;
+
+  g_settings_set_value (self->settings, "panel-history", self->panel_history);
+  g_clear_pointer (&self->panel_history, g_variant_unref);
+}
+
+static gboolean
+save_panel_history_cb (gpointer user_data)
+{
+  CcWindow *self = user_data;
+
+  self->panel_history_save_id = 0;
+  save_panel_history (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Records how often each panel is opened, and how long it takes to
+ * construct it, for the prewarming scheduler. A negative
+ * @construction_time keeps the previously recorded one.
+ *
+ * Changes are written in batches, see save_panel_history().
+ */
+static void
+record_panel_usage (CcWindow   *self,
+                    const char *id,
+                    gdouble     construction_time)
+{
+  g_autoptr(GVariant) history = NULL;
+  GVariantBuilder builder;
+  GVariantIter iter;
+  const gchar *panel_id;
+  gdouble panel_time;
+  guint32 panel_count;
+  guint32 count = 0;
+
+  history = get_panel_history (self);
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(ud)}"));
+
+  g_variant_iter_init (&iter, history);
+  while (g_variant_iter_next (&iter, "{&s(ud)}", &panel_id, &panel_count, &panel_time))
+    {
+      if (g_strcmp0 (panel_id, id) == 0)
+        {
+          count = panel_count;
+          if (construction_time < 0)
+            construction_time = panel_time;
+          continue;
+        }
+
+      g_variant_builder_add (&builder, "{s(ud)}", panel_id, panel_count, panel_time);
+    }
+
+  g_variant_builder_add (&builder, "{s(ud)}", id, count + 1, MAX (construction_time, 0));
+
+  g_clear_pointer (&self->panel_history, g_variant_unref);
+  self->panel_history = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  if (self->panel_history_save_id == 0)
+    self->panel_history_save_id = g_timeout_add_seconds (PANEL_HISTORY_SAVE_DELAY, save_panel_history_cb, self);
+}
+
+static CcPanel *
+construct_panel (CcWindow    *self,
+                 const gchar *id,
+                 const gchar *name,
+                 GVariant    *parameters)
+{
+  CcPanel *panel;
+  gint64 begin_time;
+
+  begin_time = CC_PROFILER_CURRENT_TIME;
+  panel = g_object_ref_sink (cc_panel_loader_load_by_name (CC_SHELL (self), id, name, parameters));
+
+  cc_profiler_end_mark (begin_time, "Construct panel", "%s", id);
+
+  return panel;
+}
+
 static gboolean
 activate_panel (CcWindow          *self,
                 const gchar       *id,
@@ -120,7 +323,10 @@ activate_panel (CcWindow          *self,
                 CcPanelVisibility  visibility)
 {
   g_autoptr(GTimer) timer = NULL;
+  g_autoptr(CcPanel) panel = NULL;
+  gboolean reused = FALSE;
   gdouble elapsed_time;
+  gint64 begin_time;
 
   CC_ENTRY;
 
@@ -134,13 +340,34 @@ activate_panel (CcWindow          *self,
 
   /* Begin the profile */
   g_timer_start (timer);
+  begin_time = CC_PROFILER_CURRENT_TIME;
 
   if (self->current_panel)
-    g_signal_handlers_disconnect_by_data (self->current_panel, self);
-  self->current_panel = GTK_WIDGET (cc_panel_loader_load_by_name (CC_SHELL (self), id, name, parameters));
-  cc_shell_set_active_panel (CC_SHELL (self), CC_PANEL (self->current_panel));
+    {
+      g_signal_handlers_disconnect_by_data (self->current_panel, self);
+      stash_or_deactivate_panel (self, self->current_panel_id, CC_PANEL (self->current_panel));
+    }
+
+  panel = take_cached_panel (self, id);
+
+  if (panel)
+    {
+      g_debug ("Reusing cached panel '%s'", id);
+      g_object_set (panel,
+                    "title", name,
+                    "parameters", parameters,
+                    NULL);
+      reused = TRUE;
+    }
+  else
+    {
+      panel = construct_panel (self, id, name, parameters);
+    }
 
-  adw_navigation_split_view_set_content (self->split_view, ADW_NAVIGATION_PAGE (self->current_panel));
+  self->current_panel = GTK_WIDGET (panel);
+  cc_shell_set_active_panel (CC_SHELL (self), panel);
+
+  adw_navigation_split_view_set_content (self->split_view, ADW_NAVIGATION_PAGE (panel));
 
   /* Finish profiling */
   g_timer_stop (timer);
@@ -149,6 +376,17 @@ activate_panel (CcWindow          *self,
 
   g_debug ("Time to open panel '%s': %lfs", name, elapsed_time);
 
+  /* Measured up to the next frame, see on_after_paint_cb() */
+  if (cc_profiler_is_running ())
+    {
+      g_free (self->first_frame_panel_id);
+      self->first_frame_panel_id = g_strdup (id);
+      self->first_frame_begin_time = begin_time;
+    }
+
+  /* Only constructions tell how slow a panel is to open */
+  record_panel_usage (self, id, reused ? -1 : elapsed_time);
+
   g_settings_set_string (self->settings, "last-panel", id);
 
   CC_RETURN (TRUE);
@@ -198,6 +436,225 @@ find_iter_for_panel_id (CcWindow    *self,
   return valid;
 }
 
+/* Prewarming */
+typedef struct
+{
+  gchar   *id;
+  gdouble  likelihood;
+  gdouble  construction_time;
+} PrewarmCandidate;
+
+static void
+prewarm_candidate_clear (PrewarmCandidate *candidate)
+{
+  g_clear_pointer (&candidate->id, g_free);
+}
+
+static gint
+compare_candidates_by_likelihood (gconstpointer a,
+                                  gconstpointer b)
+{
+  const PrewarmCandidate *a_candidate = a;
+  const PrewarmCandidate *b_candidate = b;
+
+  if (a_candidate->likelihood != b_candidate->likelihood)
+    return a_candidate->likelihood > b_candidate->likelihood ? -1 : 1;
+
+  return 0;
+}
+
+static gint
+compare_candidates_by_construction_time (gconstpointer a,
+                                         gconstpointer b)
+{
+  const PrewarmCandidate *a_candidate = a;
+  const PrewarmCandidate *b_candidate = b;
+
+  if (a_candidate->construction_time != b_candidate->construction_time)
+    return a_candidate->construction_time > b_candidate->construction_time ? -1 : 1;
+
+  return 0;
+}
+
+static gboolean
+is_panel_cached (CcWindow   *self,
+                 const char *id)
+{
+  GList *l;
+
+  for (l = self->panel_cache->head; l != NULL; l = l->next)
+    {
+      CachedPanel *cached = l->data;
+
+      if (g_strcmp0 (cached->id, id) == 0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+should_prewarm_panel (CcWindow   *self,
+                      const char *id)
+{
+  CcPanelVisibility visibility;
+  GtkTreeIter iter;
+
+  if (g_strcmp0 (id, self->current_panel_id) == 0 || is_panel_cached (self, id))
+    return FALSE;
+
+  /* Panels which can't be cached would be thrown away right after
+   * being constructed, and may not be safe to keep idle */
+  if (!cc_panel_loader_get_cacheable (id))
+    return FALSE;
+
+  if (!find_iter_for_panel_id (self, id, &iter))
+    return FALSE;
+
+  gtk_tree_model_get (GTK_TREE_MODEL (self->store), &iter, COL_VISIBILITY, &visibility, -1);
+
+  return visibility == CC_PANEL_VISIBLE;
+}
+
+static gboolean
+prewarm_step_cb (gpointer user_data)
+{
+  g_autofree gchar *name = NULL;
+  g_autofree gchar *id = NULL;
+  g_autoptr(GTimer) timer = NULL;
+  g_autoptr(CcPanel) panel = NULL;
+  CcWindow *self = user_data;
+  GtkTreeIter iter;
+
+  id = g_queue_pop_head (self->prewarm_queue);
+
+  /* The user may have opened the panel in the meantime */
+  if (id && should_prewarm_panel (self, id) && find_iter_for_panel_id (self, id, &iter))
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (self->store), &iter, COL_NAME, &name, -1);
+
+      timer = g_timer_new ();
+      panel = construct_panel (self, id, name, NULL);
+      g_timer_stop (timer);
+
+      g_debug ("Prewarmed panel '%s' in %lfs", id, g_timer_elapsed (timer, NULL));
+
+      stash_or_deactivate_panel (self, id, panel);
+    }
+
+  /* Construct one panel per iteration, to let input be handled in between */
+  if (g_queue_is_empty (self->prewarm_queue))
+    {
+      self->prewarm_id = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+schedule_prewarm (CcWindow *self)
+{
+  g_autoptr(GVariant) history = NULL;
+  g_autoptr(GArray) candidates = NULL;
+  g_autofree gchar *last_panel = NULL;
+  gboolean has_last_panel = FALSE;
+  GVariantIter iter;
+  const gchar *id;
+  gdouble construction_time;
+  guint32 count;
+  guint32 total = 0;
+  guint n_panels;
+  guint i;
+
+  n_panels = MIN (N_PREWARM_PANELS, g_settings_get_uint (self->settings, "panel-cache-size"));
+  if (n_panels == 0)
+    return;
+
+  candidates = g_array_new (FALSE, TRUE, sizeof (PrewarmCandidate));
+  g_array_set_clear_func (candidates, (GDestroyNotify) prewarm_candidate_clear);
+
+  last_panel = g_settings_get_string (self->settings, "last-panel");
+  history = get_panel_history (self);
+
+  g_variant_iter_init (&iter, history);
+  while (g_variant_iter_next (&iter, "{&s(ud)}", &id, &count, &construction_time))
+    {
+      PrewarmCandidate candidate = { g_strdup (id), count, construction_time };
+
+      g_array_append_val (candidates, candidate);
+      total += count;
+    }
+
+  /* The last used panel is the most likely one, unless it is already open */
+  for (i = 0; i < candidates->len; i++)
+    {
+      PrewarmCandidate *candidate = &g_array_index (candidates, PrewarmCandidate, i);
+
+      if (g_strcmp0 (candidate->id, last_panel) == 0)
+        {
+          candidate->likelihood += total + 1;
+          has_last_panel = TRUE;
+        }
+    }
+
+  if (!has_last_panel && last_panel && *last_panel != '\0')
+    {
+      PrewarmCandidate candidate = { g_strdup (last_panel), total + 1, 0 };
+
+      g_array_append_val (candidates, candidate);
+    }
+
+  /* Drop candidates that can't or needn't be constructed */
+  for (i = candidates->len; i > 0; i--)
+    {
+      PrewarmCandidate *candidate = &g_array_index (candidates, PrewarmCandidate, i - 1);
+
+      if (!should_prewarm_panel (self, candidate->id))
+        g_array_remove_index (candidates, i - 1);
+    }
+
+  /* Pick the most likely panels, and construct the slowest ones first */
+  g_array_sort (candidates, compare_candidates_by_likelihood);
+  if (candidates->len > n_panels)
+    g_array_set_size (candidates, n_panels);
+  g_array_sort (candidates, compare_candidates_by_construction_time);
+
+  for (i = 0; i < candidates->len; i++)
+    {
+      PrewarmCandidate *candidate = &g_array_index (candidates, PrewarmCandidate, i);
+
+      g_debug ("Scheduling prewarming of panel '%s' (%lfs to construct)",
+               candidate->id, candidate->construction_time);
+
+      g_queue_push_tail (self->prewarm_queue, g_steal_pointer (&candidate->id));
+    }
+
+  if (!g_queue_is_empty (self->prewarm_queue))
+    self->prewarm_id = g_idle_add_full (G_PRIORITY_LOW, prewarm_step_cb, self, NULL);
+}
+
+static void
+on_first_frame_cb (CcWindow      *self,
+                   GdkFrameClock *frame_clock)
+{
+  g_signal_handlers_disconnect_by_func (frame_clock, on_first_frame_cb, self);
+
+  schedule_prewarm (self);
+}
+
+static void
+on_after_paint_cb (CcWindow      *self,
+                   GdkFrameClock *frame_clock)
+{
+  if (!self->first_frame_panel_id)
+    return;
+
+  cc_profiler_end_mark (self->first_frame_begin_time, "Panel first frame", "%s", self->first_frame_panel_id);
+
+  g_clear_pointer (&self->first_frame_panel_id, g_free);
+}
+
 static void
 on_row_changed_cb (CcWindow     *self,
                    GtkTreePath  *path,
@@ -311,10 +768,6 @@ set_active_panel_from_id (CcWindow     *self,
       CC_RETURN (TRUE);
     }
 
-  self->old_panel = self->current_panel;
-  if (self->old_panel)
-    cc_panel_deactivate (CC_PANEL (self->old_panel));
-
   gtk_tree_model_get (GTK_TREE_MODEL (self->store),
                       &iter,
                       COL_NAME, &name,
@@ -545,6 +998,22 @@ cc_window_map (GtkWidget *widget)
 
   GTK_WIDGET_CLASS (cc_window_parent_class)->map (widget);
 
+  /* Construct the panels most likely to be opened next, once the
+   * window has been drawn for the first time */
+  if (!self->prewarm_scheduled)
+    {
+      GdkFrameClock *frame_clock = gtk_widget_get_frame_clock (widget);
+
+      self->prewarm_scheduled = TRUE;
+
+      if (frame_clock)
+        g_signal_connect_object (frame_clock, "after-paint", G_CALLBACK (on_first_frame_cb), self, G_CONNECT_SWAPPED);
+
+      /* Time from activating a panel until it is drawn */
+      if (frame_clock && cc_profiler_is_running ())
+        g_signal_connect_object (frame_clock, "after-paint", G_CALLBACK (on_after_paint_cb), self, G_CONNECT_SWAPPED);
+    }
+
   /* Show a warning for Flatpak builds */
   if (in_flatpak_sandbox () && g_settings_get_boolean (self->settings, "show-development-warning"))
     adw_dialog_present (self->development_warning_dialog, GTK_WIDGET (self));
@@ -568,6 +1037,8 @@ cc_window_unmap (GtkWidget *widget)
                   height,
                   maximized);
 
+  save_panel_history (self);
+
   GTK_WIDGET_CLASS (cc_window_parent_class)->unmap (widget);
 }
 
@@ -667,9 +1138,27 @@ cc_window_dispose (GObject *object)
   CcWindow *self = CC_WINDOW (object);
 
   g_clear_pointer (&self->current_panel_id, g_free);
+  g_clear_pointer (&self->first_frame_panel_id, g_free);
   g_clear_object (&self->store);
   g_clear_object (&self->active_panel);
 
+  g_clear_handle_id (&self->prewarm_id, g_source_remove);
+
+  if (self->settings)
+    save_panel_history (self);
+
+  if (self->prewarm_queue)
+    {
+      g_queue_free_full (self->prewarm_queue, g_free);
+      self->prewarm_queue = NULL;
+    }
+
+  if (self->panel_cache)
+    {
+      g_queue_free_full (self->panel_cache, (GDestroyNotify) cached_panel_free);
+      self->panel_cache = NULL;
+    }
+
   G_OBJECT_CLASS (cc_window_parent_class)->dispose (object);
 }
 
@@ -777,6 +1266,8 @@ cc_window_init (CcWindow *self)
 
   self->settings = g_settings_new ("org.gnome.Settings");
   self->previous_panels = g_queue_new ();
+  self->panel_cache = g_queue_new ();
+  self->prewarm_queue = g_queue_new ();
   self->previous_list_view = cc_panel_list_get_view (self->panel_list);
 
   /* Add a custom CSS class on development builds */
@@ -0,0 +1,251 @@
+/* benchmark-background-thumbnails.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measures the time and peak memory needed to create the thumbnails of
+ * every image of a directory, as the background chooser does:
+ *
+ *   benchmark-background-thumbnails [DIRECTORY]
+ *
+ * The directory can also be passed with BACKGROUND_BENCHMARK_DIR. Without
+ * one, large JPEG images are generated in a temporary directory. Thumbnails
+ * are never loaded from a cache, as XDG_CACHE_HOME is set to a temporary
+ * directory too.
+ */
+
+#include "config.h"
+
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <libgnome-desktop/gnome-desktop-thumbnail.h>
+#include <sys/resource.h>
+
+#include "cc-background-item.h"
+
+#define N_SAMPLES 8
+#define SAMPLE_WIDTH 6000
+#define SAMPLE_HEIGHT 4000
+
+#define THUMBNAIL_WIDTH 300
+#define THUMBNAIL_HEIGHT 169
+#define THUMBNAIL_SCALE 2
+
+static glong
+get_peak_rss_kb (void)
+{
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    return -1;
+
+  /* In kilobytes on Linux */
+  return usage.ru_maxrss;
+}
+
+/* Runs in a child process, so that its memory isn't measured */
+static int
+generate_samples (const gchar *dir)
+{
+  guint i;
+
+  for (i = 0; i < N_SAMPLES; i++)
+    {
+      g_autoptr(GdkPixbuf) pixbuf = NULL;
+      g_autoptr(GError) error = NULL;
+      g_autofree gchar *basename = NULL;
+      g_autofree gchar *path = NULL;
+      guchar *pixels;
+      gint rowstride;
+      gint x, y;
+
+      pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, SAMPLE_WIDTH, SAMPLE_HEIGHT);
+      pixels = gdk_pixbuf_get_pixels (pixbuf);
+      rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+      for (y = 0; y < SAMPLE_HEIGHT; y++)
+        {
+          guchar *p = pixels + y * rowstride;
+
+          for (x = 0; x < SAMPLE_WIDTH; x++, p += 3)
+            {
+              p[0] = (x * 255 / SAMPLE_WIDTH + i * 32) & 0xff;
+              p[1] = y * 255 / SAMPLE_HEIGHT;
+              p[2] = ((x ^ y) >> 4) & 0xff;
+            }
+        }
+
+      basename = g_strdup_printf ("sample-%u.jpg", i);
+      path = g_build_filename (dir, basename, NULL);
+
+      if (!gdk_pixbuf_save (pixbuf, path, "jpeg", &error, "quality", "90", NULL))
+        {
+          g_printerr ("Failed to save %s: %s\n", path, error->message);
+          return 1;
+        }
+    }
+
+  return 0;
+}
+
+static gboolean
+spawn_generate_samples (const gchar  *argv0,
+                        const gchar  *dir,
+                        GError      **error)
+{
+  const gchar *argv[] = { argv0, "--generate", dir, NULL };
+  gint status;
+
+  if (!g_spawn_sync (NULL, (gchar **) argv, NULL, G_SPAWN_DEFAULT,
+                     NULL, NULL, NULL, NULL, &status, error))
+    return FALSE;
+
+  return g_spawn_check_wait_status (status, error);
+}
+
+static void
+remove_tree (const gchar *path)
+{
+  g_autoptr(GDir) dir = NULL;
+  const gchar *name;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          g_autofree gchar *child = g_build_filename (path, name, NULL);
+
+          if (g_file_test (child, G_FILE_TEST_IS_DIR))
+            remove_tree (child);
+          else
+            g_unlink (child);
+        }
+    }
+
+  g_rmdir (path);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_autoptr(GnomeDesktopThumbnailFactory) factory = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GDir) dir = NULL;
+  g_autofree gchar *cache_dir = NULL;
+  g_autofree gchar *samples_dir = NULL;
+  const gchar *images_dir;
+  const gchar *name;
+  gint64 total_time = 0;
+  guint n_images = 0;
+
+  if (argc == 3 && g_str_equal (argv[1], "--generate"))
+    return generate_samples (argv[2]);
+
+  /* Must be done before anything calls g_get_user_cache_dir() */
+  cache_dir = g_dir_make_tmp ("background-benchmark-cache-XXXXXX", &error);
+  if (!cache_dir)
+    {
+      g_printerr ("Failed to create cache directory: %s\n", error->message);
+      return 1;
+    }
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  if (!gtk_init_check ())
+    {
+      g_print ("No display, skipping\n");
+      remove_tree (cache_dir);
+      return 77;
+    }
+
+  images_dir = argc > 1 ? argv[1] : g_getenv ("BACKGROUND_BENCHMARK_DIR");
+  if (!images_dir)
+    {
+      samples_dir = g_dir_make_tmp ("background-benchmark-XXXXXX", &error);
+      if (!samples_dir || !spawn_generate_samples (argv[0], samples_dir, &error))
+        {
+          g_printerr ("Failed to generate samples: %s\n", error->message);
+          remove_tree (cache_dir);
+          return 1;
+        }
+      images_dir = samples_dir;
+    }
+
+  dir = g_dir_open (images_dir, 0, &error);
+  if (!dir)
+    {
+      g_printerr ("Failed to open %s: %s\n", images_dir, error->message);
+      return 1;
+    }
+
+  factory = gnome_desktop_thumbnail_factory_new (GNOME_DESKTOP_THUMBNAIL_SIZE_LARGE);
+
+  g_print ("Peak RSS before: %ld kB\n", get_peak_rss_kb ());
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      g_autoptr(CcBackgroundItem) item = NULL;
+      g_autoptr(GdkPixbuf) pixbuf = NULL;
+      g_autofree gchar *path = NULL;
+      g_autofree gchar *uri = NULL;
+      gint64 start, elapsed;
+
+      path = g_build_filename (images_dir, name, NULL);
+      uri = g_filename_to_uri (path, NULL, NULL);
+
+      item = cc_background_item_new (uri);
+      g_object_set (item, "placement", G_DESKTOP_BACKGROUND_STYLE_ZOOM, NULL);
+
+      start = g_get_monotonic_time ();
+
+      if (!cc_background_item_load (item, NULL))
+        continue;
+
+      pixbuf = cc_background_item_get_thumbnail (item,
+                                                 factory,
+                                                 THUMBNAIL_WIDTH,
+                                                 THUMBNAIL_HEIGHT,
+                                                 THUMBNAIL_SCALE,
+                                                 FALSE);
+      elapsed = g_get_monotonic_time () - start;
+
+      if (!pixbuf)
+        {
+          g_printerr ("No thumbnail for %s\n", path);
+          continue;
+        }
+
+      g_print ("%-40s %8.1f ms  peak RSS %ld kB\n",
+               name, elapsed / 1000.0, get_peak_rss_kb ());
+
+      total_time += elapsed;
+      n_images++;
+    }
+
+  if (n_images > 0)
+    g_print ("%u images: %.1f ms in total, %.1f ms per image, peak RSS %ld kB\n",
+             n_images,
+             total_time / 1000.0,
+             total_time / 1000.0 / n_images,
+             get_peak_rss_kb ());
+
+  if (samples_dir)
+    remove_tree (samples_dir);
+  remove_tree (cache_dir);
+
+  return n_images > 0 ? 0 : 1;
+}
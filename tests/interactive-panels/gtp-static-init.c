@@ -28,9 +28,17 @@ struct _GtpStaticInit
 G_DEFINE_TYPE (GtpStaticInit, gtp_static_init, CC_TYPE_PANEL)
 
 void
-gtp_static_init_func (void)
+gtp_static_init_func (GCancellable        *cancellable,
+                      GAsyncReadyCallback  callback,
+                      gpointer             user_data)
 {
+  g_autoptr(GTask) task = NULL;
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+
   g_message ("GtpStaticInit: running outside the panel instance");
+
+  g_task_return_boolean (task, TRUE);
 }
 
 static void
@@ -27,6 +27,8 @@ G_BEGIN_DECLS
 #define GTP_TYPE_STATIC_INIT (gtp_static_init_get_type())
 G_DECLARE_FINAL_TYPE (GtpStaticInit, gtp_static_init, GTP, STATIC_INIT, CcPanel)
 
-void gtp_static_init_func (void);
+void gtp_static_init_func (GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data);
 
 G_END_DECLS
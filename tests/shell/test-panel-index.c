@@ -0,0 +1,153 @@
+/* test-panel-index.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <locale.h>
+
+#include "shell/cc-panel-index.h"
+#include "shell/cc-panel-metadata-cache.h"
+
+static void
+add_entry (GVariantBuilder     *builder,
+           const gchar         *id,
+           const gchar         *name,
+           const gchar         *description,
+           const gchar * const *keywords)
+{
+  g_autofree gchar *casefolded_description = g_utf8_casefold (description, -1);
+  g_autofree gchar *casefolded_name = g_utf8_casefold (name, -1);
+
+  g_variant_builder_add (builder, "(suusssss^as)",
+                         id,
+                         0,
+                         2,
+                         name,
+                         casefolded_name,
+                         description,
+                         casefolded_description,
+                         "preferences-system",
+                         keywords);
+}
+
+static CcPanelIndex *
+create_index (void)
+{
+  const gchar *sound_keywords[] = { "card", "microphone", "volume", NULL };
+  const gchar *display_keywords[] = { "night light", "resolution", NULL };
+  const gchar *power_keywords[] = { "battery", "suspend", "display", NULL };
+  GVariantBuilder builder;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (CC_PANEL_METADATA_ENTRIES_FORMAT));
+  add_entry (&builder, "sound", "Sound", "Change sound levels, inputs, outputs, and alert sounds", sound_keywords);
+  add_entry (&builder, "display", "Displays", "Choose how to use connected monitors and projectors", display_keywords);
+  add_entry (&builder, "power", "Power", "View your battery status and change power saving settings", power_keywords);
+
+  return cc_panel_index_new (g_variant_builder_end (&builder));
+}
+
+static void
+test_search (void)
+{
+  g_autoptr(CcPanelIndex) index = create_index ();
+  gchar *micro_terms[] = { "micro", NULL };
+  gchar *phone_terms[] = { "phone", NULL };
+  gchar *two_terms[] = { "battery", "power", NULL };
+  g_auto(GStrv) results = NULL;
+
+  g_assert_cmpuint (cc_panel_index_get_n_panels (index), ==, 3);
+
+  /* Keywords only match as prefixes */
+  results = cc_panel_index_search (index, micro_terms, NULL);
+  g_assert_cmpuint (g_strv_length (results), ==, 1);
+  g_assert_cmpstr (results[0], ==, "sound");
+  g_clear_pointer (&results, g_strfreev);
+
+  results = cc_panel_index_search (index, phone_terms, NULL);
+  g_assert_cmpuint (g_strv_length (results), ==, 0);
+  g_clear_pointer (&results, g_strfreev);
+
+  /* All terms must match */
+  results = cc_panel_index_search (index, two_terms, NULL);
+  g_assert_cmpuint (g_strv_length (results), ==, 1);
+  g_assert_cmpstr (results[0], ==, "power");
+}
+
+static void
+test_rank (void)
+{
+  g_autoptr(CcPanelIndex) index = create_index ();
+  gchar *terms[] = { "display", NULL };
+  g_auto(GStrv) results = NULL;
+
+  /* Name matches come before keyword matches */
+  results = cc_panel_index_search (index, terms, NULL);
+  g_assert_cmpuint (g_strv_length (results), ==, 2);
+  g_assert_cmpstr (results[0], ==, "display");
+  g_assert_cmpstr (results[1], ==, "power");
+}
+
+static void
+test_candidates (void)
+{
+  g_autoptr(CcPanelIndex) index = create_index ();
+  gchar *candidates[] = { "power", "unknown", NULL };
+  gchar *terms[] = { "display", NULL };
+  g_auto(GStrv) results = NULL;
+
+  results = cc_panel_index_search (index, terms, candidates);
+  g_assert_cmpuint (g_strv_length (results), ==, 1);
+  g_assert_cmpstr (results[0], ==, "power");
+}
+
+static void
+test_result_meta (void)
+{
+  g_autoptr(CcPanelIndex) index = create_index ();
+  const gchar *value;
+  GVariant *meta;
+
+  g_assert_null (cc_panel_index_get_result_meta (index, "unknown"));
+
+  meta = cc_panel_index_get_result_meta (index, "sound");
+  g_assert_nonnull (meta);
+  g_assert_true (meta == cc_panel_index_get_result_meta (index, "sound"));
+
+  g_assert_true (g_variant_lookup (meta, "id", "&s", &value));
+  g_assert_cmpstr (value, ==, "gnome-sound-panel.desktop");
+  g_assert_true (g_variant_lookup (meta, "name", "&s", &value));
+  g_assert_cmpstr (value, ==, "Sound");
+  g_assert_true (g_variant_lookup (meta, "icon", "*", NULL));
+}
+
+int
+main (int argc, char **argv)
+{
+  setlocale (LC_ALL, "");
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/shell/panel-index/search", test_search);
+  g_test_add_func ("/shell/panel-index/rank", test_rank);
+  g_test_add_func ("/shell/panel-index/candidates", test_candidates);
+  g_test_add_func ("/shell/panel-index/result-meta", test_result_meta);
+
+  return g_test_run ();
+}
@@ -0,0 +1,144 @@
+/* test-search-index.c
+ *
+ * Copyright (C) 2026 The GNOME Settings contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <locale.h>
+
+#include "shell/cc-search-index.h"
+
+static CcSearchIndex *
+create_index (void)
+{
+  const gchar *sound_keywords[] = { "Card", "Microphone", "Volume", NULL };
+  const gchar *display_keywords[] = { "Night Light", "Resolution", NULL };
+  const gchar *power_keywords[] = { "Battery", "Suspend", NULL };
+  CcSearchIndex *index;
+
+  index = cc_search_index_new ();
+
+  g_assert_cmpuint (cc_search_index_add (index, "Sound", "Change sound levels, inputs, outputs, and alert sounds", sound_keywords), ==, 0);
+  g_assert_cmpuint (cc_search_index_add (index, "Displays", "Choose how to use connected monitors and projectors", display_keywords), ==, 1);
+  g_assert_cmpuint (cc_search_index_add (index, "Power", "View your battery status and change power saving settings", power_keywords), ==, 2);
+  g_assert_cmpuint (cc_search_index_add (index, "Région", NULL, NULL), ==, 3);
+
+  return index;
+}
+
+static void
+test_empty_query (void)
+{
+  g_autoptr(CcSearchIndex) index = create_index ();
+  guint i;
+
+  for (i = 0; i < cc_search_index_get_n_entries (index); i++)
+    g_assert_true (cc_search_index_entry_matches (index, i));
+
+  cc_search_index_set_query (index, "   ");
+  g_assert_false (cc_search_index_has_query (index));
+
+  for (i = 0; i < cc_search_index_get_n_entries (index); i++)
+    g_assert_true (cc_search_index_entry_matches (index, i));
+
+  /* Without a query, entries are sorted by name */
+  g_assert_cmpint (cc_search_index_compare_entries (index, 1, 0), <, 0);
+}
+
+static void
+test_substring (void)
+{
+  g_autoptr(CcSearchIndex) index = create_index ();
+
+  /* Name and description match anywhere */
+  cc_search_index_set_query (index, "ound");
+  g_assert_true (cc_search_index_entry_matches (index, 0));
+  g_assert_false (cc_search_index_entry_matches (index, 1));
+
+  cc_search_index_set_query (index, "projector");
+  g_assert_false (cc_search_index_entry_matches (index, 0));
+  g_assert_true (cc_search_index_entry_matches (index, 1));
+
+  /* Accents and case are ignored */
+  cc_search_index_set_query (index, "REGION");
+  g_assert_true (cc_search_index_entry_matches (index, 3));
+}
+
+static void
+test_keywords (void)
+{
+  g_autoptr(CcSearchIndex) index = create_index ();
+
+  /* Keywords only match as prefixes */
+  cc_search_index_set_query (index, "micro");
+  g_assert_true (cc_search_index_entry_matches (index, 0));
+
+  cc_search_index_set_query (index, "phone");
+  g_assert_false (cc_search_index_entry_matches (index, 0));
+
+  cc_search_index_set_query (index, "night");
+  g_assert_true (cc_search_index_entry_matches (index, 1));
+  g_assert_false (cc_search_index_entry_matches (index, 2));
+}
+
+static void
+test_all_terms (void)
+{
+  g_autoptr(CcSearchIndex) index = create_index ();
+
+  cc_search_index_set_query (index, "battery  power");
+  g_assert_true (cc_search_index_has_query (index));
+  g_assert_false (cc_search_index_entry_matches (index, 0));
+  g_assert_true (cc_search_index_entry_matches (index, 2));
+
+  cc_search_index_set_query (index, "battery sound");
+  g_assert_false (cc_search_index_entry_matches (index, 0));
+  g_assert_false (cc_search_index_entry_matches (index, 2));
+}
+
+static void
+test_score (void)
+{
+  g_autoptr(CcSearchIndex) index = create_index ();
+
+  cc_search_index_set_query (index, "o");
+  g_assert_cmpint (cc_search_index_entry_get_score (index, 0), ==, 1);
+  g_assert_cmpint (cc_search_index_entry_get_score (index, 2), ==, 1);
+  g_assert_cmpint (cc_search_index_entry_get_score (index, 3), ==, 4);
+  g_assert_cmpint (cc_search_index_compare_entries (index, 0, 3), <, 0);
+
+  cc_search_index_set_query (index, "monitor");
+  g_assert_cmpint (cc_search_index_entry_get_score (index, 1), ==, G_MAXINT);
+}
+
+int
+main (int argc, char **argv)
+{
+  setlocale (LC_ALL, "");
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/shell/search-index/empty-query", test_empty_query);
+  g_test_add_func ("/shell/search-index/substring", test_substring);
+  g_test_add_func ("/shell/search-index/keywords", test_keywords);
+  g_test_add_func ("/shell/search-index/all-terms", test_all_terms);
+  g_test_add_func ("/shell/search-index/score", test_score);
+
+  return g_test_run ();
+}